@@ -0,0 +1,347 @@
+// ------------------------------------------------------------------------- //
+// Argument and String Benchmark                                             //
+// ------------------------------------------------------------------------- //
+/**@file    ARGUMENTS.CPP
+ * @brief   Times the argument parsing and string helpers every shim runs
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Usage: arguments [--save FILE] [--check FILE [--tolerance PCT]]
+ *
+ * Times ParseArguments, CollapseArguments, ReparseArguments, each GetArgument
+ * overload, GetSettingArgument, UnquoteString, TrimQuotes, UpperCase,
+ * NarrowString, a wide string LOG (printWString) and each path of
+ * EncodeUtf8 the CPU runs (of UTF-16, as on Windows, into one buffer) over:
+ *
+ *  realistic       a typical shim command line
+ *  flags           1024 short flags
+ *  32k             a 32K character line of words and quoted arguments
+ *  token_8k        one 8K character argument
+ *  escaped         quotes escaped within quotes eight levels deep
+ *  unicode         32K characters of mixed scripts and emoji
+ *
+ * Each case is run for at least 20 ms, five times, and the median time per
+ * call (ns) is reported. Those of GetArgument and the helpers changing their
+ * input include copying it first.
+ *
+ * --save writes the times to FILE (JSON, one "case": ns pair each) as the
+ * baseline. --check compares them against a baseline and fails if any case
+ * is more than PCT (default 25) percent slower, even when timed again.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <functional>
+#include "bench.h"
+#include <log.h>
+#include <get_argument.h>
+#include <utility_functions.h>
+#include <utf8.h>
+
+#define MIN_RUN_NS      20e6
+#define REPEATS         5
+#define RETRIES         3
+
+volatile size_t sink;                   // keeps results from being optimized
+
+
+// ------------------------------- Inputs ---------------------------------- //
+wstring Realistic() {
+  return L"\"C:\\Program Files\\Python 3\\python.exe\" -u -m pip install "
+    L"--upgrade \"some package\" --index-url=https://example.com/simple "
+    L"--shim-NoOp --shim-LogLevel 3 --env PYTHONUTF8=1";
+}
+
+wstring Flags() {
+  wstring line = L"tool.exe";
+  for (int i = 0; i < 1024; i++)
+    line += wstring(L" -") + wchar_t(L'a' + i % 26);
+  return line;
+}
+
+wstring Long() {
+  wstring line = L"tool.exe";
+  for (int i = 0; line.size() < 32768 - 32; i++)
+    line += i % 4 ? L" word" + to_wstring(i) : L" \"quoted arg\"";
+  return line;
+}
+
+wstring Token() {
+  return L"tool.exe \"" + wstring(8192, L'x') + L"\" --shim-Exit";
+}
+
+// "\"x\"" nested LEVELS deep, escaping the backslashes and quotes each level
+wstring Escaped(int levels = 8) {
+  wstring arg = L"x y";
+  for (int level = 0; level < levels; level++) {
+    wstring quoted = L"\"";
+    size_t  slashes = 0;
+    for (wchar_t c : arg) {
+      if (c == L'\\')
+        slashes++;
+      else {
+        if (c == L'"')
+          quoted.append(slashes + 1, L'\\');
+        slashes = 0;
+      }
+      quoted += c;
+    }
+    arg = quoted + wstring(slashes, L'\\') + L"\"";
+  }
+  return L"tool.exe " + arg + L" --shim-Exit";
+}
+
+wstring Unicode() {
+  const wchar_t* parts[] = {L"ascii ", L"\u00e9t\u00e9 ", L"\u65e5\u672c ",
+                            L"\U0001F600 ", L"\u0416\u0438 "};
+  wstring text;
+  for (int i = 0; text.size() < 32768; i++)
+    text += parts[i % 5];
+  return text;
+}
+
+
+// ------------------------------- Timing ---------------------------------- //
+struct Case {
+  string                name;
+  function<size_t()>    run;
+};
+
+// Median ns per call of REPEATS runs of at least MIN_RUN_NS each
+double Time(const Case& c) {
+  auto elapsed = [&](size_t calls) {
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < calls; i++)
+      sink = c.run();
+    return chrono::duration<double, nano>(
+        chrono::steady_clock::now() - start).count();
+  };
+
+  size_t calls = 1;
+  while (elapsed(calls) < MIN_RUN_NS)
+    calls *= 2;
+
+  Samples runs;
+  for (int r = 0; r < REPEATS; r++)
+    runs.add(elapsed(calls) / calls);
+  return runs.percentile(50);
+}
+
+
+// ------------------------------ Baseline --------------------------------- //
+bool SaveBaseline(const string& file, const map<string, double>& times) {
+  ofstream out(file);
+  out << "{\n";
+  for (auto it = times.begin(); it != times.end(); ++it)
+    out << "  \"" << it->first << "\": " << (uint64_t)(it->second + 0.5)
+        << (next(it) == times.end() ? "\n" : ",\n");
+  out << "}\n";
+  return (bool)out;
+}
+
+// Reads the "case": ns pairs as written by SAVEBASELINE
+bool LoadBaseline(const string& file, map<string, double>& times) {
+  ifstream in(file);
+  if (!in)
+    return false;
+  string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+  size_t at = 0;
+  while ((at = text.find('"', at)) != string::npos) {
+    size_t end = text.find('"', at + 1);
+    size_t colon = end == string::npos ? end : text.find(':', end);
+    if (colon == string::npos)
+      return false;
+    times[text.substr(at + 1, end - at - 1)] = strtod(&text[colon + 1],
+                                                      nullptr);
+    at = colon;
+  }
+  return true;
+}
+
+
+// Discards everything written to it (for the LOG cases)
+struct NullBuffer : streambuf {
+  int overflow(int c) override { return c; }
+  streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+
+// -------------------------------- Main ----------------------------------- //
+int main(int argc, char* argv[]) {
+  string save, check;
+  double tolerance = 25;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--save") && i + 1 < argc)
+      save = argv[++i];
+    else if (!strcmp(argv[i], "--check") && i + 1 < argc)
+      check = argv[++i];
+    else if (!strcmp(argv[i], "--tolerance") && i + 1 < argc)
+      tolerance = atof(argv[++i]);
+    else {
+      fprintf(stderr, "Usage: %s [--save FILE] [--check FILE "
+              "[--tolerance PCT]]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  map<string, wstring> lines = {
+    {"realistic", Realistic()}, {"flags", Flags()}, {"32k", Long()},
+    {"token_8k", Token()}, {"escaped", Escaped()}};
+  wstring unicode = Unicode();
+  wstring ascii(32768, L'a');
+
+  vector<Case> cases;
+  for (auto& [input, line] : lines) {
+    const wstring&  l    = line;
+    vector<wstring> args = ParseArguments(l);
+    cases.push_back({"ParseArguments/" + input,
+                     [&l] { return ParseArguments(l).size(); }});
+    cases.push_back({"CollapseArguments/" + input,
+                     [args] { return CollapseArguments(args).size(); }});
+    cases.push_back({"ReparseArguments/" + input, [args] {
+      vector<wstring> a = args;
+      ReparseArguments(a);
+      return a.size();
+    }});
+
+    // Arguments the shim itself looks for, mostly not given
+    cases.push_back({"GetArgument(index)/" + input, [args] {
+      vector<wstring> a = args;
+      wstring         value;
+      return (size_t)GetArgument(a, 1, value);
+    }});
+    cases.push_back({"GetArgument(flag)/" + input, [args] {
+      vector<wstring> a = args;
+      return (size_t)GetArgument(a, L"--shim-Exit");
+    }});
+    cases.push_back({"GetArgument(value)/" + input, [args] {
+      vector<wstring> a = args;
+      wstring         value;
+      return (size_t)GetArgument(a, L"--shim-LogLevel", value);
+    }});
+    cases.push_back({"GetSettingArgument/" + input, [args] {
+      vector<wstring> a = args;
+      wstring         value;
+      return (size_t)GetSettingArgument(a, L"--env", value);
+    }});
+    cases.push_back({"UnquoteString/" + input,
+                     [&l] { return UnquoteString(l).size(); }});
+  }
+
+  wstring quoted = L"\"" + Long() + L"\"";
+  cases.push_back({"TrimQuotes/32k", [&quoted] {
+    wstring s = quoted;
+    return (size_t)TrimQuotes(s);
+  }});
+  cases.push_back({"UpperCase/32k", [&ascii] {
+    wstring s = ascii;
+    return (size_t)UpperCase(s);
+  }});
+  cases.push_back({"NarrowString/ascii_32k",
+                   [&ascii] { return NarrowString(ascii).size(); }});
+  cases.push_back({"NarrowString/unicode",
+                   [&unicode] { return NarrowString(unicode).size(); }});
+
+  // UTF-16 as Windows has it, characters past U+FFFF as their pairs
+  auto utf16 = [](const wstring& s) {
+    u16string u;
+    for (wchar_t c : s)
+      if ((uint32_t)c >= 0x10000) {
+        u += (char16_t)(0xD800 + (((uint32_t)c - 0x10000) >> 10));
+        u += (char16_t)(0xDC00 + (((uint32_t)c - 0x10000) & 0x3FF));
+      }
+      else
+        u += (char16_t)c;
+    return u;
+  };
+  static map<string, u16string> texts = {
+    {"ascii_32k", utf16(ascii)}, {"unicode", utf16(unicode)},
+    {"realistic", utf16(lines["realistic"])}};
+  static string buffer;
+  vector<pair<string, Utf8Path>> paths = {{"scalar", UTF8_SCALAR}};
+  if (Utf8Best() != UTF8_SCALAR)
+    paths.push_back({"sse2", UTF8_SSE2});
+  if (Utf8Best() == UTF8_AVX2)
+    paths.push_back({"avx2", UTF8_AVX2});
+  for (auto& [name, path] : paths)
+    for (auto& [input, text] : texts) {
+      const u16string& t = text;
+      Utf8Path         p = path;
+      cases.push_back({"EncodeUtf8(" + name + ")/" + input, [&t, p] {
+        buffer.resize(t.size() * UTF8_MAX_BYTES(char16_t));
+        return EncodeUtf8(t.data(), t.size(), &buffer[0], p);
+      }});
+    }
+
+  // LOG() writes to stderr on POSIX, swallowed here
+  NullBuffer null;
+  streambuf* err = cerr.rdbuf(&null);
+  cases.push_back({"LOG(wstring)/realistic",
+                   [&lines] { LOG() << lines["realistic"]; return 0; }});
+  cases.push_back({"LOG(wstring)/unicode",
+                   [&unicode] { LOG() << unicode; return 0; }});
+
+  map<string, double> baseline;
+  if (!check.empty() && !LoadBaseline(check, baseline)) {
+    fprintf(stderr, "could not read the baseline %s\n", check.c_str());
+    return 1;
+  }
+
+  // A case slower than its baseline is timed again (up to RETRIES times) so
+  // a noisy neighbour does not fail the check
+  map<string, double> times;
+  for (auto& c : cases) {
+    double& ns    = times[c.name] = Time(c);
+    auto    found = baseline.find(c.name);
+    for (int r = 0; r < RETRIES && found != baseline.end() &&
+           ns > found->second * (1 + tolerance / 100); r++)
+      ns = min(ns, Time(c));
+  }
+  cerr.rdbuf(err);
+
+  printf("%-36s %12s %12s %8s\n", "(ns / call)", "now", "baseline",
+         "change");
+  int regressions = 0;
+  for (auto& [name, ns] : times) {
+    auto found = baseline.find(name);
+    if (found == baseline.end() || found->second <= 0) {
+      printf("%-36s %12.0f\n", name.c_str(), ns);
+      continue;
+    }
+    double change = (ns / found->second - 1) * 100;
+    bool   slower = change > tolerance;
+    regressions  += slower;
+    printf("%-36s %12.0f %12.0f %+7.1f%%%s\n", name.c_str(), ns,
+           found->second, change, slower ? "  SLOWER" : "");
+  }
+
+  if (!save.empty() && !SaveBaseline(save, times)) {
+    fprintf(stderr, "could not write the baseline %s\n", save.c_str());
+    return 1;
+  }
+  if (regressions) {
+    fprintf(stderr, "\n%d case(s) more than %.0f%% slower than %s\n",
+            regressions, tolerance, check.c_str());
+    return 1;
+  }
+  return 0;
+}
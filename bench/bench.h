@@ -0,0 +1,171 @@
+// ------------------------------------------------------------------------- //
+// Benchmark Helpers                                                         //
+// ------------------------------------------------------------------------- //
+/**@file    BENCH.H
+ * @brief   Timing and process helpers shared by the benchmarks
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Defines the following:
+ *
+ *  Samples
+ *      collects measurements (e.g. microseconds) and summarizes them as mean
+ *      and percentiles
+ *
+ *  RunProcess
+ *      runs a process to completion with stdout / stderr discarded and
+ *      returns how long it took
+ *
+ *  TempDir
+ *      a scratch directory removed again on exit
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+using namespace std;
+
+
+// -------------------------------- Samples -------------------------------- //
+struct Samples {
+  vector<double> values;
+
+  void add(double value) {
+    values.push_back(value);
+  }
+
+  double mean() const {
+    double total = 0;
+    for (double v : values)
+      total += v;
+    return values.empty() ? 0 : total / values.size();
+  }
+
+  // Nearest rank percentile, P in [0, 100]
+  double percentile(double p) const {
+    if (values.empty())
+      return 0;
+    vector<double> sorted = values;
+    sort(sorted.begin(), sorted.end());
+    size_t rank = (size_t)(p / 100 * sorted.size() + 0.5);
+    return sorted[min(rank > 0 ? rank - 1 : 0, sorted.size() - 1)];
+  }
+
+  void print(const char* name) const {
+    printf("%-20s %8zu %10.0f %10.0f %10.0f %10.0f\n", name, values.size(),
+           mean(), percentile(50), percentile(90), percentile(99));
+  }
+
+  static void header(const char* unit = "(us)") {
+    printf("%-20s %8s %10s %10s %10s %10s\n", unit, "runs", "mean", "p50",
+           "p90", "p99");
+  }
+};
+
+
+// -------------------------------- Process -------------------------------- //
+/**@brief  Run a process to completion, discarding its output
+ *
+ * @param  ARGV:    arguments, ARGV[0] being the path of the executable
+ * @param  ENVP:    environment
+ * @param  STATUS:  exit code (or -1 if it could not be started)
+ *
+ * @return microseconds from spawning it until it was reaped
+ */
+double RunProcess(const vector<string>& args, char* const envp[],
+                  int* status = nullptr) {
+  vector<char*> argv;
+  for (auto& arg : args)
+    argv.push_back((char*)arg.c_str());
+  argv.push_back(nullptr);
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+
+  auto  start = chrono::steady_clock::now();
+  pid_t pid;
+  int   wstatus = 0;
+  bool  ok = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(),
+                         envp) == 0 &&
+    waitpid(pid, &wstatus, 0) == pid;
+  auto  end = chrono::steady_clock::now();
+  posix_spawn_file_actions_destroy(&actions);
+
+  if (status)
+    *status = ok && WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : -1;
+  return chrono::duration<double, micro>(end - start).count();
+}
+
+
+/**@brief  The current environment with NAME replaced (or removed if VALUE
+ *         is null)
+ */
+struct Environment {
+  vector<string> strings;
+  vector<char*>  envp;
+
+  Environment(const string& name, const char* value) {
+    for (char** env = environ; *env; env++)
+      if (string(*env).rfind(name + "=", 0) != 0)
+        strings.push_back(*env);
+    if (value)
+      strings.push_back(name + "=" + value);
+    for (auto& s : strings)
+      envp.push_back((char*)s.c_str());
+    envp.push_back(nullptr);
+  }
+};
+
+
+// ------------------------------- TempDir --------------------------------- //
+struct TempDir {
+  filesystem::path path;
+
+  TempDir(const string& name) {
+    path = filesystem::temp_directory_path() /
+      (name + "-" + to_string(getpid()));
+    filesystem::create_directories(path);
+  }
+
+  ~TempDir() {
+    error_code ec;
+    filesystem::remove_all(path, ec);
+  }
+};
+
+
+// ------------------------------------------------------------------------- //
+#endif  // BENCH_H
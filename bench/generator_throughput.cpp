@@ -0,0 +1,270 @@
+// ------------------------------------------------------------------------- //
+// Generator Throughput Benchmark                                            //
+// ------------------------------------------------------------------------- //
+/**@file    GENERATOR_THROUGHPUT.CPP
+ * @brief   Creates shims of a synthetic corpus of PE executables
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Usage: generator_throughput SHIM_EXEC [COPIES]
+ *
+ * Builds COPIES (default 20) executables of each of PE_PROFILES (see
+ * PE_CORPUS.H) in a scratch directory, then times:
+ *
+ *  resources       reading the resources CopyResources copies (icons, icon
+ *                  groups and version info, in every language) from each,
+ *                  with READPERESOURCES. Fails unless every one is found.
+ *
+ *  icons           importing the first icon of each (as --iconpath) and
+ *                  pruning the icons read (OPTIMIZEICONS): duplicates alone,
+ *                  and to 16, 32, 48 and 256 px within ICON_LIMIT. Fails
+ *                  unless every group is kept, is within the limit and
+ *                  refers only to images kept.
+ *
+ *  create          a shim of each by SHIM_EXEC, one process per shim (the
+ *                  generator has no batch mode)
+ *
+ *  update          the same again, overwriting the shims
+ *
+ * reporting executables (or shims) per second and MB/s read and written.
+ * Those of the generator are its own --metrics counts, which on Windows
+ * include reading the source for CopyResources; elsewhere a shim carries no
+ * resources and only the template is read. Fails unless every shim is
+ * created and updated.
+ *
+ * Also fails unless a shim of a script given 2000 arguments (some 60 kB, far
+ * more than the ELF block's SHIM_CONFIG_CAPACITY) by --command @FILE passes
+ * every one on whole.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#include <fstream>
+#include <sstream>
+#include "bench.h"
+#include "pe_corpus.h"
+#include <icon_resources.h>
+
+#define ICON_LIMIT      (64 << 10)
+
+
+// Value of a sample in an OpenMetrics file (0 if missing)
+double Sample(const filesystem::path& file, const string& name) {
+  ifstream in(file);
+  string   line;
+  while (getline(in, line))
+    if (line.rfind(name + " ", 0) == 0)
+      return strtod(line.c_str() + name.size() + 1, nullptr);
+  return 0;
+}
+
+// Every group within the limit, referring only to images kept
+bool IconsValid(const vector<IconResource>& icons, const IconStats& stats,
+                size_t groups, uint64_t limit) {
+  map<uint16_t, uint32_t> images;
+  for (auto& icon : icons)
+    if (icon.type == PE_RT_ICON)
+      images[icon.id] = icon.data.size();
+
+  bool valid = stats.groups == groups && images.size() == stats.images_out &&
+    (!limit || stats.bytes_out <= limit);
+  for (auto& icon : icons) {
+    vector<IconEntry> entries;
+    if (icon.type != PE_RT_GROUP_ICON)
+      continue;
+    valid = valid && ParseIconGroup(icon.data, entries) && !entries.empty();
+    for (auto& entry : entries)
+      valid = valid && images.count(entry.id) &&
+        images[entry.id] == entry.size;
+  }
+  return valid;
+}
+
+void Report(const char* name, size_t count, double seconds, double read,
+            double written) {
+  printf("%-20s %8zu %10.1f %10.1f %10.1f\n", name, count, count / seconds,
+         read / seconds / 1e6, written / seconds / 1e6);
+}
+
+
+// Does a shim made with --command @FILE of many arguments pass them all on?
+bool LongCommandPassed(const string& shim_exec, const filesystem::path& dir) {
+  filesystem::path script = dir / "arguments.sh";
+  filesystem::path shim   = dir / "shims" / "arguments";
+  filesystem::path args   = dir / "arguments.txt";
+  filesystem::path out    = dir / "arguments.out";
+  ofstream(script) << "#!/bin/sh\nprintf '%s\\n' \"$@\" > '"
+                   << out.string() << "'\n";
+  filesystem::permissions(script, filesystem::perms::owner_exec,
+                          filesystem::perm_options::add);
+
+  // Ten to a line, as the lines are joined by spaces
+  string expected, lines;
+  for (int i = 0; i < 2000; i++) {
+    string arg = "argument-" + to_string(i) + "-of-a-long-command";
+    expected  += arg + "\n";
+    lines     += arg + (i % 10 == 9 ? "\n" : " ");
+  }
+  ofstream(args) << lines;
+
+  // The generator's exit code says nothing (it is 1 either way)
+  RunProcess({shim_exec, script.string(), shim.string(),
+              "--command", "@" + args.string()}, environ);
+  if (!filesystem::exists(shim))
+    return false;
+  int status = -1;
+  RunProcess({shim.string()}, environ, &status);
+
+  ifstream     file(out);
+  stringstream passed;
+  passed << file.rdbuf();
+  return status == 0 && passed.str() == expected;
+}
+
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s SHIM_EXEC [COPIES]\n", argv[0]);
+    return 1;
+  }
+  string shim_exec = filesystem::absolute(argv[1]).string();
+  int    copies    = argc > 2 ? atoi(argv[2]) : 20;
+
+  TempDir dir("shim-generator-bench");
+  filesystem::create_directories(dir.path / "corpus");
+  filesystem::create_directories(dir.path / "shims");
+
+  // ---------- Corpus ---------- //
+  vector<filesystem::path> corpus;
+  vector<size_t>           expected;
+  uint64_t                 corpus_bytes = 0;
+  for (auto& profile : PE_PROFILES)
+    for (int c = 0; c < copies; c++) {
+      size_t resources;
+      string image = BuildPe(profile, corpus.size(), &resources);
+      corpus.push_back(dir.path / "corpus" /
+                       (profile.name + "-" + to_string(c) + ".exe"));
+      expected.push_back(resources);
+      corpus_bytes += image.size();
+      ofstream(corpus.back(), ios::binary) << image;
+      filesystem::permissions(corpus.back(), filesystem::perms::owner_exec,
+                              filesystem::perm_options::add);
+    }
+  printf("%zu executables (%zu profiles), %.1f MB\n\n", corpus.size(),
+         PE_PROFILES.size(), corpus_bytes / 1e6);
+
+  // ---------- Resources ---------- //
+  bool     complete = true;
+  uint64_t resource_bytes = 0;
+  vector<vector<IconResource>> icons(corpus.size());
+  auto     start = chrono::steady_clock::now();
+  for (size_t i = 0; i < corpus.size(); i++) {
+    ifstream           file(corpus[i], ios::binary);
+    vector<PeResource> resources;
+    ReadPeResources(file, resources);
+
+    size_t copied = 0;
+    string data;
+    for (auto& r : resources)
+      if (r.type == PE_RT_ICON || r.type == PE_RT_GROUP_ICON ||
+          r.type == PE_RT_VERSION) {
+        complete = ReadPeResource(file, r, data) && complete;
+        resource_bytes += data.size();
+        copied++;
+        if (r.type != PE_RT_VERSION)
+          icons[i].push_back({r.type, r.id, "", r.lang, data});
+      }
+    complete = complete && copied == expected[i];
+  }
+  double resources_s = chrono::duration<double>(
+      chrono::steady_clock::now() - start).count();
+
+  // ---------- Icons ---------- //
+  IconPolicy pruned;
+  pruned.sizes     = {16, 32, 48, 256};
+  pruned.max_bytes = ICON_LIMIT;
+  uint64_t icon_bytes = 0, deduped_bytes = 0, pruned_bytes = 0;
+  start = chrono::steady_clock::now();
+  for (size_t i = 0; i < corpus.size(); i++) {
+    auto&  copied = icons[i];
+    size_t groups = count_if(copied.begin(), copied.end(),
+      [](const IconResource& r) { return r.type == PE_RT_GROUP_ICON; });
+
+    // As --iconpath takes the first
+    vector<IconResource> imported;
+    complete = complete && ReadIconResources(corpus[i], 0, imported) ==
+      (groups > 0);
+    for (auto [policy, bytes] : {make_pair(IconPolicy(), &deduped_bytes),
+                                 make_pair(pruned, &pruned_bytes)}) {
+      vector<IconResource> kept  = copied;
+      IconStats            stats = OptimizeIcons(kept, policy);
+      complete = complete && IconsValid(kept, stats, groups,
+                                        policy.max_bytes);
+      *bytes += stats.bytes_out;
+      if (bytes == &deduped_bytes)
+        icon_bytes += stats.bytes_in;
+    }
+  }
+  double icons_s = chrono::duration<double>(
+      chrono::steady_clock::now() - start).count();
+
+  // ---------- Generator ---------- //
+  auto generate = [&](const filesystem::path& metrics) {
+    auto start = chrono::steady_clock::now();
+    for (auto& source : corpus)
+      RunProcess({shim_exec, source.string(),
+                  (dir.path / "shims" / source.filename()).string(),
+                  "--metrics", metrics.string()}, environ);
+    return chrono::duration<double>(chrono::steady_clock::now() - start)
+      .count();
+  };
+  filesystem::path create_metrics = dir.path / "create.prom";
+  filesystem::path update_metrics = dir.path / "update.prom";
+  double create_s = generate(create_metrics);
+  double update_s = generate(update_metrics);
+
+  printf("%-20s %8s %10s %10s %10s\n", "", "count", "per s", "read MB/s",
+         "write MB/s");
+  Report("resources", corpus.size(), resources_s, resource_bytes, 0);
+  Report("icons", corpus.size() * 2, icons_s, icon_bytes * 2, 0);
+  for (auto [name, metrics, seconds] : {
+      make_tuple("create", create_metrics, create_s),
+      make_tuple("update", update_metrics, update_s)}) {
+    const char* result = string(name) == "create" ? "created" : "updated";
+    double shims = Sample(metrics, string("shim_exec_shims_total{result=\"") +
+                          result + "\"}");
+    Report(name, shims, seconds,
+           Sample(metrics, "shim_exec_read_bytes_total"),
+           Sample(metrics, "shim_exec_written_bytes_total"));
+    complete = complete && shims == corpus.size();
+  }
+
+  printf("\nicons %.2f MB, %.2f MB without duplicates, %.2f MB of 16-256 "
+         "px within %d kB\n", icon_bytes / 1e6, deduped_bytes / 1e6,
+         pruned_bytes / 1e6, ICON_LIMIT >> 10);
+
+  if (!complete) {
+    fprintf(stderr, "\nnot every resource was read or shim created\n");
+    return 1;
+  }
+  if (!LongCommandPassed(shim_exec, dir.path)) {
+    fprintf(stderr, "\na shim of a long --command @FILE did not pass on "
+            "its arguments\n");
+    return 1;
+  }
+  return 0;
+}
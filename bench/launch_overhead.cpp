@@ -0,0 +1,247 @@
+// ------------------------------------------------------------------------- //
+// Launch Overhead Benchmark                                                 //
+// ------------------------------------------------------------------------- //
+/**@file    LAUNCH_OVERHEAD.CPP
+ * @brief   Compares launching the test application directly and through a
+ *          shim, one at a time and under contention
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Usage: launch_overhead SHIM APP [RUNS] [LAUNCHERS] [--json FILE]
+ *
+ * Copies SHIM (an unpatched template, e.g. bin/shim) to a scratch directory
+ * with a sidecar pointing it at APP (bin/console_app) run with --timestamp,
+ * which prints when it started and exits. APP is then launched RUNS (default
+ * 500) times directly and as many through the shim, alternately, first one
+ * at a time and then from LAUNCHERS (default 8) threads at once.
+ *
+ * For each launch it measures, from just before spawning:
+ *
+ *  start           until APP started (by the time it printed)
+ *  exit            until the launched process (APP or the shim) was reaped
+ *
+ * and reports their percentiles (us) with the overhead of the shim, i.e.
+ * the difference from a direct launch at the same percentile. --json writes
+ * the same to FILE. Fails if any launch does not start APP or exits non-zero.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <cstring>
+#include "bench.h"
+
+const double PERCENTILES[] = {50, 90, 99};
+
+
+// One way of launching: how long until the application started / exited
+struct Launches {
+  Samples start;
+  Samples exit;
+  int     failed = 0;
+  mutex   lock;
+};
+
+
+/**@brief  Launch ARGS once, reading APP's timestamp from its stdout
+ *
+ * The pipe is close-on-exec (but for the child's stdout) so a launch from
+ * another thread never holds it open.
+ */
+void Launch(const vector<string>& args, Launches& launches) {
+  vector<char*> argv;
+  for (auto& arg : args)
+    argv.push_back((char*)arg.c_str());
+  argv.push_back(nullptr);
+
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) != 0) {
+    lock_guard<mutex> guard(launches.lock);
+    launches.failed++;
+    return;
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+  posix_spawn_file_actions_adddup2(&actions, fds[1], 1);
+
+  int64_t launched = chrono::steady_clock::now().time_since_epoch().count();
+  pid_t   pid;
+  bool    ok = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(),
+                           environ) == 0;
+  posix_spawn_file_actions_destroy(&actions);
+  close(fds[1]);
+
+  string  output;
+  char    buffer[256];
+  ssize_t n;
+  while (ok && (n = read(fds[0], buffer, sizeof(buffer))) > 0)
+    output.append(buffer, n);
+  close(fds[0]);
+
+  int wstatus = 0;
+  ok = ok && waitpid(pid, &wstatus, 0) == pid;
+  int64_t exited  = chrono::steady_clock::now().time_since_epoch().count();
+  int64_t started = strtoll(output.c_str(), nullptr, 10);
+
+  lock_guard<mutex> guard(launches.lock);
+  if (!ok || !WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0 ||
+      started < launched) {
+    launches.failed++;
+    return;
+  }
+  launches.start.add((started - launched) / 1e3);
+  launches.exit.add((exited - launched) / 1e3);
+}
+
+
+/**@brief  Launch directly and through the shim RUNS times each, alternately,
+ *         from LAUNCHERS threads sharing the runs
+ */
+void Run(const vector<string>& direct, const vector<string>& shimmed,
+         int runs, int launchers, Launches& d, Launches& s) {
+  atomic<int>    next(0);
+  vector<thread> threads;
+  for (int t = 0; t < launchers; t++)
+    threads.emplace_back([&] {
+      for (int i = next++; i < runs * 2; i = next++)
+        i % 2 ? Launch(shimmed, s) : Launch(direct, d);
+    });
+  for (auto& t : threads)
+    t.join();
+}
+
+
+// ------------------------------- Report ---------------------------------- //
+void Print(const char* mode, Launches& d, Launches& s) {
+  printf("%-22s", mode);
+  for (const char* what : {"start", "exit"})
+    for (double p : PERCENTILES)
+      printf(" %7s p%-2.0f", what, p);
+  printf("\n");
+
+  auto row = [](const char* name, Launches& l) {
+    printf("%-22s", name);
+    for (Samples* samples : {&l.start, &l.exit})
+      for (double p : PERCENTILES)
+        printf(" %11.0f", samples->percentile(p));
+    printf("\n");
+  };
+  row("  direct", d);
+  row("  shim", s);
+
+  printf("%-22s", "  overhead");
+  for (auto [sd, ss] : {make_pair(&d.start, &s.start),
+                        make_pair(&d.exit, &s.exit)})
+    for (double p : PERCENTILES)
+      printf(" %+11.0f", ss->percentile(p) - sd->percentile(p));
+  printf("\n\n");
+}
+
+// {"direct": {"start": {"p50": ...}, ...}, "shim": ..., "overhead": ...}
+void WriteJson(ostream& out, Launches& d, Launches& s) {
+  auto percentiles = [&](Samples* shim, Samples* direct) {
+    const char* separator = "";
+    out << "{";
+    for (double p : PERCENTILES) {
+      out << separator << "\"p" << p << "\": "
+          << shim->percentile(p) - (direct ? direct->percentile(p) : 0);
+      separator = ", ";
+    }
+    out << "}";
+  };
+  auto launches = [&](Launches& l, Launches* base) {
+    out << "{";
+    if (!base)
+      out << "\"runs\": " << l.exit.values.size() << ", \"failed\": "
+          << l.failed << ", ";
+    out << "\"start_us\": ";
+    percentiles(&l.start, base ? &base->start : nullptr);
+    out << ", \"exit_us\": ";
+    percentiles(&l.exit, base ? &base->exit : nullptr);
+    out << "}";
+  };
+
+  out << "{\"direct\": ";
+  launches(d, nullptr);
+  out << ", \"shim\": ";
+  launches(s, nullptr);
+  out << ", \"overhead\": ";
+  launches(s, &d);
+  out << "}";
+}
+
+
+// -------------------------------- Main ----------------------------------- //
+int main(int argc, char* argv[]) {
+  vector<string> positional;
+  string json;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--json") && i + 1 < argc)
+      json = argv[++i];
+    else
+      positional.push_back(argv[i]);
+  }
+  if (positional.size() < 2) {
+    fprintf(stderr, "usage: %s SHIM APP [RUNS] [LAUNCHERS] [--json FILE]\n",
+            argv[0]);
+    return 1;
+  }
+  string app       = filesystem::absolute(positional[1]).string();
+  int    runs      = positional.size() > 2 ? atoi(positional[2].c_str()) : 500;
+  int    launchers = positional.size() > 3 ? atoi(positional[3].c_str()) : 8;
+
+  TempDir dir("shim-launch-bench");
+  string  shim = (dir.path / "console_app").string();
+  filesystem::copy_file(positional[0], shim);
+  ofstream(shim + ".shim") << "path = " << app << "\nargs = --timestamp\n"
+                           << "type = CONSOLE\n";
+
+  vector<string> direct  = {app, "--timestamp"};
+  vector<string> shimmed = {shim};
+
+  Launches seq_direct, seq_shim, con_direct, con_shim;
+  Run(direct, shimmed, runs, 1, seq_direct, seq_shim);
+  Run(direct, shimmed, runs, launchers, con_direct, con_shim);
+
+  printf("%d launches each, %d launchers at once (us)\n\n", runs, launchers);
+  Print("sequential", seq_direct, seq_shim);
+  Print(("concurrent (" + to_string(launchers) + ")").c_str(), con_direct,
+        con_shim);
+
+  if (!json.empty()) {
+    ofstream out(json);
+    out << "{\"runs\": " << runs << ", \"launchers\": " << launchers
+        << ",\n \"sequential\": ";
+    WriteJson(out, seq_direct, seq_shim);
+    out << ",\n \"concurrent\": ";
+    WriteJson(out, con_direct, con_shim);
+    out << "}\n";
+  }
+
+  int failed = seq_direct.failed + seq_shim.failed + con_direct.failed +
+    con_shim.failed;
+  if (failed) {
+    fprintf(stderr, "%d launch(es) failed\n", failed);
+    return 1;
+  }
+  return 0;
+}
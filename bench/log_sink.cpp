@@ -0,0 +1,156 @@
+// ------------------------------------------------------------------------- //
+// Log Sink Benchmark                                                        //
+// ------------------------------------------------------------------------- //
+/**@file    LOG_SINK.CPP
+ * @brief   Appends to one rotated log from many processes at once
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Usage: log_sink [PROCESSES] [LINES]
+ *
+ * Starts PROCESSES (default 16) processes that, released together, each log
+ * LINES (default 20000) numbered lines of varying length to the same file
+ * through a LogSink with a small buffer, i.e. many flushes, rotating at
+ * ROTATE_SIZE into enough old files to keep every line. Fails unless:
+ *
+ *  - every line of <file>, <file>.1 ... is whole, i.e. no line was torn or
+ *    interleaved with another process' line
+ *  - every process' lines are all there, once each and in order
+ *  - <file>.1 exists and no file is over ROTATE_SIZE, nor was one rotated
+ *    before the next flush would have taken it over
+ *
+ * and reports the time per line.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#include <map>
+#include <fstream>
+#include "bench.h"
+#include <log_sink.h>
+
+#define SINK_CAPACITY   4096            // bytes buffered between flushes
+#define ROTATE_SIZE     (256 * 1024)
+#define ROTATE_FILES    999
+
+
+// Line I of process ID, its length varying with I
+string Line(int id, size_t i) {
+  return "proc " + to_string(id) + " line " + to_string(i) + " " +
+    string(i % 97, 'a' + id % 26) + " end\n";
+}
+
+// One process: wait for the go, then log
+int Log(const filesystem::path& file, int id, size_t lines, int go) {
+  char c;
+  if (read(go, &c, 1) != 0)             // EOF once the parent closes it
+    return 1;
+
+  LogSink sink(SINK_CAPACITY);
+  sink.setFile(file);
+  sink.setRotation(ROTATE_SIZE, ROTATE_FILES);
+  for (size_t i = 0; i < lines; i++)
+    sink.write(Line(id, i));
+  return sink.flush() ? 0 : 1;
+}
+
+
+int main(int argc, char* argv[]) {
+  int    processes = argc > 1 ? atoi(argv[1]) : 16;
+  size_t lines     = argc > 2 ? atoi(argv[2]) : 20000;
+
+  TempDir dir("shim-log-bench");
+  filesystem::path file = dir.path / "shim.log";
+
+  int go[2];
+  if (pipe(go) != 0)
+    return 1;
+
+  vector<pid_t> pids;
+  for (int id = 0; id < processes; id++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(go[1]);
+      _exit(Log(file, id, lines, go[0]));
+    }
+    pids.push_back(pid);
+  }
+  close(go[0]);
+
+  // Release them all at once
+  auto start = chrono::steady_clock::now();
+  close(go[1]);
+  bool complete = true;
+  for (pid_t pid : pids) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    complete = complete && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+  auto end = chrono::steady_clock::now();
+
+  // Oldest file first, so each process' lines come in the order written
+  vector<filesystem::path> files;
+  for (int n = ROTATE_FILES; n >= 1; n--)
+    if (filesystem::exists(file.string() + "." + to_string(n)))
+      files.push_back(file.string() + "." + to_string(n));
+  files.push_back(file);
+
+  vector<size_t> next(processes, 0);
+  size_t torn = 0, misplaced = 0, oversize = 0, early = 0;
+  for (size_t f = 0; f < files.size(); f++) {
+    uint64_t size = filesystem::file_size(files[f]);
+    oversize += size > ROTATE_SIZE;
+    // Rotated only once the next flush (at most a full buffer) would not fit
+    early += f + 1 < files.size() && size + SINK_CAPACITY <= ROTATE_SIZE;
+
+    ifstream in(files[f], ios::binary);
+    string   line;
+    while (getline(in, line)) {
+      int    id;
+      size_t i;
+      if (sscanf(line.c_str(), "proc %d line %zu", &id, &i) != 2 ||
+          id < 0 || id >= processes || line + "\n" != Line(id, i)) {
+        torn++;
+        continue;
+      }
+      misplaced += i != next[id];
+      next[id] = i + 1;
+    }
+  }
+  bool   rotated = filesystem::exists(file.string() + ".1");
+  size_t missing = 0;
+  for (size_t n : next)
+    missing += n != lines;
+
+  double seconds = chrono::duration<double>(end - start).count();
+  size_t total   = processes * lines;
+  printf("%d processes, %zu lines each into one log (%zu files)\n\n",
+         processes, lines, files.size());
+  printf("%-20s %10.1f\n", "lines / s (M)", total / seconds / 1e6);
+  printf("%-20s %10.1f\n", "ns / line", seconds * 1e9 / total);
+
+  if (!complete)
+    fprintf(stderr, "\na process could not append to the log\n");
+  if (torn || misplaced || missing)
+    fprintf(stderr, "\n%zu torn or interleaved lines, %zu out of order, "
+            "%zu processes missing lines\n", torn, misplaced, missing);
+  if (!rotated || oversize || early)
+    fprintf(stderr, "\nnot rotated at %d bytes (%zu files, %zu over, %zu "
+            "early)\n", ROTATE_SIZE, files.size(), oversize, early);
+  return complete && !torn && !misplaced && !missing && rotated &&
+    !oversize && !early ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+// ------------------------------------------------------------------------- //
+// Manifest Benchmark                                                        //
+// ------------------------------------------------------------------------- //
+/**@file    MANIFEST.CPP
+ * @brief   Checks SHA-256 and times verifying shims against a manifest
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Usage: manifest [SHIMS] [SIZE_KB]
+ *
+ * Fails unless Sha256 gives the FIPS 180-4 digests of its example messages,
+ * the same digest of random data fed in random pieces as in one, and
+ * HashFile the same again. Then writes SHIMS (default 256) files of SIZE_KB
+ * (default 320, about an ELF shim) random bytes, added to a manifest by 8
+ * threads at once, and times VerifyManifest over them with one thread and
+ * with one per CPU (MB/s, from the cache). Fails unless every shim was added
+ * and matches, and a shim with one byte changed, one truncated and one
+ * removed are each caught.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#include <random>
+#include <fstream>
+#include "bench.h"
+#include <manifest.h>
+
+#define WRITERS     8
+
+
+string Digest(const string& data) {
+  Sha256 hash;
+  hash.update(data);
+  return hash.finish();
+}
+
+// The examples of FIPS 180-4 (and its one million "a"s)
+bool CheckVectors() {
+  const char* vectors[][2] = {
+    {"",
+     "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+    {"abc",
+     "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+    {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+     "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+  };
+  bool ok = true;
+  for (auto& v : vectors)
+    ok = ok && Digest(v[0]) == v[1];
+  return ok && Digest(string(1000000, 'a')) ==
+    "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0";
+}
+
+// Random data, whole and in random pieces (every padding case included)
+bool CheckPieces(mt19937_64& random, const filesystem::path& dir) {
+  for (size_t length = 0; length < 300; length++) {
+    string data(length + (length >= 200 ? random() % 100000 : 0), '\0');
+    for (auto& c : data)
+      c = (char)random();
+
+    Sha256 hash;
+    for (size_t at = 0; at < data.size(); ) {
+      size_t n = min<size_t>(random() % 150, data.size() - at);
+      hash.update(data.data() + at, n);
+      at += n;
+    }
+    string digest = hash.finish();
+    if (digest != Digest(data))
+      return false;
+
+    filesystem::path file = dir / "pieces";
+    ofstream(file, ios::binary) << data;
+    string   read;
+    uint64_t size;
+    if (!HashFile(file, read, size) || read != digest || size != data.size())
+      return false;
+  }
+  return true;
+}
+
+
+int main(int argc, char* argv[]) {
+  size_t shims = argc > 1 ? strtoul(argv[1], nullptr, 10) : 256;
+  size_t size  = (argc > 2 ? strtoul(argv[2], nullptr, 10) : 320) * 1024;
+  if (shims < 3) {
+    fprintf(stderr, "usage: %s [SHIMS >= 3] [SIZE_KB]\n", argv[0]);
+    return 1;
+  }
+
+  TempDir     dir("shim-manifest");
+  mt19937_64  random(42);
+  if (!CheckVectors() || !CheckPieces(random, dir.path)) {
+    fprintf(stderr, "SHA-256 gave a wrong digest\n");
+    return 1;
+  }
+
+  // The shims, added from several threads at once
+  vector<ManifestEntry> written(shims);
+  for (size_t i = 0; i < shims; i++) {
+    string data(size, '\0');
+    for (auto& c : data)
+      c = (char)random();
+    written[i] = {Digest(data), size,
+                  (dir.path / ("shim-" + to_string(i))).u8string(),
+                  "/usr/bin/target-" + to_string(i)};
+    ofstream(filesystem::u8path(written[i].shim), ios::binary) << data;
+  }
+
+  filesystem::path manifest = dir.path / "manifest.txt";
+  atomic<size_t>   next(0), added(0);
+  vector<thread>   writers;
+  for (int w = 0; w < WRITERS; w++)
+    writers.emplace_back([&] {
+      for (size_t i; (i = next++) < shims; )
+        added += AddToManifest(manifest, written[i]);
+    });
+  for (auto& writer : writers)
+    writer.join();
+
+  ifstream file(manifest, ios::binary);
+  vector<ManifestEntry> entries = ParseManifest(
+      string(istreambuf_iterator<char>(file), istreambuf_iterator<char>()));
+  bool ok = added == shims && entries.size() == shims;
+
+  // Verify with one thread, then one per CPU
+  unsigned cpus = max(1u, thread::hardware_concurrency());
+  printf("%zu shims of %zu kB\n\n", shims, size / 1024);
+  printf("%-20s %10s %10s\n", "", "ms", "MB/s");
+  for (unsigned threads : {1u, cpus}) {
+    auto start = chrono::steady_clock::now();
+    auto problems = VerifyManifest(entries, {}, threads);
+    double seconds = chrono::duration<double>(
+        chrono::steady_clock::now() - start).count();
+    ok = ok && count(problems.begin(), problems.end(), nullptr) ==
+      (ptrdiff_t)shims;
+    printf("%-20s %10.1f %10.0f\n",
+           (to_string(threads) + " thread(s)").c_str(), seconds * 1e3,
+           shims * size / seconds / 1e6);
+  }
+
+  // A changed, a truncated and a missing shim
+  {
+    fstream changed(filesystem::u8path(entries[0].shim),
+                    ios::in | ios::out | ios::binary);
+    changed.seekg(size / 2);
+    char c = changed.get() ^ 1;
+    changed.seekp(size / 2);
+    changed.put(c);
+  }
+  filesystem::resize_file(filesystem::u8path(entries[1].shim), size - 1);
+  filesystem::remove(filesystem::u8path(entries[2].shim));
+  auto problems = VerifyManifest(entries);
+  ok = ok && problems[0] && string(problems[0]) == "wrong SHA-256" &&
+    problems[1] && string(problems[1]) == "wrong size" &&
+    problems[2] && string(problems[2]) == "missing" &&
+    count(problems.begin(), problems.end(), nullptr) == (ptrdiff_t)shims - 3;
+
+  if (!ok) {
+    fprintf(stderr, "\nthe manifest lost shims or missed a changed one\n");
+    return 1;
+  }
+  return 0;
+}
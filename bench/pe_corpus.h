@@ -0,0 +1,421 @@
+// ------------------------------------------------------------------------- //
+// Synthetic PE Corpus                                                       //
+// ------------------------------------------------------------------------- //
+/**@file    PE_CORPUS.H
+ * @brief   Builds PE executables with icon and version resources, without
+ *          any Windows API
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Defines the following:
+ *
+ *  PeProfile
+ *      one kind of executable: size of its code, icon groups and the sizes
+ *      of their images (256 px ones PNG compressed, the rest bitmaps),
+ *      whether it has version info, its languages (every resource is given
+ *      in each) and subsystem
+ *
+ *  PE_PROFILES
+ *      the mix of a typical package repository, from small command line
+ *      tools without icons to GUI applications with many icons in several
+ *      languages
+ *
+ *  BuildPe
+ *      a PE32+ image of a profile: headers, a .text section of
+ *      incompressible bytes and a .rsrc section of the resources, laid out
+ *      as a linker would
+ *
+ * The images are not meant to be run (nor the icons shown), just to have the
+ * structure and sizes of real ones.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef PE_CORPUS_H
+#define PE_CORPUS_H
+
+// ------------------------------------------------------------------------- //
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <pe_resources.h>
+
+using namespace std;
+
+#define PNG_ICON_BYTES      49152       // of a 256 px frame
+
+
+// ------------------------------- Profiles -------------------------------- //
+struct PeProfile {
+  string            name;
+  size_t            code_size;          // bytes of .text
+  int               icon_groups;
+  vector<int>       icon_sizes;         // px, of each group's images
+  bool              version;
+  vector<uint16_t>  langs;
+  bool              gui;
+};
+
+const vector<PeProfile> PE_PROFILES = {
+  {"cli-tiny",       64 << 10, 0, {},                      false, {0x409},
+   false},
+  {"cli-small",     256 << 10, 1, {16, 32, 48},            true,  {0x409},
+   false},
+  {"cli-large",       4 << 20, 1, {16, 32},                true,  {0x409},
+   false},
+  {"gui-multi-res",   1 << 20, 1, {16, 24, 32, 48, 64, 256}, true, {0x409},
+   true},
+  {"gui-many-icons",  2 << 20, 8, {16, 32, 48, 256},       true,
+   {0x409, 0x407, 0x411}, true},
+};
+
+
+// -------------------------------- Bytes ---------------------------------- //
+// Little endian VALUE of SIZE bytes, appended / written at AT
+void Put(string& out, uint64_t value, int size) {
+  for (int i = 0; i < size; i++)
+    out += (char)(value >> (8 * i));
+}
+
+void PutAt(string& out, size_t at, uint64_t value, int size) {
+  for (int i = 0; i < size; i++)
+    out[at + i] = (char)(value >> (8 * i));
+}
+
+void PadTo(string& out, size_t alignment) {
+  out.resize((out.size() + alignment - 1) / alignment * alignment, '\0');
+}
+
+// SIZE bytes that do not compress (xorshift)
+string Noise(size_t size, uint32_t seed) {
+  string   out(size, '\0');
+  uint32_t x = seed * 2654435761u + 1;
+  for (size_t i = 0; i < size; i++) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    out[i] = (char)x;
+  }
+  return out;
+}
+
+// UTF-16LE of an ASCII string, with its NUL
+string Utf16(const string& text) {
+  string out;
+  for (char c : text)
+    Put(out, (unsigned char)c, 2);
+  Put(out, 0, 2);
+  return out;
+}
+
+
+// -------------------------------- Icons ---------------------------------- //
+uint32_t Crc32(const string& data) {
+  uint32_t crc = 0xFFFFFFFF;
+  for (unsigned char c : data) {
+    crc ^= c;
+    for (int k = 0; k < 8; k++)
+      crc = crc >> 1 ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+// PNG chunk: big endian length, type, data, CRC of type and data
+string PngChunk(const string& type, const string& data) {
+  string chunk, body = type + data;
+  for (int i = 3; i >= 0; i--)
+    chunk += (char)(data.size() >> (8 * i));
+  chunk += body;
+  uint32_t crc = Crc32(body);
+  for (int i = 3; i >= 0; i--)
+    chunk += (char)(crc >> (8 * i));
+  return chunk;
+}
+
+/**@brief  One RT_ICON image of PX pixels square
+ *
+ * 256 px images are PNG (a real header, noise for the compressed pixels),
+ * smaller ones 32 bit bitmaps: a BITMAPINFOHEADER (of twice the height, for
+ * the AND mask), the pixels and the mask.
+ */
+string IconImage(int px, uint32_t seed) {
+  if (px >= 256) {
+    string header;
+    for (int i = 3; i >= 0; i--)
+      header += (char)(px >> (8 * i));
+    header = header + header + string("\x08\x06\x00\x00\x00", 5);
+    return string("\x89PNG\r\n\x1a\n", 8) + PngChunk("IHDR", header) +
+      PngChunk("IDAT", Noise(PNG_ICON_BYTES, seed)) + PngChunk("IEND", "");
+  }
+
+  string image;
+  Put(image, 40, 4);                    // biSize
+  Put(image, px, 4);
+  Put(image, px * 2, 4);
+  Put(image, 1, 2);                     // biPlanes
+  Put(image, 32, 2);                    // biBitCount
+  Put(image, 0, 4);                     // BI_RGB
+  Put(image, px * px * 4, 4);
+  image.resize(40, '\0');
+  return image + Noise(px * px * 4, seed) +
+    string((px + 31) / 32 * 4 * px, '\0');
+}
+
+/**@brief  RT_GROUP_ICON (GRPICONDIR) of images with IDs FIRST_ID on
+ */
+string IconGroup(const vector<int>& sizes, const vector<string>& images,
+                 uint16_t first_id) {
+  string group;
+  Put(group, 0, 2);                     // idReserved
+  Put(group, 1, 2);                     // idType (icon)
+  Put(group, sizes.size(), 2);
+  for (size_t i = 0; i < sizes.size(); i++) {
+    Put(group, sizes[i] >= 256 ? 0 : sizes[i], 1);
+    Put(group, sizes[i] >= 256 ? 0 : sizes[i], 1);
+    Put(group, 0, 2);                   // bColorCount, bReserved
+    Put(group, 1, 2);                   // wPlanes
+    Put(group, 32, 2);                  // wBitCount
+    Put(group, images[i].size(), 4);
+    Put(group, first_id + i, 2);
+  }
+  return group;
+}
+
+
+// ---------------------------- Version Info ------------------------------- //
+// A block of VS_VERSIONINFO: header, key, value and children, 32 bit aligned
+string VersionBlock(const string& key, const string& value, bool text,
+                    const vector<string>& children = {}) {
+  string block;
+  Put(block, 0, 2);                     // wLength, set below
+  Put(block, text ? value.size() / 2 : value.size(), 2);
+  Put(block, text ? 1 : 0, 2);
+  block += Utf16(key);
+  PadTo(block, 4);
+  block += value;
+  for (auto& child : children) {
+    PadTo(block, 4);
+    block += child;
+  }
+  PutAt(block, 0, block.size(), 2);
+  return block;
+}
+
+string VersionInfo(const string& name, uint16_t lang) {
+  string fixed;
+  Put(fixed, 0xFEEF04BD, 4);            // dwSignature
+  Put(fixed, 0x00010000, 4);            // dwStrucVersion
+  for (uint32_t v : {0x00010002u, 0x00030004u, 0x00010002u, 0x00030004u})
+    Put(fixed, v, 4);                   // file and product versions
+  Put(fixed, 0x3F, 4);                  // dwFileFlagsMask
+  Put(fixed, 0, 4);
+  Put(fixed, 0x00040004, 4);            // VOS_NT_WINDOWS32
+  Put(fixed, 1, 4);                     // VFT_APP
+  fixed.resize(52, '\0');
+
+  char table[9];
+  snprintf(table, sizeof(table), "%04X04B0", lang);
+  vector<string> strings;
+  for (auto& [key, value] : vector<pair<string, string>>{
+      {"CompanyName", "Example Corporation"},
+      {"FileDescription", name + " synthetic executable"},
+      {"FileVersion", "1.2.3.4"},
+      {"InternalName", name},
+      {"LegalCopyright", "Copyright (C) Example Corporation"},
+      {"OriginalFilename", name + ".exe"},
+      {"ProductName", name},
+      {"ProductVersion", "1.2.3.4"}})
+    strings.push_back(VersionBlock(key, Utf16(value), true));
+
+  string translation;
+  Put(translation, lang, 2);
+  Put(translation, 1200, 2);
+  return VersionBlock("VS_VERSION_INFO", fixed, false, {
+      VersionBlock("StringFileInfo", "", true,
+                   {VersionBlock(table, "", true, strings)}),
+      VersionBlock("VarFileInfo", "", true,
+                   {VersionBlock("Translation", translation, false)})});
+}
+
+
+// ------------------------------- Sections -------------------------------- //
+struct PeBlob {
+  uint16_t  type;
+  uint16_t  id;
+  uint16_t  lang;
+  string    data;
+};
+
+/**@brief  The .rsrc section of BLOBS, to be loaded at RVA
+ *
+ * Directories (types, names, languages, each sorted by ID) come first, then
+ * the data entries, then the data itself, 8 byte aligned.
+ */
+string ResourceSection(const vector<PeBlob>& blobs, uint32_t rva) {
+  map<uint16_t, map<uint16_t, map<uint16_t, const string*>>> tree;
+  for (auto& blob : blobs)
+    tree[blob.type][blob.id][blob.lang] = &blob.data;
+
+  size_t dirs = 16 + 8 * tree.size(), leaves = 0;
+  for (auto& [type, ids] : tree) {
+    dirs += 16 + 8 * ids.size();
+    for (auto& [id, langs] : ids) {
+      dirs   += 16 + 8 * langs.size();
+      leaves += langs.size();
+    }
+  }
+
+  string out(dirs + 16 * leaves, '\0');
+  size_t next_dir = 0, next_entry = dirs;
+  auto directory = [&](size_t entries) {
+    size_t at = next_dir;
+    PutAt(out, at + 14, entries, 2);    // NumberOfIdEntries
+    next_dir += 16 + 8 * entries;
+    return at;
+  };
+  auto entry = [&](size_t dir, size_t i, uint32_t key, uint32_t data) {
+    PutAt(out, dir + 16 + 8 * i, key, 4);
+    PutAt(out, dir + 16 + 8 * i + 4, data, 4);
+  };
+
+  size_t root = directory(tree.size()), t = 0;
+  for (auto& [type, ids] : tree) {
+    size_t type_dir = directory(ids.size()), n = 0;
+    entry(root, t++, type, 0x80000000 | type_dir);
+    for (auto& [id, langs] : ids) {
+      size_t name_dir = directory(langs.size()), l = 0;
+      entry(type_dir, n++, id, 0x80000000 | name_dir);
+      for (auto& [lang, data] : langs) {
+        entry(name_dir, l++, lang, next_entry);
+        PadTo(out, 8);
+        PutAt(out, next_entry, rva + out.size(), 4);
+        PutAt(out, next_entry + 4, data->size(), 4);
+        next_entry += 16;
+        out += *data;
+      }
+    }
+  }
+  return out;
+}
+
+
+// ---------------------------------- PE ----------------------------------- //
+/**@brief  A PE32+ image of PROFILE
+ *
+ * @param  SEED:        varies the code and images between copies
+ * @param  RESOURCES:   number of resources in it
+ */
+string BuildPe(const PeProfile& profile, uint32_t seed,
+               size_t* resources = nullptr) {
+  const uint32_t FILE_ALIGN = 0x200, SECTION_ALIGN = 0x1000, HEADERS = 0x400;
+  auto align = [](size_t v, size_t a) { return (v + a - 1) / a * a; };
+
+  // Icons (the same images in every language), groups and version info
+  vector<PeBlob> blobs;
+  uint16_t       next_id = 1;
+  for (int g = 0; g < profile.icon_groups; g++) {
+    vector<string> images;
+    for (int px : profile.icon_sizes)
+      images.push_back(IconImage(px, seed * 131 + next_id + images.size()));
+    string group = IconGroup(profile.icon_sizes, images, next_id);
+
+    for (uint16_t lang : profile.langs) {
+      for (size_t i = 0; i < images.size(); i++)
+        blobs.push_back({PE_RT_ICON, (uint16_t)(next_id + i), lang,
+                         images[i]});
+      blobs.push_back({PE_RT_GROUP_ICON, (uint16_t)(g + 1), lang, group});
+    }
+    next_id += images.size();
+  }
+  if (profile.version)
+    for (uint16_t lang : profile.langs)
+      blobs.push_back({PE_RT_VERSION, 1, lang,
+                       VersionInfo(profile.name, lang)});
+  if (resources)
+    *resources = blobs.size();
+
+  uint32_t text_rva  = SECTION_ALIGN;
+  uint32_t text_raw  = align(profile.code_size, FILE_ALIGN);
+  uint32_t rsrc_rva  = text_rva + align(profile.code_size, SECTION_ALIGN);
+  string   rsrc      = blobs.empty() ? "" : ResourceSection(blobs, rsrc_rva);
+  uint32_t rsrc_raw  = align(rsrc.size(), FILE_ALIGN);
+  int      sections  = rsrc.empty() ? 1 : 2;
+
+  string pe(HEADERS, '\0');
+  memcpy(&pe[0], "MZ", 2);
+  PutAt(pe, 0x3C, 0x80, 4);             // e_lfanew
+  memcpy(&pe[0x80], "PE\0\0", 4);
+
+  size_t coff = 0x84;
+  PutAt(pe, coff, 0x8664, 2);           // AMD64
+  PutAt(pe, coff + 2, sections, 2);
+  PutAt(pe, coff + 16, 240, 2);         // SizeOfOptionalHeader
+  PutAt(pe, coff + 18, 0x22, 2);        // executable, large address aware
+
+  size_t opt = coff + 20;
+  PutAt(pe, opt, 0x20B, 2);             // PE32+
+  PutAt(pe, opt + 4, text_raw, 4);
+  PutAt(pe, opt + 8, rsrc_raw, 4);
+  PutAt(pe, opt + 16, text_rva, 4);     // AddressOfEntryPoint
+  PutAt(pe, opt + 20, text_rva, 4);
+  PutAt(pe, opt + 24, 0x140000000, 8);  // ImageBase
+  PutAt(pe, opt + 32, SECTION_ALIGN, 4);
+  PutAt(pe, opt + 36, FILE_ALIGN, 4);
+  PutAt(pe, opt + 40, 6, 2);            // OS version
+  PutAt(pe, opt + 48, 6, 2);            // subsystem version
+  PutAt(pe, opt + 56, rsrc_rva + align(rsrc.size(), SECTION_ALIGN), 4);
+  PutAt(pe, opt + 60, HEADERS, 4);
+  PutAt(pe, opt + 68, profile.gui ? 2 : 3, 2);
+  PutAt(pe, opt + 70, 0x8160, 2);       // DllCharacteristics
+  PutAt(pe, opt + 72, 0x100000, 8);     // stack and heap reserve / commit
+  PutAt(pe, opt + 80, 0x1000, 8);
+  PutAt(pe, opt + 88, 0x100000, 8);
+  PutAt(pe, opt + 96, 0x1000, 8);
+  PutAt(pe, opt + 108, 16, 4);          // NumberOfRvaAndSizes
+  if (!rsrc.empty()) {
+    PutAt(pe, opt + 112 + 2 * 8, rsrc_rva, 4);
+    PutAt(pe, opt + 112 + 2 * 8 + 4, rsrc.size(), 4);
+  }
+
+  auto section = [&](int i, const char* name, uint32_t size, uint32_t rva,
+                     uint32_t raw_size, uint32_t raw, uint32_t flags) {
+    size_t at = opt + 240 + 40 * i;
+    memcpy(&pe[at], name, strlen(name));
+    PutAt(pe, at + 8, size, 4);
+    PutAt(pe, at + 12, rva, 4);
+    PutAt(pe, at + 16, raw_size, 4);
+    PutAt(pe, at + 20, raw, 4);
+    PutAt(pe, at + 36, flags, 4);
+  };
+  section(0, ".text", profile.code_size, text_rva, text_raw, HEADERS,
+          0x60000020);                  // code, execute, read
+  if (!rsrc.empty())
+    section(1, ".rsrc", rsrc.size(), rsrc_rva, rsrc_raw, HEADERS + text_raw,
+            0x40000040);                // initialized data, read
+
+  pe += Noise(profile.code_size, seed);
+  PadTo(pe, FILE_ALIGN);
+  pe += rsrc;
+  PadTo(pe, FILE_ALIGN);
+  return pe;
+}
+
+
+// ------------------------------------------------------------------------- //
+#endif  // PE_CORPUS_H
@@ -0,0 +1,207 @@
+// ------------------------------------------------------------------------- //
+// Relay Throughput Benchmark                                                //
+// ------------------------------------------------------------------------- //
+/**@file    RELAY_THROUGHPUT.CPP
+ * @brief   Compares stdout bandwidth with and without --shim-Relay / Tee
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Usage: relay_throughput SHIM [MB] [RUNS]
+ *
+ * Copies SHIM (an unpatched template, e.g. bin/shim) to a scratch directory
+ * with a sidecar pointing it at dd writing MB megabytes of zeros (default
+ * 1024) to stdout, then reads its stdout through a pipe RUNS times: from dd
+ * alone, from the shim, from the shim relaying and from the shim teeing to
+ * its log. Fails if any run does not deliver every byte, or the log does not
+ * account for every byte (either logged or counted as dropped).
+ *
+ * Also fails unless a relaying shim whose stdin is a socket, open but with
+ * nothing to read, exits once its application (sleep, as dd lets go of its
+ * stdin at once) has: a stdin spliced from a socket would hold the
+ * application's pipe, and so its exit, until the socket had data.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <csignal>
+#include <sys/socket.h>
+#include "bench.h"
+
+
+/**@brief  Run a process, reading its stdout through a pipe
+ *
+ * @param  BYTES:   number of bytes read
+ *
+ * @return MB/s read
+ */
+double ReadProcess(const vector<string>& args, size_t& bytes) {
+  vector<char*> argv;
+  for (auto& arg : args)
+    argv.push_back((char*)arg.c_str());
+  argv.push_back(nullptr);
+
+  int fds[2];
+  if (pipe(fds) != 0)
+    return 0;
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+  posix_spawn_file_actions_adddup2(&actions, fds[1], 1);
+  posix_spawn_file_actions_addclose(&actions, fds[0]);
+
+  auto  start = chrono::steady_clock::now();
+  pid_t pid;
+  bytes = 0;
+  if (posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(),
+                  environ) == 0) {
+    close(fds[1]);
+    vector<char> buffer(1 << 20);
+    ssize_t n;
+    while ((n = read(fds[0], buffer.data(), buffer.size())) > 0)
+      bytes += n;
+    waitpid(pid, nullptr, 0);
+  }
+  else
+    close(fds[1]);
+  auto  end = chrono::steady_clock::now();
+  close(fds[0]);
+  posix_spawn_file_actions_destroy(&actions);
+
+  double seconds = chrono::duration<double>(end - start).count();
+  return bytes / 1e6 / seconds;
+}
+
+
+// Bytes in the tee's LOG and the number it reported dropped
+void ReadTeeLog(const string& log, size_t& logged, size_t& dropped) {
+  ifstream      file(log, ios::binary);
+  stringstream  text;
+  text << file.rdbuf();
+  string        s = text.str();
+
+  logged  = s.size();
+  dropped = 0;
+  size_t at = s.rfind("[shim] ");
+  if (at != string::npos) {
+    dropped = strtoull(s.c_str() + at + 7, nullptr, 10);
+    logged  = at;
+  }
+}
+
+
+// Does a relaying SHIM running sleep exit within 10 seconds with its stdin
+// an idle socket?
+bool RelaysIdleSocket(const string& shim) {
+  ofstream(shim + ".shim") << "path = /bin/sleep\nargs = 0.5\n"
+                           << "type = CONSOLE\n";
+  int sockets[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+    return false;
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, sockets[0], 0);
+  posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+  posix_spawn_file_actions_addclose(&actions, sockets[1]);
+
+  char* argv[] = {(char*)shim.c_str(), (char*)"--shim-Relay", nullptr};
+  pid_t pid;
+  int   status = -1;
+  if (posix_spawn(&pid, argv[0], &actions, nullptr, argv, environ) == 0) {
+    for (int wait = 0; wait < 1000; wait++) {
+      if (waitpid(pid, &status, WNOHANG) == pid)
+        break;
+      status = -1;
+      this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    if (status == -1) {
+      kill(pid, SIGKILL);
+      waitpid(pid, nullptr, 0);
+    }
+  }
+  close(sockets[0]);
+  close(sockets[1]);
+  posix_spawn_file_actions_destroy(&actions);
+  return status == 0;
+}
+
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s SHIM [MB] [RUNS]\n", argv[0]);
+    return 1;
+  }
+  size_t mb   = argc > 2 ? atoi(argv[2]) : 1024;
+  int    runs = argc > 3 ? atoi(argv[3]) : 5;
+
+  TempDir dir("shim-relay-bench");
+  string  shim = (dir.path / "zeros").string();
+  string  args = "if=/dev/zero bs=1M count=" + to_string(mb) + " status=none";
+  filesystem::copy_file(argv[1], shim);
+  ofstream(shim + ".shim") << "path = /bin/dd\nargs = " << args
+                           << "\ntype = CONSOLE\n";
+
+  vector<string> target = {"/bin/dd", "if=/dev/zero",
+                           "bs=1M", "count=" + to_string(mb), "status=none"};
+
+  string  log  = shim + ".log";
+
+  Samples alone, direct, relayed, teed, dropped;
+  size_t  bytes, logged, lost;
+  bool    complete = true;
+  for (int i = 0; i < runs; i++) {
+    alone.add(ReadProcess(target, bytes));
+    direct.add(ReadProcess({shim}, bytes));
+    complete = complete && bytes == mb << 20;
+    relayed.add(ReadProcess({shim, "--shim-Relay"}, bytes));
+    complete = complete && bytes == mb << 20;
+
+    filesystem::remove(log);
+    teed.add(ReadProcess({shim, "--shim-Tee"}, bytes));
+    ReadTeeLog(log, logged, lost);
+    dropped.add(100.0 * lost / bytes);
+    complete = complete && bytes == mb << 20 && logged + lost == bytes;
+  }
+
+  printf("%zu MB from dd\n\n", mb);
+  Samples::header("(MB/s)");
+  alone.print("target only");
+  direct.print("shim");
+  relayed.print("shim, relayed");
+  teed.print("shim, teed");
+
+  printf("\n");
+  Samples::header("(%)");
+  dropped.print("tee dropped");
+
+  if (!complete) {
+    fprintf(stderr, "\nnot every byte was read\n");
+    return 1;
+  }
+  string idle = (dir.path / "idle").string();
+  filesystem::copy_file(argv[1], idle);
+  if (!RelaysIdleSocket(idle)) {
+    fprintf(stderr, "\nrelaying from an idle socket, the shim did not exit "
+            "with its application\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,156 @@
+// ------------------------------------------------------------------------- //
+// Ring Buffer Benchmark                                                     //
+// ------------------------------------------------------------------------- //
+/**@file    RING_BUFFER.CPP
+ * @brief   Stresses the tee's ring buffer with one producer and one consumer
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Usage: ring_buffer [RECORDS] [CAPACITY]
+ *
+ * A producer thread pushes RECORDS (default 2000000) numbered records of 6
+ * to 305 bytes into a RingBuffer of CAPACITY (default 4096) bytes, while a
+ * consumer thread pops them in pieces of 1 to 512 bytes. Both now and then
+ * yield, so the buffer wraps, fills and drops pushes. Fails unless:
+ *
+ *  - what was popped is exactly the records pushed, in order and intact,
+ *    i.e. no record was torn across the wrap or by a drop
+ *  - the records popped are the ones PUSH accepted, and DROPPED counts the
+ *    bytes of exactly those it refused
+ *  - nothing is left over once the producer is done and the consumer has
+ *    caught up
+ *
+ * and reports the bytes moved per second and the share dropped.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#include <atomic>
+#include <thread>
+#include "bench.h"
+#include <ring_buffer.h>
+
+#define RECORD_HEADER   6               // sequence (4 bytes), length (2)
+
+
+// Record SEQ: its sequence number, length and bytes that follow from both
+string Record(uint32_t seq) {
+  uint16_t size = RECORD_HEADER + seq * 7919u % 300;
+  string   record(size, '\0');
+  memcpy(&record[0], &seq, 4);
+  memcpy(&record[4], &size, 2);
+  for (size_t k = RECORD_HEADER; k < size; k++)
+    record[k] = (char)(seq * 131 + k);
+  return record;
+}
+
+
+int main(int argc, char* argv[]) {
+  uint32_t records  = argc > 1 ? atoi(argv[1]) : 2000000;
+  size_t   capacity = argc > 2 ? atoi(argv[2]) : 4096;
+
+  RingBuffer     ring(capacity);
+  vector<char>   accepted(records, 0), received(records, 0);
+  uint64_t       offered = 0, refused = 0;
+  atomic<bool>   produced{false};
+
+  auto start = chrono::steady_clock::now();
+
+  // ---------- Producer ---------- //
+  thread producer([&] {
+    for (uint32_t seq = 0; seq < records; seq++) {
+      string record = Record(seq);
+      offered += record.size();
+      if (ring.push(record.data(), record.size()))
+        accepted[seq] = 1;
+      else
+        refused += record.size();
+      // Let the consumer in even when there is one CPU to share
+      if (seq % 61 == 0)
+        this_thread::yield();
+    }
+    produced.store(true, memory_order_release);
+  });
+
+  // ---------- Consumer ---------- //
+  string   pending;
+  char     piece[512];
+  uint64_t popped = 0, torn = 0, order = 0, rng = 88172645463325252ull;
+  int64_t  last = -1;
+  while (true) {
+    bool   finished = produced.load(memory_order_acquire);
+    rng ^= rng << 13, rng ^= rng >> 7, rng ^= rng << 17;
+    size_t n = ring.pop(piece, 1 + rng % sizeof(piece));
+    popped += n;
+    pending.append(piece, n);
+
+    // Whole records, each checked against what was pushed
+    size_t at = 0;
+    while (pending.size() - at >= RECORD_HEADER) {
+      uint32_t seq;
+      uint16_t size;
+      memcpy(&seq, &pending[at], 4);
+      memcpy(&size, &pending[at + 4], 2);
+      if (pending.size() - at < size)
+        break;
+      if (seq >= records || pending.compare(at, size, Record(seq)) != 0) {
+        torn++;
+        at = pending.size();
+        break;
+      }
+      order += (int64_t)seq <= last;
+      last = seq;
+      received[seq] = 1;
+      at += size;
+    }
+    pending.erase(0, at);
+
+    if (n == 0 && finished)
+      break;
+    if (rng % 64 == 0)
+      this_thread::yield();
+  }
+  producer.join();
+  auto end = chrono::steady_clock::now();
+
+  // Exactly what was accepted arrived, and the rest was counted as dropped
+  size_t mismatched = 0;
+  for (uint32_t seq = 0; seq < records; seq++)
+    mismatched += accepted[seq] != received[seq];
+  bool counted = ring.dropped() == refused && offered - refused == popped;
+
+  double seconds = chrono::duration<double>(end - start).count();
+  printf("%u records through %zu bytes\n\n", records, capacity);
+  printf("%-20s %10.1f\n", "MB / s", popped / seconds / 1e6);
+  printf("%-20s %10.2f\n", "dropped (%)", 100.0 * refused / offered);
+
+  if (torn || order || mismatched || !pending.empty() || ring.size()) {
+    fprintf(stderr, "\n%llu torn, %llu out of order, %zu accepted but not "
+            "popped (or the reverse), %zu bytes left over\n",
+            (unsigned long long)torn, (unsigned long long)order, mismatched,
+            pending.size() + ring.size());
+    return 1;
+  }
+  if (!counted) {
+    fprintf(stderr, "\ndropped %llu bytes, refused %llu, popped %llu of "
+            "%llu\n", (unsigned long long)ring.dropped(),
+            (unsigned long long)refused, (unsigned long long)popped,
+            (unsigned long long)offered);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,157 @@
+// ------------------------------------------------------------------------- //
+// Scheduling Policy Check                                                   //
+// ------------------------------------------------------------------------- //
+/**@file    SCHED_POLICY.CPP
+ * @brief   Checks a waiting shim's target has its policy and the shim not
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Usage: sched_policy SHIM
+ *
+ * Runs SHIM (a copy, configured by a sidecar file) with a policy of the last
+ * CPU it may run on, priority below (nice 10) and a 1 GB memory cap, and a
+ * target that sleeps. Once the target is running, reads /proc/PID/status,
+ * stat and limits of both and fails unless the target has the CPU, nice
+ * value and address space limit, and the shim still has its own (the policy
+ * being applied in the target's process between fork and exec).
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <csignal>
+#include <sched.h>
+#include <sys/resource.h>
+#include "bench.h"
+
+#define MEMORY_LIMIT    (1ull << 30)
+
+
+// What /proc says of a process
+struct ProcPolicy {
+  string    cpus;                       // Cpus_allowed_list
+  int       nice =          0;
+  string    address_space;              // soft limit, as /proc/PID/limits has
+};
+
+ProcPolicy ReadPolicy(pid_t pid) {
+  ProcPolicy policy;
+  string     proc = "/proc/" + to_string(pid);
+  string     line;
+
+  ifstream status(proc + "/status");
+  while (getline(status, line))
+    if (line.rfind("Cpus_allowed_list:", 0) == 0)
+      istringstream(line.substr(18)) >> policy.cpus;
+
+  // Nice is the 19th field, counted after the command's closing parenthesis
+  ifstream stat(proc + "/stat");
+  getline(stat, line);
+  istringstream fields(line.substr(line.rfind(')') + 2));
+  string field;
+  for (int i = 3; i < 19 && fields >> field; i++) {}
+  fields >> policy.nice;
+
+  ifstream limits(proc + "/limits");
+  while (getline(limits, line))
+    if (line.rfind("Max address space", 0) == 0)
+      istringstream(line.substr(26)) >> policy.address_space;
+  return policy;
+}
+
+// The first child of PID, 0 while it has none
+pid_t FirstChild(pid_t pid) {
+  ifstream file("/proc/" + to_string(pid) + "/task/" + to_string(pid) +
+                "/children");
+  pid_t child = 0;
+  file >> child;
+  return child;
+}
+
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s SHIM\n", argv[0]);
+    return 1;
+  }
+
+  // The last CPU this may run on, to differ from the default where it can
+  cpu_set_t cpus;
+  int       cpu = 0;
+  sched_getaffinity(0, sizeof(cpus), &cpus);
+  for (int i = 0; i < 64; i++)
+    if (CPU_ISSET(i, &cpus))
+      cpu = i;
+  int nice = getpriority(PRIO_PROCESS, 0);
+
+  TempDir dir("shim-sched-bench");
+  string  shim = (dir.path / "tool").string();
+  filesystem::copy_file(argv[1], shim);
+  ofstream(shim + ".shim") << "path = /bin/sleep\nargs = 30\ntype = CONSOLE\n"
+                           << "sched = affinity " << cpu << "\n"
+                           << "sched = priority below\n"
+                           << "sched = memory " << MEMORY_LIMIT << "\n";
+
+  char* args[] = {(char*)shim.c_str(), nullptr};
+  pid_t pid;
+  if (posix_spawn(&pid, args[0], nullptr, nullptr, args, environ)) {
+    fprintf(stderr, "could not start %s\n", shim.c_str());
+    return 1;
+  }
+
+  pid_t child = 0;
+  for (int wait = 0; wait < 500 && !(child = FirstChild(pid)); wait++)
+    this_thread::sleep_for(chrono::milliseconds(10));
+  // Past exec, i.e. running sleep rather than a copy of the shim
+  for (int wait = 0; wait < 500 && child; wait++) {
+    ifstream comm("/proc/" + to_string(child) + "/comm");
+    string   name;
+    if (comm >> name && name == "sleep")
+      break;
+    this_thread::sleep_for(chrono::milliseconds(10));
+  }
+
+  ProcPolicy target = ReadPolicy(child);
+  ProcPolicy own    = ReadPolicy(pid);
+  ProcPolicy before = ReadPolicy(getpid());
+  kill(pid, SIGTERM);
+  waitpid(pid, nullptr, 0);
+
+  // The shim keeps what it was started with, i.e. this process' policy
+  int     expected_nice = min(nice + 10, 19);
+  string  expected_cpus = to_string(cpu);
+  string  expected_as   = to_string(MEMORY_LIMIT);
+  printf("%-10s %12s %6s %20s\n", "", "cpus", "nice", "address space");
+  printf("%-10s %12s %6d %20s\n", "target", target.cpus.c_str(), target.nice,
+         target.address_space.c_str());
+  printf("%-10s %12s %6d %20s\n", "shim", own.cpus.c_str(), own.nice,
+         own.address_space.c_str());
+  printf("%-10s %12s %6d %20s\n", "expected", expected_cpus.c_str(),
+         expected_nice, expected_as.c_str());
+
+  bool applied = child && target.cpus == expected_cpus &&
+    target.nice == expected_nice && target.address_space == expected_as;
+  bool kept = own.cpus == before.cpus && own.nice == before.nice &&
+    own.address_space == before.address_space;
+  if (!applied)
+    fprintf(stderr, "\nFAILED: the target does not have its policy\n");
+  if (!kept)
+    fprintf(stderr, "\nFAILED: the shim took on the target's policy\n");
+  return applied && kept ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+// ------------------------------------------------------------------------- //
+// Stats Ledger Benchmark                                                    //
+// ------------------------------------------------------------------------- //
+/**@file    STATS_LEDGER.CPP
+ * @brief   Records into one stats ledger from many processes at once
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Usage: stats_ledger [PROCESSES] [RECORDS]
+ *
+ * Starts PROCESSES (default 16) processes that, released together, each open
+ * the same new ledger, claim a slot of their own (recording one run and one
+ * exec) and record RECORDS (default 100000) invocations spread over four
+ * shared names, every third a failure and every fifth an exec. Fails unless
+ * every count, exec, failure, wall time and histogram adds up exactly
+ * afterwards, i.e. no update was lost to another process, and reports the
+ * time per record.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#include <map>
+#include "bench.h"
+#include <stats_ledger.h>
+
+#define SHARED_NAMES    4
+
+
+// One process: wait for the go, then record
+int Record(const filesystem::path& file, int id, size_t records, int go) {
+  char c;
+  if (read(go, &c, 1) != 0)             // EOF once the parent closes it
+    return 1;
+
+  StatsLedger ledger;
+  string own = "proc-" + to_string(id);
+  if (!ledger.open(file) || !ledger.record(own, id, false) ||
+      !ledger.recordExec(own))
+    return 1;
+
+  for (size_t i = 0; i < records; i++) {
+    string name = "shared-" + to_string(i % SHARED_NAMES);
+    if (!(i % 5 == 0 ? ledger.recordExec(name) :
+                       ledger.record(name, i, i % 3 == 0)))
+      return 1;
+  }
+  return 0;
+}
+
+
+int main(int argc, char* argv[]) {
+  int    processes = argc > 1 ? atoi(argv[1]) : 16;
+  size_t records   = argc > 2 ? atoi(argv[2]) : 100000;
+
+  TempDir dir("shim-stats-bench");
+  filesystem::path file = dir.path / STATS_FILE_NAME;
+
+  int go[2];
+  if (pipe(go) != 0)
+    return 1;
+
+  vector<pid_t> pids;
+  for (int id = 0; id < processes; id++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(go[1]);
+      _exit(Record(file, id, records, go[0]));
+    }
+    pids.push_back(pid);
+  }
+  close(go[0]);
+
+  // Release them all at once
+  auto start = chrono::steady_clock::now();
+  close(go[1]);
+  bool complete = true;
+  for (pid_t pid : pids) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    complete = complete && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+  auto end = chrono::steady_clock::now();
+
+  // What each name should have
+  map<string, StatsRecord> expected;
+  for (int id = 0; id < processes; id++) {
+    StatsRecord& r = expected["proc-" + to_string(id)];
+    r.count++;
+    r.execs++;
+    r.wall_us += id;
+  }
+  for (size_t i = 0; i < records; i++) {
+    StatsRecord& r = expected["shared-" + to_string(i % SHARED_NAMES)];
+    if (i % 5 == 0) {
+      r.execs  += processes;
+      continue;
+    }
+    r.count    += processes;
+    r.failures += i % 3 == 0 ? processes : 0;
+    r.wall_us  += i * processes;
+  }
+
+  StatsLedger ledger;
+  vector<StatsRecord> found;
+  if (ledger.open(file, false))
+    found = ledger.records();
+  complete = complete && found.size() == expected.size();
+  for (auto& r : found) {
+    uint64_t bucketed = 0;
+    for (uint64_t n : r.histogram)
+      bucketed += n;
+    auto& e  = expected[r.name];
+    complete = complete && r.count == e.count && r.execs == e.execs &&
+      r.failures == e.failures && r.wall_us == e.wall_us &&
+      bucketed == r.count;
+  }
+
+  double seconds = chrono::duration<double>(end - start).count();
+  size_t total   = processes * (records + 1);
+  printf("%d processes, %zu records each into one ledger\n\n", processes,
+         records);
+  printf("%-20s %10.1f\n", "records / s (M)", total / seconds / 1e6);
+  printf("%-20s %10.1f\n", "ns / record", seconds * 1e9 / total);
+
+  if (!complete) {
+    fprintf(stderr, "\nthe ledger lost or garbled updates\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,142 @@
+// ------------------------------------------------------------------------- //
+// Waiting Footprint Benchmark                                               //
+// ------------------------------------------------------------------------- //
+/**@file    WAIT_FOOTPRINT.CPP
+ * @brief   Measures the memory a shim holds while waiting for its target
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Usage: wait_footprint SHIM [BUDGET_KB] [RUNS]
+ *
+ * Copies SHIM (an unpatched template, e.g. bin/shim) to a scratch directory
+ * with a sidecar pointing it at sleep, and once the shim is waiting reads
+ * its memory from /proc/<pid>/smaps_rollup, RUNS times plainly and RUNS
+ * times teeing (--shim-Tee, i.e. with the relay's threads and buffers).
+ *
+ * What a waiting shim holds is its anonymous memory: heap, stacks and the
+ * pages of its libraries it has written. The median of it for each is
+ * checked against BUDGET_KB. Private memory is reported too but not
+ * checked, as most of it is the shim's own executable, private only because
+ * each shim is a copy of its own and clean, i.e. dropped and read again by
+ * the kernel as it needs. The copy is synced first so it is not dirty.
+ *
+ * -------------------------------------------------------------------------
+ * For scale, a C++ program that does nothing but wait for a child holds
+ * about 200 kB anonymous (the C and C++ runtimes' relocated and written
+ * pages, its heap and stack), about what a plain shim does.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <csignal>
+#include <map>
+#include "bench.h"
+
+
+// Fields of /proc/PID/smaps_rollup in kB
+map<string, double> ReadRollup(pid_t pid) {
+  map<string, double> fields;
+  ifstream file("/proc/" + to_string(pid) + "/smaps_rollup");
+  string line;
+  while (getline(file, line)) {
+    istringstream words(line);
+    string name;
+    double kb;
+    if (words >> name >> kb && name.back() == ':')
+      fields[name.substr(0, name.size() - 1)] = kb;
+  }
+  return fields;
+}
+
+// Has PID started a child yet?
+bool HasChild(pid_t pid) {
+  ifstream file("/proc/" + to_string(pid) + "/task/" + to_string(pid) +
+                "/children");
+  pid_t child;
+  return (bool)(file >> child);
+}
+
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s SHIM [BUDGET_KB] [RUNS]\n", argv[0]);
+    return 1;
+  }
+  double budget = argc > 2 ? atof(argv[2]) : 0;
+  int    runs   = argc > 3 ? atoi(argv[3]) : 5;
+
+  TempDir dir("shim-footprint-bench");
+  string  shim = (dir.path / "tool").string();
+  filesystem::copy_file(argv[1], shim);
+  ofstream(shim + ".shim") << "path = /bin/sleep\nargs = 30\ntype = CONSOLE\n";
+  sync();
+
+  // Nothing on stdin, for the relay to see the end of it at once
+  posix_spawn_file_actions_t stdio;
+  posix_spawn_file_actions_init(&stdio);
+  posix_spawn_file_actions_addopen(&stdio, 0, "/dev/null", O_RDONLY, 0);
+
+  bool over = false;
+  Samples::header("(kB)");
+
+  for (const char* mode : {"", "--shim-Tee"}) {
+    Samples rss, pss, priv, anon;
+    for (int i = 0; i < runs; i++) {
+      vector<char*> args = {(char*)shim.c_str()};
+      if (*mode)
+        args.push_back((char*)mode);
+      args.push_back(nullptr);
+      pid_t pid;
+      if (posix_spawn(&pid, args[0], &stdio, nullptr, args.data(),
+                      environ)) {
+        fprintf(stderr, "could not start %s\n", shim.c_str());
+        return 1;
+      }
+
+      // Give it a moment to settle once the target is running
+      for (int wait = 0; wait < 500 && !HasChild(pid); wait++)
+        this_thread::sleep_for(chrono::milliseconds(10));
+      this_thread::sleep_for(chrono::milliseconds(100));
+
+      auto fields = ReadRollup(pid);
+      rss.add(fields["Rss"]);
+      pss.add(fields["Pss"]);
+      priv.add(fields["Private_Clean"] + fields["Private_Dirty"]);
+      anon.add(fields["Anonymous"]);
+
+      // The shim passes SIGTERM on to the target and exits with it
+      kill(pid, SIGTERM);
+      waitpid(pid, nullptr, 0);
+    }
+
+    string name = *mode ? "tee " : "";
+    rss.print((name + "rss").c_str());
+    pss.print((name + "pss").c_str());
+    priv.print((name + "private").c_str());
+    anon.print((name + "anonymous").c_str());
+    if (budget > 0 && anon.percentile(50) > budget) {
+      printf("\nFAILED: %sanonymous memory of a waiting shim is over the "
+             "budget of %.0f kB\n", name.c_str(), budget);
+      over = true;
+    }
+  }
+  posix_spawn_file_actions_destroy(&stdio);
+  return over ? 1 : 0;
+}
@@ -0,0 +1,107 @@
+// ------------------------------------------------------------------------- //
+// Argument Parser Fuzz Target                                               //
+// ------------------------------------------------------------------------- //
+/**@file    ARGUMENTS.CPP
+ * @brief   Fuzzes the command line parsing every shim and the generator run
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * The input, as UTF-8, is a command line. Besides running without a memory
+ * error or undefined behaviour, the parsing must hold to:
+ *
+ *  lossless        CollapseArguments(ParseArguments(line)) == line, with
+ *                  arguments at even indices and only whitespace (or equal
+ *                  signs) at odd ones
+ *
+ *  stable          each argument parsed alone is itself, and re-parsing
+ *                  what is left after removing any is the same as parsing it
+ *
+ *  ARGV            SplitCommandLine(JoinArguments(ARGV)) == ARGV for the
+ *                  ARGV a child would get from the line
+ *
+ * then the line is parsed as the shim does (ParseShimOptions) and as the
+ * generator's GetArgument, GetSettingArgument, UnquoteString, TrimQuotes and
+ * UpperCase calls do.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#include "fuzz.h"
+#include <get_argument.h>
+#include <utility_functions.h>
+#include <shim_core.h>
+
+
+bool IsGap(const wstring& s) {
+  return !s.empty() && s.find_first_not_of(ARGUMENT_GAPS) == wstring::npos;
+}
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  wstring line = WidenString(string((const char*)data, size));
+
+  // ---------- Lossless ---------- //
+  vector<wstring> args = ParseArguments(line);
+  FUZZ_CHECK(CollapseArguments(args) == line);
+  for (size_t i = 0; i < args.size(); i++) {
+    FUZZ_CHECK(!args[i].empty());
+    FUZZ_CHECK(i % 2 == 0 || IsGap(args[i]));
+  }
+
+  // ---------- Stable ---------- //
+  for (size_t i = 0; i < args.size(); i += 2)
+    FUZZ_CHECK(ParseArguments(args[i]) == vector<wstring>{args[i]});
+
+  vector<wstring> left = args;
+  wstring         value;
+  GetArgument(left, 0, value);
+  FUZZ_CHECK(value == (args.empty() ? L"" : args[0]));
+  wstring rest = CollapseArguments(left);
+  ReparseArguments(left);
+  FUZZ_CHECK(CollapseArguments(left).size() <= rest.size());
+  for (auto& arg : left)
+    FUZZ_CHECK(!arg.empty());
+
+  // ---------- ARGV ---------- //
+  vector<wstring> argv = SplitCommandLine(line);
+  FUZZ_CHECK(SplitCommandLine(JoinArguments(argv)) == argv);
+  for (auto& arg : argv)
+    FUZZ_CHECK(SplitCommandLine(QuoteArgument(arg)) == vector<wstring>{arg});
+
+  // ---------- Shim ---------- //
+  ShimOptions options = ParseShimOptions(line);
+  FUZZ_CHECK(options.calling_args.size() <= line.size());
+
+  // ---------- Generator ---------- //
+  vector<wstring> generator = args;
+  wstring         setting;
+  GetArgument(generator, 0, value);
+  GetArgument(generator, L"(-h|--help)");
+  GetArgument(generator, L"(-o|--output)", value);
+  GetArgument(generator, L"--args?", value);
+  GetSettingArgument(generator, L"--env(-prepend|-append)?", setting);
+  GetArgument(generator, L"--input", value);
+  ReparseArguments(generator);
+  GetArgument(generator, 0, value);
+
+  wstring unquoted = UnquoteString(line);
+  FUZZ_CHECK(unquoted.size() <= line.size());
+  TrimQuotes(value);
+  TrimQuotes(setting);
+  UpperCase(value);
+  return 0;
+}
@@ -0,0 +1,114 @@
+// ------------------------------------------------------------------------- //
+// Fuzzing Harness                                                           //
+// ------------------------------------------------------------------------- //
+/**@file    FUZZ.H
+ * @brief   Runs a fuzz target on files, directories of files or stdin
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * A target defines LLVMFuzzerTestOneInput, as libFuzzer expects. Built with
+ * -fsanitize=fuzzer (and FUZZ_LIBFUZZER defined) libFuzzer supplies main,
+ * otherwise the one here runs the target once on each FILE given, every
+ * file of a directory given, or stdin if none is (as AFL expects, e.g.
+ * afl-fuzz -i fuzz/corpus/arguments -o out -- bin/fuzz/arguments). Built
+ * with the sanitizers, replaying the corpora checks nothing regressed.
+ *
+ *  FUZZ_CHECK
+ *      aborts (hence a crash the fuzzer records) if an oracle fails
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef FUZZ_H
+#define FUZZ_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <filesystem>
+
+using namespace std;
+
+#define FUZZ_CHECK(condition)                                           \
+  do {                                                                  \
+    if (!(condition)) {                                                 \
+      fprintf(stderr, "%s:%d: oracle failed: %s\n", __FILE__, __LINE__, \
+              #condition);                                              \
+      abort();                                                          \
+    }                                                                   \
+  } while (0)
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+
+#ifndef FUZZ_LIBFUZZER
+// -------------------------------- Main ----------------------------------- //
+int FuzzOne(const string& input) {
+  return LLVMFuzzerTestOneInput((const uint8_t*)input.data(), input.size());
+}
+
+int FuzzFile(const filesystem::path& path) {
+  ifstream file(path, ios::in | ios::binary);
+  if (!file) {
+    fprintf(stderr, "could not read %s\n", path.string().c_str());
+    return 1;
+  }
+  return FuzzOne(string(istreambuf_iterator<char>(file),
+                        istreambuf_iterator<char>()));
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 2)
+    return FuzzOne(string(istreambuf_iterator<char>(cin),
+                          istreambuf_iterator<char>()));
+
+  size_t inputs = 0;
+  for (int i = 1; i < argc; i++) {
+    if (!filesystem::is_directory(argv[i])) {
+      inputs++;
+      if (FuzzFile(argv[i]))
+        return 1;
+      continue;
+    }
+
+    // In order, so a replay is the same every time
+    vector<filesystem::path> files;
+    for (auto& entry : filesystem::directory_iterator(argv[i]))
+      if (entry.is_regular_file())
+        files.push_back(entry.path());
+    sort(files.begin(), files.end());
+    for (auto& file : files) {
+      inputs++;
+      if (FuzzFile(file))
+        return 1;
+    }
+  }
+  fprintf(stderr, "%s: %zu input(s) passed\n", argv[0], inputs);
+  return 0;
+}
+#endif  // FUZZ_LIBFUZZER
+
+
+// ------------------------------------------------------------------------- //
+#endif  // FUZZ_H
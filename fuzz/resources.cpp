@@ -0,0 +1,174 @@
+// ------------------------------------------------------------------------- //
+// Resource Fuzz Target                                                      //
+// ------------------------------------------------------------------------- //
+/**@file    RESOURCES.CPP
+ * @brief   Fuzzes reading executables and the configuration embedded in them
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * The input is taken as:
+ *
+ *  a PE file       whose resources are listed and read (ReadPeResources,
+ *                  ReadPeResource), each within the input
+ *
+ *  icons           the icon group read and written again (ParseIconGroup,
+ *                  FormatIconGroup), the icons of the PE file pruned
+ *                  (OptimizeIcons) to groups referring only to images kept,
+ *                  and the icon of an .ico file or of the PE file imported
+ *                  (ReadIconFile, ReadExeIcon) likewise
+ *
+ *  an ELF file     whose .shim_config section is looked for (FindElfConfig),
+ *                  the block found being within the input, and into which
+ *                  configurations shorter and longer than the block are
+ *                  patched one after the other, each reading back the same
+ *                  once the file is cut to the length PatchElfConfig gives,
+ *                  and copied in one pass (CopyElfShim) to the same bytes
+ *
+ *  configuration   the NAME = VALUE text of an ELF shim, and SHIM_ENV and
+ *                  SHIM_SCHED values, which must read back the same once
+ *                  written (FormatResourceText, FormatEnvOverride,
+ *                  FormatSchedPolicy)
+ *
+ * all at once, as the fuzzer soon mixes the three anyway.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#include <sstream>
+#include "fuzz.h"
+#include <pe_resources.h>
+#include <icon_resources.h>
+#include <resource_functions.h>
+#include <environment.h>
+#include <schedule.h>
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  string input((const char*)data, size);
+
+  // ---------- PE ---------- //
+  istringstream      pe(input);
+  vector<PeResource> resources;
+  ReadPeResources(pe, resources);
+  FUZZ_CHECK(resources.size() <= PE_MAX_RESOURCES);
+  for (auto& r : resources) {
+    FUZZ_CHECK(r.offset + r.size <= size);
+    string bytes;
+    FUZZ_CHECK(ReadPeResource(pe, r, bytes));
+    FUZZ_CHECK(bytes == input.substr(r.offset, r.size));
+  }
+
+  // ---------- Icons ---------- //
+  vector<IconEntry> entries;
+  if (ParseIconGroup(input, entries))
+    FUZZ_CHECK(FormatIconGroup(entries) ==
+               input.substr(0, ICON_DIR_SIZE +
+                            entries.size() * ICON_GROUP_ENTRY_SIZE));
+
+  vector<IconResource> icons;
+  for (auto& r : resources)
+    if (r.type == PE_RT_ICON || r.type == PE_RT_GROUP_ICON)
+      icons.push_back({r.type, r.id, NarrowString(r.name), r.lang,
+                       input.substr(r.offset, r.size)});
+  for (int exe = 0; exe < 2; exe++) {
+    istringstream        file(input);
+    vector<IconResource> imported;
+    if (exe ? !ReadExeIcon(file, 0, imported) :
+        !ReadIconFile(file, imported))
+      continue;
+    FUZZ_CHECK(imported.back().type == PE_RT_GROUP_ICON &&
+               ParseIconGroup(imported.back().data, entries) &&
+               entries.size() == imported.size() - 1);
+    for (size_t i = 0; i < entries.size(); i++)
+      FUZZ_CHECK(entries[i].id == imported[i].id &&
+                 entries[i].size == imported[i].data.size() &&
+                 imported[i].data.size() <= size);
+  }
+
+  IconPolicy policy;
+  policy.sizes     = {16, 48};
+  policy.max_bytes = size / 2;
+  IconStats stats  = OptimizeIcons(icons, policy);
+  FUZZ_CHECK(stats.bytes_out <= stats.bytes_in);
+  FUZZ_CHECK(stats.over_limit || stats.bytes_out <= policy.max_bytes);
+  map<uint16_t, uint32_t> images;
+  for (auto& icon : icons)
+    if (icon.type == PE_RT_ICON)
+      images[icon.id] = icon.data.size();
+  FUZZ_CHECK(images.size() == stats.images_out);
+  for (auto& icon : icons)
+    if (icon.type == PE_RT_GROUP_ICON) {
+      FUZZ_CHECK(ParseIconGroup(icon.data, entries) && !entries.empty());
+      for (auto& entry : entries)
+        FUZZ_CHECK(images.count(entry.id) && images[entry.id] == entry.size);
+    }
+
+  // ---------- ELF ---------- //
+  stringstream elf(input);
+  ElfReader    reader(elf);
+  uint64_t     offset;
+  if (reader.open() && FindElfConfig(reader, offset)) {
+    FUZZ_CHECK(offset + sizeof(SHIM_CONFIG_MAGIC) <= size);
+
+    string image = input;
+    for (size_t length : {SHIM_CONFIG_CAPACITY + 1 + size % 8192, size % 64,
+                          (size_t)SHIM_CONFIG_CAPACITY * 3}) {
+      string       text(length, '\0'), read;
+      uint64_t     cut;
+      for (size_t i = 0; i < length; i++)
+        text[i] = input[i % size] ^ (char)(i >> 8);
+      stringstream patched(image);
+      if (!PatchElfConfig(patched, text, &cut))
+        break;
+
+      string       copied;
+      MemoryStream source(image.data(), image.size());
+      FUZZ_CHECK(CopyElfShim(source, text, [&](const char* data, size_t n) {
+        copied.append(data, n);
+        return true;
+      }));
+      image = patched.str().substr(0, cut);
+      FUZZ_CHECK(copied == image);
+      stringstream file(image);
+      FUZZ_CHECK(ReadElfConfig(file, read) && read == text);
+    }
+  }
+
+  // ---------- Configuration ---------- //
+  map<string, wstring> config = ParseResourceText(input);
+  FUZZ_CHECK(ParseResourceText(FormatResourceText(config)) == config);
+
+  wstring             text = WidenString(input);
+  vector<EnvOverride> overrides = ParseEnvOverrides(text);
+  wstring             lines;
+  for (auto& o : overrides) {
+    wstring line = FormatEnvOverride(o.op, WidenString(o.name) + L"=" +
+                                     WidenString(o.value));
+    FUZZ_CHECK(!line.empty());
+    lines += line + L"\n";
+  }
+  vector<EnvOverride> again = ParseEnvOverrides(lines);
+  FUZZ_CHECK(again.size() == overrides.size());
+  for (size_t i = 0; i < again.size(); i++)
+    FUZZ_CHECK(again[i].op == overrides[i].op &&
+               again[i].name == overrides[i].name &&
+               again[i].value == overrides[i].value);
+
+  wstring sched = FormatSchedPolicy(ParseSchedPolicy(text));
+  FUZZ_CHECK(FormatSchedPolicy(ParseSchedPolicy(sched)) == sched);
+  return 0;
+}
@@ -0,0 +1,74 @@
+// ------------------------------------------------------------------------- //
+// Response File Fuzz Target                                                 //
+// ------------------------------------------------------------------------- //
+/**@file    RESPONSE.CPP
+ * @brief   Fuzzes decoding --command @FILE a block at a time
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * The input, less its first byte, is the content of a response file, fed to
+ * a ResponseDecoder in blocks of 1 - 8 bytes (by the first byte) so that
+ * characters, line breaks and the byte order mark are cut in every way:
+ *
+ *  pieces          it decodes the same as the whole file at once, i.e. line
+ *                  breaks as spaces, less a leading byte order mark and
+ *                  trailing whitespace, by WidenString
+ *
+ *  bounded         what is decoded after each block is the start of the
+ *                  whole, no more than the 3 bytes of a character cut off
+ *                  held back
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#include "fuzz.h"
+#include <response_file.h>
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if (size == 0)
+    return 0;
+  size_t      block = 1 + data[0] % 8;
+  const char* text  = (const char*)data + 1;
+  size_t      length = size - 1;
+
+  // ---------- Pieces ---------- //
+  string whole(text, length);
+  for (char& c : whole)
+    if (c == '\r' || c == '\n')
+      c = ' ';
+  wstring full = WidenString(whole);
+  if (!full.empty() && full[0] == 0xFEFF)
+    full.erase(0, 1);
+  wstring expected = full.substr(0, full.find_last_not_of(L" \t") + 1);
+
+  ResponseDecoder decoder;
+  wstring         args;
+  for (size_t at = 0; at < length; at += block) {
+    decoder.feed(text + at, min(block, length - at), args);
+
+    // ---------- Bounded ---------- //
+    // The start of the whole, short of it by no more than a character for
+    // each byte to come, and for each of 3 held back
+    size_t left = length - min(at + block, length);
+    FUZZ_CHECK(full.compare(0, args.size(), args) == 0);
+    FUZZ_CHECK(full.size() - args.size() <= left + 3);
+  }
+  decoder.finish(args);
+  FUZZ_CHECK(args == expected);
+  return 0;
+}
@@ -0,0 +1,149 @@
+// ------------------------------------------------------------------------- //
+// UTF-8 Encoding Fuzz Target                                                //
+// ------------------------------------------------------------------------- //
+/**@file    UTF8.CPP
+ * @brief   Fuzzes every path of EncodeUtf8 against a plain reference
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Each input byte is a unit of text, mostly ASCII so the vector paths see
+ * whole blocks of it: below 0xC0 ASCII, then 2 and 3 byte characters, high
+ * and low surrogates (paired or not), values past U+10FFFF, and a run of 40
+ * ASCII units. The same text is encoded as UTF-16 and as UTF-32:
+ *
+ *  reference       every path the CPU runs (scalar, SSE2, AVX2) gives the
+ *                  bytes of a plain decode to code points (a surrogate pair
+ *                  one, anything else invalid U+FFFD) and encode of each
+ *
+ *  bounded         no more than UTF8_MAX_BYTES a unit are written, into a
+ *                  buffer of exactly that size
+ *
+ *  append          AppendUtf8 keeps what the buffer held (used again for
+ *                  each input) and adds the reference's bytes, as does
+ *                  NarrowString
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#include <memory>
+#include "fuzz.h"
+#include <utf8.h>
+#include <utility_functions.h>
+
+
+// ------------------------------- Reference ------------------------------- //
+template <class U>
+string Reference(const vector<U>& units) {
+  vector<uint32_t> points;
+  for (size_t i = 0; i < units.size(); i++) {
+    uint32_t c = units[i];
+    bool high = c >= 0xD800 && c < 0xDC00;
+    bool low  = c >= 0xDC00 && c < 0xE000;
+    if (sizeof(U) == 2 && high && i + 1 < units.size() &&
+        units[i + 1] >= 0xDC00 && units[i + 1] < 0xE000)
+      points.push_back(0x10000 + (c - 0xD800) * 0x400 +
+                       (units[++i] - 0xDC00));
+    else
+      points.push_back(high || low || c > 0x10FFFF ? 0xFFFD : c);
+  }
+
+  string bytes;
+  for (uint32_t c : points) {
+    int extra = c < 0x80 ? 0 : c < 0x800 ? 1 : c < 0x10000 ? 2 : 3;
+    const uint8_t lead[] = {0x00, 0xC0, 0xE0, 0xF0};
+    bytes += (char)(lead[extra] | (c >> (6 * extra)));
+    for (int k = extra - 1; k >= 0; k--)
+      bytes += (char)(0x80 | ((c >> (6 * k)) & 0x3F));
+  }
+  return bytes;
+}
+
+template <class U>
+void CheckPaths(const vector<U>& units) {
+  string expected = Reference(units);
+
+  vector<Utf8Path> paths = {UTF8_SCALAR};
+  if (Utf8Best() != UTF8_SCALAR)
+    paths.push_back(UTF8_SSE2);
+  if (Utf8Best() == UTF8_AVX2)
+    paths.push_back(UTF8_AVX2);
+
+  for (Utf8Path path : paths) {
+    // ---------- Bounded ---------- //
+    size_t room = units.size() * UTF8_MAX_BYTES(U);
+    unique_ptr<char[]> buffer(new char[room]);
+    size_t written = EncodeUtf8(units.data(), units.size(), buffer.get(),
+                                path);
+    FUZZ_CHECK(written <= room);
+
+    // ---------- Reference ---------- //
+    FUZZ_CHECK(string(buffer.get(), written) == expected);
+  }
+}
+
+
+// -------------------------------- Target --------------------------------- //
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  vector<char32_t> units;
+  for (size_t i = 0; i < size; i++) {
+    uint8_t b = data[i];
+    if (b < 0xC0)
+      units.push_back(b & 0x7F);
+    else if (b < 0xD0)
+      units.push_back(0x80 + (b & 0x0F) * 0x70);         // 2 bytes
+    else if (b < 0xE0)
+      units.push_back(0x800 + (b & 0x0F) * 0xF00);       // 3 bytes
+    else if (b < 0xE8)
+      units.push_back(0xD800 + (b & 0x07) * 0x7F);       // high
+    else if (b < 0xF0)
+      units.push_back(0xDC00 + (b & 0x07) * 0x7F);       // low
+    else if (b < 0xF8)
+      units.push_back(0x10000 + (b & 0x07) * 0x1FFFF);   // 4 bytes
+    else if (b < 0xFC)
+      units.push_back(b & 1 ? 0x110000 : 0x80000000);     // invalid
+    else
+      units.insert(units.end(), 40, (char32_t)('a' + (b & 3)));
+  }
+
+  // As UTF-16, characters past U+FFFF as their pairs
+  vector<char16_t> utf16;
+  for (char32_t c : units)
+    if (c >= 0x10000 && c <= 0x10FFFF) {
+      utf16.push_back((char16_t)(0xD800 + ((c - 0x10000) >> 10)));
+      utf16.push_back((char16_t)(0xDC00 + ((c - 0x10000) & 0x3FF)));
+    }
+    else
+      utf16.push_back((char16_t)(c > 0xFFFF ? 0xFFFF : c));
+
+  CheckPaths(units);
+  CheckPaths(utf16);
+
+  // ---------- Append ---------- //
+  static string buffer;
+  wstring wide;
+  if (sizeof(wchar_t) == 2)
+    wide.assign(utf16.begin(), utf16.end());
+  else
+    wide.assign(units.begin(), units.end());
+  string expected = sizeof(wchar_t) == 2 ? Reference(utf16) :
+    Reference(units);
+  string before = buffer = "> ";
+  AppendUtf8(wide, buffer);
+  FUZZ_CHECK(buffer == before + expected);
+  FUZZ_CHECK(NarrowString(wide) == expected);
+  return 0;
+}
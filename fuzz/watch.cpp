@@ -0,0 +1,140 @@
+// ------------------------------------------------------------------------- //
+// Watch Coalescing Fuzz Target                                              //
+// ------------------------------------------------------------------------- //
+/**@file    WATCH.CPP
+ * @brief   Fuzzes coalescing change events with synthetic event streams
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * The input, two bytes an event, is a stream of changes to a small tree of
+ * paths, lost events and checks for a batch, each some time after the last
+ * (0 - 1.5 s, so bursts as well as trickles). Kept alongside is what the
+ * ChangeCoalescer must make of it:
+ *
+ *  due             a batch is taken exactly once QUIET has passed since the
+ *                  last change, or MAX_WAIT since the first
+ *
+ *  complete        the batch is every path changed since the last, each
+ *                  once, less those under another, or a rescan if any event
+ *                  was lost
+ *
+ *  empty           nothing is pending after a batch is taken
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#include <set>
+#include "fuzz.h"
+#include <watch.h>
+
+#define QUIET       chrono::milliseconds(500)
+#define MAX_WAIT    chrono::milliseconds(5000)
+
+typedef ChangeCoalescer::time_point time_point;
+
+const char* PATHS[] = {
+  "/src", "/src/a", "/src/a/b", "/src/a/b/c.exe", "/src/a/d.exe",
+  "/src/a/b/", "/src/./a/e.exe", "/src/a/b/../f.exe", "/src/g", "/src/g/h",
+  "/src/ab", "/src/ab/i.exe", "/other/j.exe", "k.exe", "l/m.exe", "l",
+};
+const size_t PATH_COUNT = sizeof(PATHS) / sizeof(PATHS[0]);
+
+
+// By components, so "/src/ab" is not under "/src/a"
+bool IsAncestor(const filesystem::path& a, const filesystem::path& b) {
+  auto ai = a.begin(), bi = b.begin();
+  for (; ai != a.end() && bi != b.end(); ++ai, ++bi)
+    if (*ai != *bi)
+      return false;
+  return ai == a.end() && bi != b.end();
+}
+
+filesystem::path Normal(const char* path) {
+  filesystem::path normal = filesystem::path(path).lexically_normal();
+  if (!normal.has_filename() && normal.has_relative_path())
+    normal = normal.parent_path();
+  return normal;
+}
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  ChangeCoalescer changes(QUIET, MAX_WAIT);
+  time_point      now;
+  time_point      first, last;
+  set<filesystem::path> changed;        // since the last batch
+  bool            lost = false;
+  bool            pending = false;
+
+  for (size_t i = 0; i <= size; i += 2) {
+    // A last check once the stream ends, late enough for any batch
+    bool     end = i + 1 >= size;
+    uint8_t  op  = end ? 7 : data[i] % 8;
+    uint8_t  arg = end ? 0 : data[i + 1];
+    now += end ? MAX_WAIT : chrono::milliseconds(50 * (data[i] >> 3));
+
+    if (op <= 5) {
+      if (!pending)
+        first = now;
+      last    = now;
+      pending = true;
+      if (op == 5) {
+        changes.overflow(now);
+        lost = true;
+      }
+      else {
+        changes.add(PATHS[arg % PATH_COUNT], now);
+        changed.insert(Normal(PATHS[arg % PATH_COUNT]));
+      }
+      FUZZ_CHECK(changes.pending());
+      continue;
+    }
+
+    // ---------- Due ---------- //
+    FUZZ_CHECK(changes.pending() == pending);
+    time_point due = pending ? min(last + QUIET, first + MAX_WAIT) :
+      time_point::max();
+    FUZZ_CHECK(changes.due() == due);
+
+    vector<filesystem::path> batch;
+    bool                     all;
+    bool                     taken = changes.take(now, batch, all);
+    FUZZ_CHECK(taken == (pending && now >= due));
+    if (!taken)
+      continue;
+
+    // ---------- Complete ---------- //
+    FUZZ_CHECK(all == lost);
+    vector<filesystem::path> expected;
+    if (!lost)
+      for (auto& path : changed)
+        if (none_of(changed.begin(), changed.end(),
+                    [&](const filesystem::path& other) {
+                      return IsAncestor(other, path);
+                    }))
+          expected.push_back(path);
+    FUZZ_CHECK(batch == expected);
+
+    // ---------- Empty ---------- //
+    FUZZ_CHECK(!changes.pending());
+    FUZZ_CHECK(changes.due() == time_point::max());
+    FUZZ_CHECK(!changes.take(now + MAX_WAIT, batch, all) && batch.empty());
+    changed.clear();
+    lost    = false;
+    pending = false;
+  }
+  return 0;
+}
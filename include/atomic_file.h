@@ -0,0 +1,316 @@
+// ------------------------------------------------------------------------- //
+// Atomic File Replacement                                                   //
+// ------------------------------------------------------------------------- //
+/**@file    ATOMIC_FILE.H
+ * @brief   Writes a file under a temporary name and renames it over the old
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * The generator builds a shim in a temporary file next to it, which only
+ * replaces the shim once complete. Anything launching the shim meanwhile sees
+ * the old one or the new one, and a generator killed halfway leaves the old
+ * one (and its temporary file, .<name>.<pid>.tmp) rather than half a shim.
+ *
+ * With SYNC, COMMIT also makes the replacement durable: the file is flushed
+ * before the rename, and on POSIX the directory after it. The directory
+ * flushes of generators run at once (e.g. one per executable from a script)
+ * are grouped through SYNC_FILE_NAME in the directory, a ticket and a
+ * counter:
+ *
+ *  requested   taken by each generator after its rename
+ *  synced      the last ticket a directory flush has covered
+ *
+ * Whoever flushes covers every ticket taken before it starts, so the rest,
+ * waiting on it, find theirs covered and return without flushing again. On
+ * Windows MOVEFILE_WRITE_THROUGH flushes the rename itself.
+ *
+ * What is written through WRITE (rather than to PATH by other means) is
+ * hashed on the way, its SHA-256 known at COMMIT without reading it back.
+ *
+ * UpdateFile does the same for files that every run adds to (the metrics and
+ * the manifest), read, changed and replaced under a lock on FILE.lock.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef ATOMIC_FILE_H
+#define ATOMIC_FILE_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+#include <sha256.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#endif
+
+using namespace std;
+
+#define SYNC_FILE_NAME      ".shim_exec.sync"
+
+
+// ---------------------------- Flush to Disk ------------------------------ //
+#ifdef _WIN32
+bool SyncFile(const filesystem::path& path) {
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  bool synced = FlushFileBuffers(file);
+  CloseHandle(file);
+  return synced;
+}
+
+// The rename was written through (MOVEFILE_WRITE_THROUGH)
+bool SyncDirectory(const filesystem::path& dir) {
+  return true;
+}
+
+#else
+bool SyncFile(const filesystem::path& path, int flags = O_RDONLY) {
+  int file = ::open(path.c_str(), flags | O_CLOEXEC);
+  if (file < 0)
+    return false;
+  bool synced = fsync(file) == 0;
+  ::close(file);
+  return synced;
+}
+
+/**@brief  Flush DIR once for all the generators waiting to
+ *
+ * Falls back to flushing DIR alone if SYNC_FILE_NAME cannot be used (e.g. a
+ * read-only directory, or a file system without locks).
+ */
+bool SyncDirectory(const filesystem::path& dir) {
+  int file = ::open((dir / SYNC_FILE_NAME).c_str(),
+                    O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+  if (file < 0)
+    return SyncFile(dir, O_RDONLY | O_DIRECTORY);
+
+  // Byte 0 guards the counters, byte 1 the flush
+  auto lock = [&](off_t byte, short type) {
+    struct flock region = {};
+    region.l_type   = type;
+    region.l_whence = SEEK_SET;
+    region.l_start  = byte;
+    region.l_len    = 1;
+    return fcntl(file, F_SETLKW, &region) == 0;
+  };
+  uint64_t counters[2];               // requested, synced
+  auto update = [&](auto change) {
+    if (!lock(0, F_WRLCK))
+      return false;
+    if (pread(file, counters, sizeof(counters), 0) != sizeof(counters))
+      counters[0] = counters[1] = 0;
+    bool changed = change() &&
+      pwrite(file, counters, sizeof(counters), 0) == sizeof(counters);
+    lock(0, F_UNLCK);
+    return changed;
+  };
+
+  uint64_t ticket = 0;
+  bool     synced = update([&] { ticket = ++counters[0]; return true; }) &&
+    lock(1, F_WRLCK);
+  if (synced) {
+    uint64_t covers = 0;
+    update([&] { covers = counters[0]; return false; });
+    if (counters[1] < ticket) {
+      synced = SyncFile(dir, O_RDONLY | O_DIRECTORY);
+      if (synced)
+        update([&] { counters[1] = max(counters[1], covers); return true; });
+    }
+    lock(1, F_UNLCK);
+  }
+  else
+    synced = SyncFile(dir, O_RDONLY | O_DIRECTORY);
+  ::close(file);                      // releases the locks
+  return synced;
+}
+#endif
+
+
+// --------------------------- Replace Atomically -------------------------- //
+// Written to PATH, which replaces the target once COMMIT is called, or is
+// removed if it never is
+class AtomicFile {
+public:
+  const filesystem::path& begin(const filesystem::path& target_path) {
+    target = target_path;
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = getpid();
+#endif
+    filesystem::path name = ".";
+    name += target.filename();
+    name += "." + to_string(pid) + ".tmp";
+    temp = target.parent_path() / name;
+    error_code ec;
+    filesystem::remove(temp, ec);
+    return temp;
+  }
+
+  const filesystem::path& path() const {
+    return temp;
+  }
+
+  // Append to PATH, hashing the bytes as they go
+  bool write(const char* data, size_t size) {
+    if (!out.is_open())
+      out.open(temp, ios::binary | ios::trunc);
+    out.write(data, size);
+    hash.update(data, size);
+    written += size;
+    return (bool)out;
+  }
+
+  // The SHA-256 and size of what WRITE wrote, once committed
+  const string& digest() const {
+    return sha256;
+  }
+
+  uint64_t size() const {
+    return written;
+  }
+
+  /**@brief  Replace the target with PATH
+   *
+   * @param  sync   flush it to disk first, and the rename after
+   * @return FALSE if the target was not replaced, or with SYNC not flushed
+   */
+  bool commit(bool sync = false) {
+    if (out.is_open()) {
+      out.close();
+      if (!out)
+        return false;
+      sha256 = hash.finish();
+    }
+    if (temp.empty() || (sync && !SyncFile(temp)))
+      return false;
+
+#ifdef _WIN32
+    DWORD flags = MOVEFILE_REPLACE_EXISTING |
+      (sync ? MOVEFILE_WRITE_THROUGH : 0);
+    bool replaced = MoveFileExW(temp.c_str(), target.c_str(), flags);
+
+    // A running shim cannot be replaced, but it can be moved aside, and
+    // removed now or (if it is still running) at the next reboot
+    if (!replaced && GetFileAttributesW(target.c_str()) !=
+        INVALID_FILE_ATTRIBUTES) {
+      filesystem::path aside = ".";
+      aside += target.filename();
+      aside = target.parent_path() / (aside += ".old");
+      DeleteFileW(aside.c_str());
+      if (MoveFileExW(target.c_str(), aside.c_str(), flags)) {
+        replaced = MoveFileExW(temp.c_str(), target.c_str(), flags);
+        if (!replaced)
+          MoveFileExW(aside.c_str(), target.c_str(), flags);
+        else if (!DeleteFileW(aside.c_str()))
+          MoveFileExW(aside.c_str(), nullptr, MOVEFILE_DELAY_UNTIL_REBOOT);
+      }
+    }
+#else
+    bool replaced = ::rename(temp.c_str(), target.c_str()) == 0;
+#endif
+    if (!replaced)
+      return false;
+    temp.clear();
+    return !sync || SyncDirectory(target.parent_path());
+  }
+
+  ~AtomicFile() {
+    out.close();
+    error_code ec;
+    if (!temp.empty())
+      filesystem::remove(temp, ec);
+  }
+
+private:
+  filesystem::path  target;
+  filesystem::path  temp;
+  ofstream          out;
+  Sha256            hash;
+  string            sha256;
+  uint64_t          written =   0;
+};
+
+
+// ------------------------------- Add To ---------------------------------- //
+/**@brief  Replace FILE with what UPDATE makes of its contents
+ *
+ * @param  FILE:    read as empty if it does not exist yet
+ * @param  UPDATE:  given the contents, returns the new ones
+ *
+ * @return FALSE if FILE could not be locked or replaced
+ */
+bool UpdateFile(const filesystem::path& file,
+                const function<string(const string&)>& update) {
+  filesystem::path lock_file = file;
+  lock_file += ".lock";
+
+#ifdef _WIN32
+  HANDLE lock = CreateFileW(
+      lock_file.c_str(), GENERIC_READ | GENERIC_WRITE,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+      OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (lock == INVALID_HANDLE_VALUE)
+    return false;
+  OVERLAPPED region = {};
+  LockFileEx(lock, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &region);
+#else
+  int lock = ::open(lock_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+  if (lock < 0 || flock(lock, LOCK_EX) != 0) {
+    if (lock >= 0)
+      ::close(lock);
+    return false;
+  }
+#endif
+
+  ifstream current(file, ios::binary);
+  string   text = update(string(istreambuf_iterator<char>(current),
+                                istreambuf_iterator<char>()));
+  current.close();
+
+  AtomicFile replacement;
+  ofstream   out(replacement.begin(file), ios::binary | ios::trunc);
+  out << text;
+  out.close();
+  bool updated = out && replacement.commit();
+
+#ifdef _WIN32
+  UnlockFileEx(lock, 0, MAXDWORD, MAXDWORD, &region);
+  CloseHandle(lock);
+#else
+  ::close(lock);                        // releases the lock
+#endif
+  return updated;
+}
+
+
+// ------------------------------------------------------------------------- //
+#endif  // ATOMIC_FILE_H
@@ -0,0 +1,412 @@
+// ------------------------------------------------------------------------- //
+// ELF Shim Configuration                                                    //
+// ------------------------------------------------------------------------- //
+/**@file    ELF_CONFIG.H
+ * @brief   Reads and patches the configuration embedded in an ELF shim
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * ELF has no resources, so the shim reserves a fixed size block in its own
+ * section (SHIM_CONFIG_SECTION) holding the same NAME = VALUE text as the
+ * .shim sidecar file:
+ *
+ *     magic   "SHIM-CONFIG-V1"  (16 bytes, identifies an unpatched block)
+ *     size    bytes of text (32 bit, in the byte order of the file)
+ *     data    the first SHIM_CONFIG_CAPACITY bytes of it
+ *
+ * and text longer than the block (e.g. --command @FILE) has the rest at the
+ * very end of the file, past everything the loader maps, so only a shim of
+ * such a configuration reads its own file to get it. Up to SHIM_CONFIG_MAX
+ * bytes are written.
+ *
+ * The generator finds the section through the section headers and
+ * overwrites SIZE and DATA in place, so nothing else in the file moves and
+ * no linker or objcopy is needed. Only the standard library is used and
+ * 32/64 bit, little/big endian files are all handled, hence an ELF shim can
+ * be patched on any platform.
+ *
+ *  IsElfFile
+ *      checks the file starts with the ELF magic
+ *
+ *  ReadElfConfig / WriteElfConfig
+ *      gets / replaces the text in the block
+ *
+ *  PatchElfConfig
+ *      replaces it in a shim already open (or in memory)
+ *
+ *  CopyElfShim
+ *      writes a copy of a shim (e.g. the template) with the text replaced,
+ *      start to end in one pass, for the bytes to be hashed as they go out
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef ELF_CONFIG_H
+#define ELF_CONFIG_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <fstream>
+#include <algorithm>
+#include <streambuf>
+#include <functional>
+#include <filesystem>
+
+#define SHIM_CONFIG_SECTION     ".shim_config"
+#define SHIM_CONFIG_MAGIC       "SHIM-CONFIG-V1"
+#define SHIM_CONFIG_CAPACITY    4096
+#define SHIM_CONFIG_MAX         (16 * 1024 * 1024)
+
+using namespace std;
+
+struct ShimConfigBlock {
+  char      magic[16];
+  uint32_t  size;
+  char      data[SHIM_CONFIG_CAPACITY];
+};
+
+
+// ----------------------------- Memory Stream ----------------------------- //
+/**@brief  Reads bytes in memory as a file, without copying them
+ *
+ * For a shim linked into the generator (its template), which ElfReader then
+ * reads like any other. Writing to it fails.
+ */
+class MemoryStream : private streambuf, public iostream {
+public:
+  MemoryStream(const char* data, size_t size) : iostream(this) {
+    char* start = const_cast<char*>(data);
+    setg(start, start, start + size);
+  }
+
+protected:
+  streampos seekoff(streamoff off, ios_base::seekdir dir,
+                    ios_base::openmode which) override {
+    streamoff at = off + (dir == ios_base::cur ? gptr() - eback() :
+                         dir == ios_base::end ? egptr() - eback() : 0);
+    if (!(which & ios_base::in) || at < 0 || at > egptr() - eback())
+      return streampos(streamoff(-1));
+    setg(eback(), eback() + at, egptr());
+    return streampos(at);
+  }
+
+  streampos seekpos(streampos pos, ios_base::openmode which) override {
+    return seekoff(streamoff(pos), ios_base::beg, which);
+  }
+};
+
+
+// ------------------------------ ELF Headers ------------------------------ //
+/**@brief  Reads integers of the file's class and byte order
+ */
+class ElfReader {
+public:
+  ElfReader(iostream& file) : file(file) {}
+
+  bool      is64 =          false;
+  bool      big_endian =    false;
+
+  // Read and check the identification bytes
+  bool open() {
+    unsigned char ident[16] = {};
+    if (!read(0, ident, sizeof(ident)) || memcmp(ident, "\x7f" "ELF", 4))
+      return false;
+    if (ident[4] != 1 && ident[4] != 2)         // EI_CLASS
+      return false;
+    if (ident[5] != 1 && ident[5] != 2)         // EI_DATA
+      return false;
+    is64        = ident[4] == 2;
+    big_endian  = ident[5] == 2;
+    return true;
+  }
+
+  bool read(uint64_t offset, void* data, size_t size) {
+    file.clear();
+    file.seekg(offset);
+    file.read((char*)data, size);
+    return file.gcount() == (streamsize)size;
+  }
+
+  // Unsigned integer of SIZE bytes at OFFSET (0 if past the end)
+  uint64_t get(uint64_t offset, int size) {
+    unsigned char bytes[8] = {};
+    if (!read(offset, bytes, size))
+      return 0;
+
+    uint64_t value = 0;
+    for (int i = 0; i < size; i++)
+      value |= (uint64_t)bytes[big_endian ? size - 1 - i : i] << (8 * i);
+    return value;
+  }
+
+  // Size of an address / offset field
+  int word() {
+    return is64 ? 8 : 4;
+  }
+
+  // Length of the file
+  uint64_t length() {
+    file.clear();
+    file.seekg(0, ios::end);
+    streamoff end = file.tellg();
+    return end > 0 ? (uint64_t)end : 0;
+  }
+
+private:
+  iostream& file;
+};
+
+
+/**@brief  Find the file offset of the configuration block
+ *
+ * @param  ELF:     opened reader
+ * @param  OFFSET:  file offset of the block
+ *
+ * @return TRUE if the section exists, is big enough and holds a block
+ */
+bool FindElfConfig(ElfReader& elf, uint64_t& offset) {
+  // ELF header: e_shoff, e_shentsize, e_shnum, e_shstrndx
+  uint64_t shoff    = elf.get(elf.is64 ? 0x28 : 0x20, elf.word());
+  uint64_t shentsz  = elf.get(elf.is64 ? 0x3A : 0x2E, 2);
+  uint64_t shnum    = elf.get(elf.is64 ? 0x3C : 0x30, 2);
+  uint64_t shstrndx = elf.get(elf.is64 ? 0x3E : 0x32, 2);
+  if (shoff == 0 || shentsz == 0)
+    return false;
+
+  // Section header: sh_name, sh_type, sh_offset, sh_size
+  auto header = [&](uint64_t i) { return shoff + i * shentsz; };
+  auto type   = [&](uint64_t i) { return elf.get(header(i) + 4, 4); };
+  auto start  = [&](uint64_t i) {
+    return elf.get(header(i) + (elf.is64 ? 0x18 : 0x10), elf.word());
+  };
+  auto size   = [&](uint64_t i) {
+    return elf.get(header(i) + (elf.is64 ? 0x20 : 0x14), elf.word());
+  };
+
+  // Too many sections for the header, the real values are in section 0
+  if (shnum == 0)
+    shnum = size(0);
+  if (shstrndx == 0xFFFF)
+    shstrndx = elf.get(header(0) + (elf.is64 ? 0x28 : 0x18), 4);
+  // Only as many as the file holds, a malformed count must not run for ever
+  uint64_t length = elf.length();
+  if (shoff >= length)
+    return false;
+  shnum = min(shnum, (length - shoff) / shentsz);
+  if (shstrndx >= shnum)
+    return false;
+
+  uint64_t names    = start(shstrndx);
+  uint64_t names_sz = size(shstrndx);
+  const char   wanted[] = SHIM_CONFIG_SECTION;
+
+  for (uint64_t i = 1; i < shnum; i++) {
+    uint64_t name = elf.get(header(i), 4);
+    if (name + sizeof(wanted) > names_sz)
+      continue;
+
+    // The name and its NUL, which a malformed file may not have
+    char found[sizeof(wanted)] = {};
+    if (!elf.read(names + name, found, sizeof(found)) ||
+        memcmp(found, wanted, sizeof(wanted)) != 0)
+      continue;
+
+    // Must have file contents (i.e. not SHT_NOBITS) to patch
+    if (type(i) == 8 || size(i) < sizeof(ShimConfigBlock))
+      return false;
+
+    char magic[16] = {};
+    offset = start(i);
+    return elf.read(offset, magic, sizeof(magic)) &&
+      memcmp(magic, SHIM_CONFIG_MAGIC, sizeof(SHIM_CONFIG_MAGIC)) == 0;
+  }
+  return false;
+}
+
+
+/**@brief  Find where the tail of the configuration text starts
+ *
+ * @param  OFFSET:  file offset of the block
+ * @param  SIZE:    bytes of text, as the block has it
+ *
+ * @return file offset of the tail (the end of the file if there is none),
+ *         0 if it would not fit between the block and the end
+ */
+uint64_t FindElfConfigTail(ElfReader& elf, uint64_t offset, uint64_t size) {
+  uint64_t tail   = size > SHIM_CONFIG_CAPACITY ?
+    size - SHIM_CONFIG_CAPACITY : 0;
+  uint64_t length = elf.length();
+  if (size > SHIM_CONFIG_MAX || tail > length ||
+      length - tail < offset + sizeof(ShimConfigBlock))
+    return 0;
+  return length - tail;
+}
+
+
+/**@brief  The SIZE and DATA fields of a block holding TEXT (which follow
+ *         each other), in the file's byte order
+ */
+string FormatElfConfigBlock(ElfReader& elf, const string& text) {
+  string block(sizeof(uint32_t), '\0');
+  for (int i = 0; i < 4; i++)
+    block[elf.big_endian ? 3 - i : i] = (char)(text.size() >> (8 * i));
+
+  // Zero the rest so a shorter configuration leaves nothing behind
+  block.append(text, 0, SHIM_CONFIG_CAPACITY);
+  block.resize(sizeof(uint32_t) + SHIM_CONFIG_CAPACITY, '\0');
+  return block;
+}
+
+
+// -------------------------------- Public --------------------------------- //
+bool IsElfFile(const filesystem::path& path) {
+  fstream   file(path, ios::in | ios::binary);
+  ElfReader elf(file);
+  return file && elf.open();
+}
+
+
+/**@brief  Get the configuration text of an ELF shim
+ *
+ * @param  FILE:    shim (e.g. a stringstream of one in memory)
+ * @param  TEXT:    configuration (empty if never patched)
+ *
+ * @return TRUE if FILE is an ELF shim
+ */
+bool ReadElfConfig(iostream& file, string& text) {
+  ElfReader elf(file);
+  uint64_t  offset;
+  if (!file || !elf.open() || !FindElfConfig(elf, offset))
+    return false;
+
+  uint64_t size = elf.get(offset + offsetof(ShimConfigBlock, size), 4);
+  uint64_t tail = FindElfConfigTail(elf, offset, size);
+  if (tail == 0)
+    return false;
+
+  uint64_t head = min<uint64_t>(size, SHIM_CONFIG_CAPACITY);
+  text.assign(size, '\0');
+  return elf.read(offset + offsetof(ShimConfigBlock, data), &text[0], head) &&
+    elf.read(tail, &text[0] + head, size - head);
+}
+
+bool ReadElfConfig(const filesystem::path& path, string& text) {
+  fstream file(path, ios::in | ios::binary);
+  return ReadElfConfig(file, text);
+}
+
+
+/**@brief  Replace the configuration text of an ELF shim
+ *
+ * @param  FILE:    shim, read and written in place (e.g. a stringstream of
+ *                  one in memory)
+ * @param  TEXT:    configuration, at most SHIM_CONFIG_MAX bytes
+ * @param  LENGTH:  what the file is to be cut to, its new tail replacing the
+ *                  old, which a stream cannot do itself
+ *
+ * @return TRUE if written
+ */
+bool PatchElfConfig(iostream& file, const string& text,
+                    uint64_t* length = nullptr) {
+  ElfReader elf(file);
+  uint64_t  offset;
+  if (!file || !elf.open() || !FindElfConfig(elf, offset))
+    return false;
+  if (text.size() > SHIM_CONFIG_MAX)
+    return false;
+
+  uint64_t old  = elf.get(offset + offsetof(ShimConfigBlock, size), 4);
+  uint64_t tail = FindElfConfigTail(elf, offset, old);
+  if (tail == 0)
+    return false;
+
+  string block = FormatElfConfigBlock(elf, text);
+  size_t head  = min<size_t>(text.size(), SHIM_CONFIG_CAPACITY);
+
+  file.clear();
+  file.seekp(offset + offsetof(ShimConfigBlock, size));
+  file.write(block.data(), block.size());
+  file.seekp(tail);
+  file.write(text.data() + head, text.size() - head);
+  file.flush();
+  if (length)
+    *length = tail + text.size() - head;
+  return (bool)file;
+}
+
+/**@brief  Write a copy of an ELF shim with its configuration text replaced
+ *
+ * What PatchElfConfig and cutting the file would make of a copy, but written
+ * from start to end, each byte once, so that they can be hashed as they go.
+ *
+ * @param  IMAGE:   shim to copy (e.g. a MemoryStream of the template)
+ * @param  TEXT:    configuration, at most SHIM_CONFIG_MAX bytes
+ * @param  WRITE:   given the copy a piece at a time, FALSE to stop
+ *
+ * @return TRUE if all of it was written
+ */
+bool CopyElfShim(iostream& image, const string& text,
+                 const function<bool(const char*, size_t)>& write) {
+  ElfReader elf(image);
+  uint64_t  offset;
+  if (!image || !elf.open() || !FindElfConfig(elf, offset))
+    return false;
+  if (text.size() > SHIM_CONFIG_MAX)
+    return false;
+
+  uint64_t old  = elf.get(offset + offsetof(ShimConfigBlock, size), 4);
+  uint64_t tail = FindElfConfigTail(elf, offset, old);
+  if (tail == 0)
+    return false;
+
+  // The image from FROM up to TO
+  string chunk(64 * 1024, '\0');
+  auto copy = [&](uint64_t from, uint64_t to) {
+    for (uint64_t n; from < to; from += n) {
+      n = min<uint64_t>(to - from, chunk.size());
+      if (!elf.read(from, &chunk[0], n) || !write(chunk.data(), n))
+        return false;
+    }
+    return true;
+  };
+
+  string   block = FormatElfConfigBlock(elf, text);
+  uint64_t start = offset + offsetof(ShimConfigBlock, size);
+  size_t   head  = min<size_t>(text.size(), SHIM_CONFIG_CAPACITY);
+  return copy(0, start) && write(block.data(), block.size()) &&
+    copy(start + block.size(), tail) &&
+    write(text.data() + head, text.size() - head);
+}
+
+bool WriteElfConfig(const filesystem::path& path, const string& text) {
+  fstream  file(path, ios::in | ios::out | ios::binary);
+  uint64_t length;
+  if (!PatchElfConfig(file, text, &length))
+    return false;
+  file.close();
+
+  error_code ec;
+  filesystem::resize_file(path, length, ec);
+  return !ec;
+}
+
+
+// ------------------------------------------------------------------------- //
+#endif  // ELF_CONFIG_H
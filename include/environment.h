@@ -0,0 +1,306 @@
+// ------------------------------------------------------------------------- //
+// Environment Overrides                                                     //
+// ------------------------------------------------------------------------- //
+/**@file    ENVIRONMENT.H
+ * @brief   Builds the application's environment from the shim's own and the
+ *          overrides embedded in it
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * The generator embeds overrides (--env, --env-prepend, --env-append) as
+ * SHIM_ENV, one per line:
+ *
+ *     set JAVA_HOME=C:\jdk             replace (or remove, if VALUE is empty)
+ *     prepend PATH=C:\jdk\bin          VALUE + separator + current value
+ *     append PATH=C:\tools             current value + separator + VALUE
+ *
+ * where the separator is that of PATH on the platform (; or :).
+ *
+ *  ParseEnvOverrides / FormatEnvOverride
+ *      reads / writes SHIM_ENV
+ *
+ *  BuildEnvironment
+ *      merges the overrides into the shim's environment, producing the block
+ *      the application is started with: NAME=VALUE entries, each ending in
+ *      NUL, sorted by name (case-insensitively on Windows as CreateProcess
+ *      expects) and ending in an extra NUL. The overrides are sorted once
+ *      and merged with the (sorted) environment in a single pass, written
+ *      straight into a block allocated once at its largest possible size.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef ENVIRONMENT_H
+#define ENVIRONMENT_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sstream>
+#include <cwchar>
+#include <cwctype>
+#include <algorithm>
+#include <utility_functions.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef wchar_t EnvChar;
+#define ENV_LIST_SEPARATOR  L';'
+#else
+extern char** environ;
+typedef char EnvChar;
+#define ENV_LIST_SEPARATOR  ':'
+#endif
+
+typedef basic_string<EnvChar>       EnvString;
+typedef basic_string_view<EnvChar>  EnvView;
+
+using namespace std;
+
+
+// ------------------------------- Overrides ------------------------------- //
+enum EnvOp { ENV_SET, ENV_PREPEND, ENV_APPEND };
+
+struct EnvOverride {
+  EnvOp     op =            ENV_SET;
+  EnvString name;
+  EnvString value;
+};
+
+
+EnvString ToEnvString(const wstring& s) {
+#ifdef _WIN32
+  return s;
+#else
+  return NarrowString(s);
+#endif
+}
+
+wstring FromEnvString(const EnvString& s) {
+#ifdef _WIN32
+  return s;
+#else
+  return WidenString(s);
+#endif
+}
+
+
+/**@brief  One line of SHIM_ENV
+ *
+ * @param  OP:      ENV_SET, ENV_PREPEND or ENV_APPEND
+ * @param  SETTING: NAME=VALUE
+ *
+ * @return the line, or empty if SETTING has no name
+ */
+wstring FormatEnvOverride(EnvOp op, const wstring& setting) {
+  size_t eq = setting.find(L'=');
+  if (eq == 0 || eq == wstring::npos)
+    return L"";
+
+  return wstring(op == ENV_PREPEND ? L"prepend " :
+                 op == ENV_APPEND  ? L"append "  : L"set ") + setting;
+}
+
+
+/**@brief  Read SHIM_ENV, skipping any line that is not understood
+ */
+vector<EnvOverride> ParseEnvOverrides(const wstring& text) {
+  vector<EnvOverride> overrides;
+  wistringstream lines(text);
+  wstring line;
+  while (getline(lines, line)) {
+    size_t space = line.find(L' ');
+    size_t eq    = line.find(L'=', space + 1);
+    if (space == wstring::npos || eq == wstring::npos || eq == space + 1)
+      continue;
+
+    EnvOverride entry;
+    wstring op = line.substr(0, space);
+    if (op == L"prepend")
+      entry.op = ENV_PREPEND;
+    else if (op == L"append")
+      entry.op = ENV_APPEND;
+    else if (op != L"set")
+      continue;
+
+    entry.name  = ToEnvString(line.substr(space + 1, eq - space - 1));
+    entry.value = ToEnvString(line.substr(eq + 1));
+    overrides.push_back(entry);
+  }
+  return overrides;
+}
+
+
+// ---------------------------- Sorting Names ------------------------------ //
+// Name of a NAME=VALUE entry (Windows' hidden "=C:=C:\dir" entries included)
+EnvView EnvName(EnvView entry) {
+  size_t eq = entry.find('=', 1);
+  return entry.substr(0, eq == EnvView::npos ? entry.size() : eq);
+}
+
+// <0, 0, >0 as A sorts before, with or after B
+int EnvCompare(EnvView a, EnvView b) {
+  size_t n = min(a.size(), b.size());
+  for (size_t i = 0; i < n; i++) {
+#ifdef _WIN32
+    wint_t ca = towupper(a[i]), cb = towupper(b[i]);
+#else
+    unsigned char ca = a[i], cb = b[i];
+#endif
+    if (ca != cb)
+      return ca < cb ? -1 : 1;
+  }
+  return a.size() == b.size() ? 0 : a.size() < b.size() ? -1 : 1;
+}
+
+
+// -------------------------------- Block ---------------------------------- //
+struct EnvironmentBlock {
+  EnvString         block;              // NAME=VALUE\0 ... \0
+  vector<EnvChar*>  envp;               // entries of BLOCK, then nullptr
+
+  bool empty() const {
+    return block.empty();
+  }
+};
+
+
+/**@brief  The environment for the application
+ *
+ * @param  OVERRIDES:   from SHIM_ENV
+ *
+ * @return the merged block, or an empty one if there is nothing to override
+ *         (i.e. the application simply inherits the shim's)
+ */
+EnvironmentBlock BuildEnvironment(vector<EnvOverride> overrides) {
+  EnvironmentBlock env;
+  if (overrides.empty())
+    return env;
+
+  // Later overrides of the same name apply after earlier ones
+  stable_sort(overrides.begin(), overrides.end(),
+              [](const EnvOverride& a, const EnvOverride& b) {
+                return EnvCompare(a.name, b.name) < 0;
+              });
+
+  // Largest it can grow to: every entry kept, every override adding to one
+  size_t size = 1;
+  for (auto& o : overrides)
+    size += o.name.size() + o.value.size() + 3;
+
+#ifdef _WIN32
+  wchar_t* strings = GetEnvironmentStringsW();
+  vector<EnvView> current;
+  for (wchar_t* s = strings; s && *s; s += wcslen(s) + 1)
+    current.push_back(EnvView(s));
+#else
+  vector<EnvView> current;
+  for (char** e = environ; *e; e++)
+    current.push_back(EnvView(*e));
+#endif
+  for (auto& entry : current)
+    size += entry.size() + 1;
+
+  auto by_name = [](EnvView a, EnvView b) {
+    return EnvCompare(EnvName(a), EnvName(b)) < 0;
+  };
+  if (!is_sorted(current.begin(), current.end(), by_name))
+    stable_sort(current.begin(), current.end(), by_name);
+
+  env.block.reserve(size);
+  EnvString& out = env.block;
+
+  // Merge the two sorted lists
+  size_t i = 0, j = 0;
+  while (i < current.size() || j < overrides.size()) {
+    int order = i == current.size() ? 1 : j == overrides.size() ? -1 :
+      EnvCompare(EnvName(current[i]), overrides[j].name);
+
+    if (order < 0) {
+      out.append(current[i++]);
+      out.push_back('\0');
+      continue;
+    }
+
+    // All overrides of this name, applied to its current value (if any)
+    size_t  end = j;
+    while (end < overrides.size() &&
+           EnvCompare(overrides[end].name, overrides[j].name) == 0)
+      end++;
+
+    EnvView name  = overrides[j].name;
+    EnvView value;
+    if (order == 0) {
+      name  = EnvName(current[i]);
+      value = current[i].substr(min(name.size() + 1, current[i].size()));
+      i++;
+    }
+
+    // Only what follows the last SET builds on the current value
+    size_t base = j;
+    for (size_t k = j; k < end; k++)
+      if (overrides[k].op == ENV_SET) {
+        base  = k + 1;
+        value = overrides[k].value;
+      }
+
+    // PREPENDs in reverse, the value, then APPENDs in order
+    size_t  start = out.size();
+    out.append(name);
+    out.push_back('=');
+    size_t  before = out.size();
+    auto    add = [&](EnvView part) {
+      if (part.empty())
+        return;
+      if (out.size() > before)
+        out.push_back(ENV_LIST_SEPARATOR);
+      out.append(part);
+    };
+    for (size_t k = end; k-- > base; )
+      if (overrides[k].op == ENV_PREPEND)
+        add(overrides[k].value);
+    add(value);
+    for (size_t k = base; k < end; k++)
+      if (overrides[k].op == ENV_APPEND)
+        add(overrides[k].value);
+
+    // Empty means removed
+    if (out.size() == before)
+      out.resize(start);
+    else
+      out.push_back('\0');
+    j = end;
+  }
+  if (out.empty())
+    out.push_back('\0');               // an empty block is still two NULs
+  out.push_back('\0');
+
+#ifdef _WIN32
+  FreeEnvironmentStringsW(strings);
+#endif
+
+  // Pointers for execve and the like
+  for (size_t at = 0; out[at]; at += char_traits<EnvChar>::length(&out[at]) + 1)
+    env.envp.push_back(&out[at]);
+  env.envp.push_back(nullptr);
+  return env;
+}
+
+
+// ------------------------------------------------------------------------- //
+#endif  // ENVIRONMENT_H
@@ -26,13 +26,17 @@
 #define GET_ARGUMENTS_H
 
 // ------------------------------------------------------------------------- //
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <string>
 #include <regex>
 #include <vector>
+#include <cwchar>
+#include <algorithm>
 
-#define QUOTE_REGEX     L"((?:^|[^\\\\])(?:\\\\{2})*)\""
-#define WORD_REGEX      L"[^\\s=]+"
+// Characters separating the words of a command line
+#define ARGUMENT_GAPS   L" \t\n\v\f\r="
 
 using namespace std;
 
@@ -40,10 +44,14 @@ using namespace std;
 /**@brief  Splits a string into a list of arguments
  * 
  * In the simplest form this function splits a string at word boundaries (i.e.
- * \s) preserving the white spaces. The more complex cases arise with double
- * quotes which, if not escaped, denote a full argument. Escaped quotes and
- * quotes within words are ignored regardless. In all cases, the parsing is
- * lossless allowing reconstruction of the input.
+ * whitespace or equal signs) preserving the boundaries. The more complex cases
+ * arise with double quotes which, if not escaped, denote a full argument.
+ * Escaped quotes and quotes within words are ignored regardless. In all cases,
+ * the parsing is lossless allowing reconstruction of the input:
+ *  - arguments are at even indices, the whitespace between them at odd ones
+ *  - whitespace before the first argument is part of it
+ *  - whitespace after the last argument is the last element
+ *  - a quote left open runs to the end of the line
  *
  * Example:
  * 'arg1  arg2 "arg 3"   arg"4' -->
@@ -59,99 +67,121 @@ using namespace std;
  * 
  * @return vector of strings including the whitespaces
  */
-vector<wstring> ParseArguments (wstring arg_line) {
+vector<wstring> ParseArguments (const wstring& arg_line) {
   // Initialize the parsed list of strings to be returned
   vector<wstring>
     output          = {};
 
-  // Regex and Iterators
-  wregex
-    regex_word(WORD_REGEX),
-    regex_quote(QUOTE_REGEX);
+  auto is_gap = [](wchar_t c) {
+    return wcschr(ARGUMENT_GAPS, c) != nullptr && c != L'\0';
+  };
 
-  regex_iterator<wstring::iterator>
-    iter_word(arg_line.begin(), arg_line.end(), regex_word),
-    iter_quote(arg_line.begin(), arg_line.end(), regex_quote),
-    iter_end;
+  // A quote not escaped, i.e. after an even number of backslashes
+  auto is_quote = [&](size_t pos) {
+    size_t slashes = 0;
+    while (slashes < pos && arg_line[pos - slashes - 1] == L'\\')
+      slashes++;
+    return arg_line[pos] == L'"' && slashes % 2 == 0;
+  };
 
   // Cursor positions as we step through the string
-  wstring::size_type
-    // beginning of word
-    pos_word_0      = 0,
+  size_t
+    size            = arg_line.size(),
+    // beginning of argument (or of the whitespace before it)
+    pos_arg         = 0,
+    // beginning of the argument's first word
+    pos_first       = 0,
     // end of word
-    pos_word_1      = 0,
-    // beginning of quote
-    pos_quote       = iter_quote->position() + iter_quote->length() - 1;
-  
-  // Quote count (though mainly used to identify if within quotes)
-  int
-    cnt_quote       = 0;
-
-
-  // Iterate through each word
-  while(iter_word != iter_end) {
-    // If the beginning position is ahead of the end,
-    // its a whitespace so add it to the output
-    if(pos_word_1 < pos_word_0)
-      output.push_back(arg_line.substr(pos_word_1, pos_word_0 - pos_word_1));
-    
-    // Find end of this word 
-    pos_word_1 = iter_word->position() + iter_word->length();
-
-    // If the quote is within this word...
-    while(pos_word_0 <= pos_quote && pos_quote < pos_word_1 &&
-          iter_quote != iter_end) {
-
-      // Check if the quote is at the beginning or end of the word because
-      // *technically* you could have a quote in the middle of a word (who would
-      // do such a thing?!?!) in which case, we'll ignore
-      if (pos_word_0 == pos_quote || pos_quote == pos_word_1 - 1) cnt_quote++;
-
-      // Find the next quote position
-      // (which may still be within the current word)
-      iter_quote++;
-      pos_quote = iter_quote->position() + iter_quote->length() - 1;
+    pos_word_1      = 0;
+
+  bool
+    in_quotes       = false;
+
+  while (pos_word_1 < size) {
+    // Find the next word, if any
+    size_t pos_word_0 = pos_word_1;
+    while (pos_word_0 < size && is_gap(arg_line[pos_word_0]))
+      pos_word_0++;
+    if (pos_word_0 == size)
+      break;
+
+    // Starting a new argument, add the whitespace before it (unless it is the
+    // first argument, which keeps it)
+    if (!in_quotes) {
+      if (!output.empty()) {
+        output.push_back(arg_line.substr(pos_arg, pos_word_0 - pos_arg));
+        pos_arg = pos_word_0;
+      }
+      pos_first = pos_word_0;
     }
 
-    // Increment to the next word
-    iter_word++;
+    // Find end of this word 
+    pos_word_1 = pos_word_0;
+    while (pos_word_1 < size && !is_gap(arg_line[pos_word_1]))
+      pos_word_1++;
+
+    // Only quotes beginning the argument or ending a word count because
+    // *technically* you could have a quote in the middle of a word (who would
+    // do such a thing?!?!) in which case, we'll ignore
+    if (pos_word_0 == pos_first && pos_word_0 < pos_word_1 - 1 &&
+        is_quote(pos_word_0))
+      in_quotes = !in_quotes;
+    if (is_quote(pos_word_1 - 1))
+      in_quotes = !in_quotes;
 
     // If we are not within quotes, we are at the end of an argument
-    if((cnt_quote % 2) < 1) {
-      // Add the argument to the output
-      output.push_back(arg_line.substr(pos_word_0, pos_word_1 - pos_word_0));
-
-      // Find the start of the next word
-      pos_word_0 = iter_word->position();
+    if (!in_quotes) {
+      output.push_back(arg_line.substr(pos_arg, pos_word_1 - pos_arg));
+      pos_arg = pos_word_1;
     }
   }
 
+  // Whatever is left: trailing whitespace or an argument with an open quote
+  if (pos_arg < size)
+    output.push_back(arg_line.substr(pos_arg));
+
   return output;
 }
 
 
 /**@brief  Combines parsed arguments into a single string
+ * 
+ * Sized up front, so the line is built once in place rather than copied as
+ * it grows (nor is the list copied to do so).
  * 
  * @param  PARSED_ARGS: vector of strings
  *
  * @return string = PARSED_ARGS[0] + PARSED_ARGS[1] + ...
  */
-wstring CollapseArguments (vector<wstring> parsed_args) {
-  wstring output = L"";
-  for (auto iter = parsed_args.begin(); iter != parsed_args.end(); ++iter) 
-    output += *iter;
+wstring CollapseArguments (const vector<wstring>& parsed_args) {
+  size_t size = 0;
+  for (auto& arg : parsed_args)
+    size += arg.size();
+
+  wstring output;
+  output.reserve(size);
+  for (auto& arg : parsed_args)
+    output += arg;
   return output; 
 }
 
 
 /**@brief  Collapse and re-parse a list of arguments
  * 
- * Needed for finding positional arguments after some parsing has been done
+ * Needed for finding positional arguments after some parsing has been done.
+ * Whitespace around the arguments is dropped, hence nothing is left of a list
+ * holding only whitespace.
  * 
  * @param  PARSED_ARGS: vector of strings
  */
 void ReparseArguments (vector<wstring> &parsed_args) {
   wstring arg_line = CollapseArguments(parsed_args);
+  size_t  first    = arg_line.find_first_not_of(L" \t\n\v\f\r");
+  if (first == wstring::npos)
+    arg_line.clear();
+  else
+    arg_line = arg_line.substr(
+      first, arg_line.find_last_not_of(L" \t\n\v\f\r") + 1 - first);
   parsed_args = ParseArguments(arg_line);
 }
 
@@ -168,7 +198,8 @@ void ReparseArguments (vector<wstring> &parsed_args) {
  *
  * @return TRUE if found
  */
-bool GetArgument (vector<wstring> &args, const int index, wstring &value) {
+bool GetArgument (vector<wstring> &args, const size_t index,
+                  wstring &value) {
   value.clear();
   if((index*2) < args.size()) {
     args[index*2].swap(value);
@@ -226,7 +257,7 @@ bool GetArgument (vector<wstring> &args, wstring pattern,wstring &value) {
   wregex arg_pattern(pattern, regex::icase);
 
   for (auto iter = args.begin(); iter != args.end(); ++iter) {
-    if(regex_match(*iter, arg_pattern) && (iter+2) < args.end()) {
+    if(regex_match(*iter, arg_pattern) && args.end() - iter > 2) {
       (*iter).clear();                          // Clear the flag
       (*(++iter)).clear();                      // Clear the whitespace
       (*(++iter)).swap(value);                  // Get the value and clear
@@ -239,6 +270,173 @@ bool GetArgument (vector<wstring> &args, wstring pattern,wstring &value) {
 }
 
 
+/**@brief  Get and remove a NAME=VALUE argument following a pattern
+ *
+ * Finds the string matching PATTERN, ignoring case, within ARGS. As words are
+ * also split at equal signs, the setting following the match is put back
+ * together from its words and the equal signs between them (e.g. "--env
+ * A=B=C" gives "A=B=C"). Whitespace ends the setting, hence a value with
+ * spaces must be quoted. The match, setting, and subsequent whitespace are
+ * removed from ARGS. TRUE is only returned if the match is found AND an
+ * argument follows.
+ * 
+ * @param  ARGS:    vector of strings from ParseArguments
+ * @param  PATTERN: regex pattern to match
+ * @param  VALUE:   setting following match (quotes are kept)
+ *
+ * @return TRUE if pattern and setting are found
+ */
+bool GetSettingArgument (vector<wstring> &args, wstring pattern,
+                         wstring &value) {
+  value.clear();
+
+  // User-specified argument regex
+  wregex arg_pattern(pattern, regex::icase);
+
+  for (size_t i = 0; i < args.size(); i++) {
+    if(!regex_match(args[i], arg_pattern) || i + 2 >= args.size())
+      continue;
+
+    // Words joined by a lone "=", or ending with one (i.e. an empty value)
+    size_t last = i + 2;
+    value = args[last];
+    while(last + 1 < args.size() && args[last + 1][0] == '=') {
+      value += L"=";
+      if(args[last + 1] != L"=" || last + 2 >= args.size())
+        break;
+      last += 2;
+      value += args[last];
+    }
+
+    // Clear the flag, setting, and whitespace if needed
+    size_t end = min(last + 2, args.size());
+    for (size_t k = i; k < end; k++)
+      args[k].clear();
+    return true;
+  }
+   
+  return false;
+}
+
+
+/**@brief  Splits a command line into ARGV as a child process would see it
+ *
+ * Follows the rules of CommandLineToArgvW / the MS C runtime so that POSIX
+ * launches receive the same arguments a Windows child would:
+ *  - whitespace outside of quotes separates arguments
+ *  - 2N backslashes + quote --> N backslashes and toggles quoting
+ *  - 2N+1 backslashes + quote --> N backslashes and a literal quote
+ *  - two quotes within quotes --> a literal quote
+ *  - any other backslash is literal
+ *
+ * @param  ARG_LINE:    command line, i.e. path + " " + arguments
+ *
+ * @return vector of arguments (quotes and escapes removed)
+ */
+vector<wstring> SplitCommandLine (const wstring& arg_line) {
+  vector<wstring> output;
+  wstring         arg;
+  bool            in_arg      = false;
+  bool            in_quotes   = false;
+  size_t          backslashes = 0;
+  
+  for (size_t i = 0; i < arg_line.size(); i++) {
+    wchar_t c = arg_line[i];
+
+    if (c == L'\\') {
+      backslashes++;
+      in_arg = true;
+      continue;
+    }
+
+    if (c == L'"') {
+      arg.append(backslashes / 2, L'\\');
+      if (backslashes % 2)
+        arg += L'"';
+      else if (in_quotes && i + 1 < arg_line.size() && arg_line[i + 1] == L'"') {
+        arg += L'"';
+        i++;
+      }
+      else
+        in_quotes = !in_quotes;
+      backslashes = 0;
+      in_arg = true;
+      continue;
+    }
+
+    arg.append(backslashes, L'\\');
+    backslashes = 0;
+
+    if (!in_quotes && (c == L' ' || c == L'\t' || c == L'\n')) {
+      if (in_arg)
+        output.push_back(move(arg));
+      arg.clear();
+      in_arg = false;
+    }
+    else {
+      arg += c;
+      in_arg = true;
+    }
+  }
+
+  arg.append(backslashes, L'\\');
+  if (in_arg)
+    output.push_back(move(arg));
+  
+  return output;
+}
+
+
+/**@brief  Quotes an argument so SplitCommandLine returns it unchanged
+ *
+ * @param  ARG:     argument
+ *
+ * @return ARG as is if it has no whitespace or quotes, otherwise quoted with
+ *         inner quotes (and any backslashes before them) escaped
+ */
+wstring QuoteArgument (const wstring& arg) {
+  if (!arg.empty() && arg.find_first_of(L" \t\n\"") == wstring::npos)
+    return arg;
+
+  wstring output = L"\"";
+  size_t  backslashes = 0;
+  for (wchar_t c : arg) {
+    if (c == L'\\') {
+      backslashes++;
+      continue;
+    }
+    if (c == L'"')
+      output.append(backslashes * 2 + 1, L'\\');
+    else
+      output.append(backslashes, L'\\');
+    output += c;
+    backslashes = 0;
+  }
+  output.append(backslashes * 2, L'\\');
+  return output + L"\"";
+}
+
+
+/**@brief  Joins ARGV into a single command line
+ *
+ * The inverse of SplitCommandLine, used where the platform hands over ARGV
+ * rather than a command line (i.e. POSIX).
+ *
+ * @param  ARGV:    vector of arguments
+ *
+ * @return quoted arguments separated by a space
+ */
+wstring JoinArguments (const vector<wstring>& argv) {
+  wstring output;
+  for (size_t i = 0; i < argv.size(); i++) {
+    if (i > 0)
+      output += L" ";
+    output += QuoteArgument(argv[i]);
+  }
+  return output;
+}
+
+
 // ------------------------------------------------------------------------- //
 #endif  // GET_ARGUMENTS_H
 
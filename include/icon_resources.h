@@ -0,0 +1,540 @@
+// ------------------------------------------------------------------------- //
+// Icon Resources                                                            //
+// ------------------------------------------------------------------------- //
+/**@file    ICON_RESOURCES.H
+ * @brief   Reads, writes and prunes the icon resources copied to a shim
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * An icon is an RT_GROUP_ICON resource, a directory (GRPICONDIR) listing its
+ * images by size and bit depth, each being an RT_ICON resource (a bitmap or,
+ * for large ones, a PNG) found by the ID given in the directory:
+ *
+ *     reserved, type (1), count                   3 x 2 bytes
+ *     width, height, colors, reserved             4 x 1 byte, per image
+ *     planes, bit count                           2 x 2 bytes
+ *     bytes of the image                          4 bytes
+ *     ID of the RT_ICON                           2 bytes
+ *
+ * Executables often carry far more than a shim needs: every size from 16 to
+ * 256 px at several bit depths, repeated for each language. Only the
+ * standard library is used, hence this is the same on any platform.
+ *
+ *  ParseIconGroup / FormatIconGroup
+ *      reads / writes a GRPICONDIR
+ *
+ *  ParseIconList
+ *      reads a list of sizes or bit depths, e.g. "16,32,48,256"
+ *
+ *  OptimizeIcons
+ *      prunes the icons and their images by an ICONPOLICY, see below
+ *
+ *  ReadIconResources
+ *      reads an icon to use instead, from an .ico file or from the icon
+ *      resources of an executable or DLL (by index, as "path,index")
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef ICON_RESOURCES_H
+#define ICON_RESOURCES_H
+
+// ------------------------------------------------------------------------- //
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <cwctype>
+#include <algorithm>
+#include <istream>
+#include <fstream>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+#include <pe_resources.h>
+
+#define ICON_DIR_SIZE           6       // GRPICONDIR (or ICONDIR) header
+#define ICON_GROUP_ENTRY_SIZE   14      // GRPICONDIRENTRY
+#define ICON_FILE_ENTRY_SIZE    16      // ICONDIRENTRY, of an .ico file
+
+using namespace std;
+
+// An image of an icon, as listed by its directory
+struct IconEntry {
+  uint8_t   width =         0;          // px, 0 for 256 (or more)
+  uint8_t   height =        0;
+  uint8_t   colors =        0;          // of the palette, 0 if none
+  uint8_t   reserved =      0;
+  uint16_t  planes =        0;
+  uint16_t  bit_count =     0;          // 0 if not given, see ICONDEPTH
+  uint32_t  size =          0;          // bytes of the image
+  uint16_t  id =            0;          // of its RT_ICON
+
+  int pixels() const { return width ? width : 256; }
+};
+
+// An RT_ICON or RT_GROUP_ICON resource, as copied from an executable
+struct IconResource {
+  uint16_t  type =          0;          // PE_RT_ICON or PE_RT_GROUP_ICON
+  uint16_t  id =            0;          // 0 if named
+  string    name;
+  uint16_t  lang =          0;
+  string    data;
+};
+
+
+// --------------------------------- Groups -------------------------------- //
+// Little endian integer of SIZE bytes at AT (which must be within DATA)
+uint32_t IconGet(const string& data, size_t at, int size) {
+  uint32_t value = 0;
+  for (int i = 0; i < size; i++)
+    value |= (uint32_t)(unsigned char)data[at + i] << (8 * i);
+  return value;
+}
+
+void IconPut(string& data, uint32_t value, int size) {
+  for (int i = 0; i < size; i++)
+    data += (char)(value >> (8 * i));
+}
+
+
+/**@brief  Read a GRPICONDIR
+ *
+ * @return FALSE if DATA is not one (or is cut short)
+ */
+bool ParseIconGroup(const string& data, vector<IconEntry>& entries) {
+  entries.clear();
+  if (data.size() < ICON_DIR_SIZE || IconGet(data, 0, 2) != 0 ||
+      IconGet(data, 2, 2) != 1)
+    return false;
+
+  size_t count = IconGet(data, 4, 2);
+  if (ICON_DIR_SIZE + count * ICON_GROUP_ENTRY_SIZE > data.size())
+    return false;
+
+  for (size_t i = 0; i < count; i++) {
+    size_t    at = ICON_DIR_SIZE + i * ICON_GROUP_ENTRY_SIZE;
+    IconEntry entry;
+    entry.width     = data[at];
+    entry.height    = data[at + 1];
+    entry.colors    = data[at + 2];
+    entry.reserved  = data[at + 3];
+    entry.planes    = IconGet(data, at + 4, 2);
+    entry.bit_count = IconGet(data, at + 6, 2);
+    entry.size      = IconGet(data, at + 8, 4);
+    entry.id        = IconGet(data, at + 12, 2);
+    entries.push_back(entry);
+  }
+  return true;
+}
+
+/**@brief  Write a GRPICONDIR
+ */
+string FormatIconGroup(const vector<IconEntry>& entries) {
+  string data;
+  IconPut(data, 0, 2);
+  IconPut(data, 1, 2);
+  IconPut(data, entries.size(), 2);
+  for (auto& entry : entries) {
+    data += (char)entry.width;
+    data += (char)entry.height;
+    data += (char)entry.colors;
+    data += (char)entry.reserved;
+    IconPut(data, entry.planes, 2);
+    IconPut(data, entry.bit_count, 2);
+    IconPut(data, entry.size, 4);
+    IconPut(data, entry.id, 2);
+  }
+  return data;
+}
+
+
+/**@brief  Bits per pixel of an image
+ *
+ * As given by its directory entry, or if not, by the image itself: a PNG's
+ * bit depth times its channels or a bitmap's biBitCount.
+ */
+int IconDepth(const IconEntry& entry, const string& image) {
+  if (entry.bit_count)
+    return entry.bit_count;
+
+  if (image.size() >= 26 && image.compare(0, 8, "\x89PNG\r\n\x1a\n") == 0) {
+    const int channels[] = {1, 0, 3, 1, 2, 0, 4};      // by color type
+    int type = (unsigned char)image[25];
+    return (unsigned char)image[24] * (type < 7 ? channels[type] : 0);
+  }
+  if (image.size() >= 16)
+    return IconGet(image, 14, 2);
+  return 0;
+}
+
+
+// --------------------------------- Policy -------------------------------- //
+/**@brief  What is kept of the icons copied to a shim
+ *
+ * Identical images, whether within a group, across groups or across
+ * languages, are always kept once. Then only the images of the given SIZES
+ * and DEPTHS are kept (all if none are given), though a group never loses its
+ * last image: of those, it keeps its largest. Lastly, while the icons take
+ * more than MAX_BYTES (unless 0), the largest image a group can spare is
+ * dropped.
+ */
+struct IconPolicy {
+  vector<int>   sizes;                  // px, 256 for 256 or more
+  vector<int>   depths;                 // bits per pixel
+  uint64_t      max_bytes =     0;
+
+  bool keeps(const IconEntry& entry, const string& image) const {
+    return (sizes.empty() || count(sizes.begin(), sizes.end(),
+                                   entry.pixels())) &&
+      (depths.empty() || count(depths.begin(), depths.end(),
+                               IconDepth(entry, image)));
+  }
+};
+
+// What OPTIMIZEICONS did
+struct IconStats {
+  size_t    groups =        0;
+  size_t    images_in =     0;          // RT_ICON resources copied
+  size_t    images_out =    0;          // ... and kept
+  uint64_t  bytes_in =      0;          // of RT_ICON and RT_GROUP_ICON
+  uint64_t  bytes_out =     0;
+  bool      over_limit =    false;      // MAX_BYTES could not be met
+};
+
+
+/**@brief  Read a list of numbers such as "16,32,48,256"
+ *
+ * @return FALSE (and LIST empty) if any is not a positive number
+ */
+bool ParseIconList(const wstring& text, vector<int>& list) {
+  list.clear();
+  size_t at = 0;
+  while (at <= text.size()) {
+    size_t   end = min(text.find(L',', at), text.size());
+    wstring  item = text.substr(at, end - at);
+    wchar_t* stop;
+    long     value = wcstol(item.c_str(), &stop, 10);
+    if (item.empty() || *stop || value <= 0 || value > 65535) {
+      list.clear();
+      return false;
+    }
+    list.push_back(value);
+    at = end + 1;
+  }
+  return true;
+}
+
+
+/**@brief  Prune icons copied from an executable by POLICY
+ *
+ * The images kept are numbered anew from 1, each written once in the
+ * language of the first group using it (Windows finds an RT_ICON by ID in
+ * any language), and every group is rewritten to match. Images no group uses
+ * are dropped, as are groups that cannot be read.
+ *
+ * @param  ICONS:   the RT_ICON and RT_GROUP_ICON resources, replaced by those
+ *                  to write
+ * @param  POLICY:  what to keep
+ */
+IconStats OptimizeIcons(vector<IconResource>& icons,
+                        const IconPolicy& policy = IconPolicy()) {
+  IconStats stats;
+
+  // Images by ID and language, and by ID alone (as Windows falls back to)
+  map<pair<uint16_t, uint16_t>, const string*> by_lang;
+  map<uint16_t, const string*>                 by_id;
+  for (auto& icon : icons) {
+    stats.bytes_in += icon.data.size();
+    if (icon.type != PE_RT_ICON || !icon.name.empty())
+      continue;
+    stats.images_in++;
+    by_lang.emplace(make_pair(icon.id, icon.lang), &icon.data);
+    by_id.emplace(icon.id, &icon.data);
+  }
+
+  // Each distinct image once; groups refer to them by index
+  struct Group {
+    const IconResource*   icon;
+    vector<IconEntry>     entries;
+  };
+  vector<const string*>                       images;
+  vector<uint16_t>                            langs;
+  unordered_map<string_view, size_t>          index;
+  vector<Group>                               groups;
+  for (auto& icon : icons) {
+    Group group = {&icon, {}};
+    if (icon.type != PE_RT_GROUP_ICON ||
+        !ParseIconGroup(icon.data, group.entries))
+      continue;
+
+    vector<IconEntry> entries;
+    for (auto& entry : group.entries) {
+      auto found = by_lang.find(make_pair(entry.id, icon.lang));
+      const string* image = found != by_lang.end() ? found->second :
+        by_id.count(entry.id) ? by_id[entry.id] : nullptr;
+      if (!image)
+        continue;                               // missing, as Windows skips
+
+      auto [at, added] = index.emplace(string_view(*image), images.size());
+      if (added) {
+        images.push_back(image);
+        langs.push_back(icon.lang);
+      }
+      entry.id   = at->second;
+      entry.size = image->size();
+      bool again = any_of(entries.begin(), entries.end(),
+                          [&](const IconEntry& e) { return e.id == entry.id; });
+      if (!again)
+        entries.push_back(entry);
+    }
+    if (entries.empty())
+      continue;
+
+    // Only the sizes and depths wanted, or else the largest
+    vector<IconEntry> kept;
+    for (auto& entry : entries)
+      if (policy.keeps(entry, *images[entry.id]))
+        kept.push_back(entry);
+    if (kept.empty())
+      kept.push_back(*max_element(entries.begin(), entries.end(),
+        [&](const IconEntry& a, const IconEntry& b) {
+          return make_pair(a.pixels(), IconDepth(a, *images[a.id])) <
+            make_pair(b.pixels(), IconDepth(b, *images[b.id]));
+        }));
+    group.entries = kept;
+    groups.push_back(group);
+  }
+
+  // Within MAX_BYTES, dropping the largest image every group using it can
+  // spare
+  auto total = [&] {
+    vector<bool> used(images.size());
+    uint64_t     bytes = 0;
+    for (auto& group : groups) {
+      bytes += ICON_DIR_SIZE + group.entries.size() * ICON_GROUP_ENTRY_SIZE;
+      for (auto& entry : group.entries)
+        if (!used[entry.id]) {
+          used[entry.id] = true;
+          bytes += images[entry.id]->size();
+        }
+    }
+    return bytes;
+  };
+  while (policy.max_bytes && total() > policy.max_bytes) {
+    vector<bool> spare(images.size(), true), used(images.size());
+    for (auto& group : groups)
+      for (auto& entry : group.entries) {
+        used[entry.id] = true;
+        spare[entry.id] = spare[entry.id] && group.entries.size() > 1;
+      }
+
+    size_t largest = images.size();
+    for (size_t i = 0; i < images.size(); i++)
+      if (used[i] && spare[i] && (largest == images.size() ||
+                                  images[i]->size() > images[largest]->size()))
+        largest = i;
+    if (largest == images.size()) {
+      stats.over_limit = true;
+      break;
+    }
+    for (auto& group : groups)
+      group.entries.erase(
+        remove_if(group.entries.begin(), group.entries.end(),
+                  [&](const IconEntry& e) { return e.id == largest; }),
+        group.entries.end());
+  }
+
+  // Number the images kept in the order the groups use them
+  vector<IconResource> output;
+  vector<uint16_t>     ids(images.size(), 0);
+  for (auto& group : groups)
+    for (auto& entry : group.entries) {
+      if (!ids[entry.id]) {
+        ids[entry.id] = output.size() + 1;
+        output.push_back({PE_RT_ICON, ids[entry.id], "", langs[entry.id],
+                          *images[entry.id]});
+      }
+      entry.id = ids[entry.id];
+    }
+  stats.images_out = output.size();
+
+  for (auto& group : groups)
+    output.push_back({PE_RT_GROUP_ICON, group.icon->id, group.icon->name,
+                      group.icon->lang, FormatIconGroup(group.entries)});
+  stats.groups = groups.size();
+
+  for (auto& icon : output)
+    stats.bytes_out += icon.data.size();
+  icons.swap(output);
+  return stats;
+}
+
+
+// -------------------------------- Import --------------------------------- //
+// An .ico file is an ICONDIR as a GRPICONDIR but for the entries, which give
+// the offset of each image in the file rather than an ID. Both it and an
+// executable are read with seeks, only the directories and the images of the
+// icon wanted are read. Either way the icon is one RT_GROUP_ICON (ID 1) with
+// its images as RT_ICONs (IDs 1 on), all of neutral language.
+
+/**@brief  Read the icon of an .ico file
+ *
+ * @return FALSE if FILE is not one (or an image is not within it)
+ */
+bool ReadIconFile(istream& file, vector<IconResource>& icons) {
+  icons.clear();
+  PeReader ico(file);
+  uint64_t length = ico.length();
+  if (length < ICON_DIR_SIZE || ico.get(0, 2) != 0 || ico.get(2, 2) != 1)
+    return false;
+
+  uint32_t count = ico.get(4, 2);
+  if (!count || ICON_DIR_SIZE + count * ICON_FILE_ENTRY_SIZE > length)
+    return false;
+
+  vector<IconEntry> entries;
+  for (uint32_t i = 0; i < count; i++) {
+    uint64_t      at = ICON_DIR_SIZE + i * ICON_FILE_ENTRY_SIZE;
+    unsigned char bytes[4];
+    IconEntry     entry;
+    ico.read(at, bytes, 4);
+    entry.width     = bytes[0];
+    entry.height    = bytes[1];
+    entry.colors    = bytes[2];
+    entry.reserved  = bytes[3];
+    entry.planes    = ico.get(at + 4, 2);
+    entry.bit_count = ico.get(at + 6, 2);
+    entry.size      = ico.get(at + 8, 4);
+    entry.id        = i + 1;
+
+    uint32_t offset = ico.get(at + 12, 4);
+    if (!entry.size || (uint64_t)offset + entry.size > length)
+      return false;
+    IconResource image = {PE_RT_ICON, entry.id, "", 0, string()};
+    image.data.resize(entry.size);
+    if (!ico.read(offset, &image.data[0], entry.size))
+      return false;
+    icons.push_back(move(image));
+    entries.push_back(entry);
+  }
+  icons.push_back({PE_RT_GROUP_ICON, 1, "", 0, FormatIconGroup(entries)});
+  return true;
+}
+
+
+/**@brief  Read an icon of an executable (or DLL)
+ *
+ * @param  INDEX:   of the icon (RT_GROUP_ICON) in the order Windows lists
+ *                  them, or if negative, the ID of the icon (as ExtractIcon)
+ *
+ * @return FALSE if FILE is not a PE file, has no such icon or none of its
+ *         images
+ */
+bool ReadExeIcon(istream& file, int index, vector<IconResource>& icons) {
+  icons.clear();
+  vector<PeResource> resources;
+  if (!ReadPeResources(file, resources))
+    return false;
+
+  // Each icon is listed once per language, one after another
+  const PeResource* group = nullptr;
+  const PeResource* last  = nullptr;
+  int               n     = -1;
+  for (auto& r : resources) {
+    if (r.type != PE_RT_GROUP_ICON)
+      continue;
+    if (!last || last->id != r.id || last->name != r.name)
+      n++;
+    last = &r;
+    if (index >= 0 ? n == index : r.name.empty() && r.id == -index) {
+      group = &r;
+      break;
+    }
+  }
+
+  string            data;
+  vector<IconEntry> entries, kept;
+  if (!group || !ReadPeResource(file, *group, data) ||
+      !ParseIconGroup(data, entries))
+    return false;
+
+  // Its images, in its language if there, as Windows finds them
+  for (auto& entry : entries) {
+    const PeResource* image = nullptr;
+    for (auto& r : resources)
+      if (r.type == PE_RT_ICON && r.name.empty() && r.id == entry.id &&
+          (!image || r.lang == group->lang))
+        image = &r;
+    if (!image || !ReadPeResource(file, *image, data))
+      continue;
+
+    entry.id   = kept.size() + 1;
+    entry.size = data.size();
+    kept.push_back(entry);
+    icons.push_back({PE_RT_ICON, entry.id, "", 0, data});
+  }
+  if (kept.empty())
+    return false;
+  icons.push_back({PE_RT_GROUP_ICON, 1, "", 0, FormatIconGroup(kept)});
+  return true;
+}
+
+
+/**@brief  Split an icon location, "path" or "path,index", into the two
+ *
+ * @return the index, 0 if none is given
+ */
+int ParseIconLocation(const wstring& location, wstring& path) {
+  size_t comma = location.rfind(L',');
+  if (comma != wstring::npos && comma + 1 < location.size()) {
+    wchar_t* end;
+    long     index = wcstol(location.c_str() + comma + 1, &end, 10);
+    if (!*end && iswdigit(location.back()) && index >= -65535 &&
+        index <= 65535) {
+      path = location.substr(0, comma);
+      return index;
+    }
+  }
+  path = location;
+  return 0;
+}
+
+
+/**@brief  Read the icon to use instead of those of the executable shimmed
+ *
+ * @param  PATH:    an .ico file or an executable (or DLL)
+ * @param  INDEX:   of the icon within an executable, see READEXEICON
+ * @param  ICONS:   its RT_GROUP_ICON and RT_ICONs
+ *
+ * @return FALSE if no icon could be read
+ */
+bool ReadIconResources(const filesystem::path& path, int index,
+                       vector<IconResource>& icons) {
+  ifstream file(path, ios::in | ios::binary);
+  char     magic[2] = {};
+  if (!file.read(magic, 2))
+    return false;
+  return magic[0] == 'M' && magic[1] == 'Z' ?
+    ReadExeIcon(file, index, icons) : ReadIconFile(file, icons);
+}
+
+
+// ------------------------------------------------------------------------- //
+#endif  // ICON_RESOURCES_H
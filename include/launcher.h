@@ -0,0 +1,60 @@
+// ------------------------------------------------------------------------- //
+// Process Launcher                                                          //
+// ------------------------------------------------------------------------- //
+/**@file    LAUNCHER.H
+ * @brief   Starts the application on the platform the shim was built for
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * The backend is chosen at compile time, each providing:
+ *
+ *  ChildProcess
+ *      whatever is needed to wait on the started process
+ *
+ *  bool LaunchProcess(const LaunchPlan& plan, ChildProcess& child)
+ *      starts PLAN.PATH with PLAN.ARGS (a Windows style argument string) in
+ *      PLAN.WORKING_DIR. If PLAN.WAIT, also ties the child's lifetime and
+ *      console signals to the shim.
+ *
+ *  LAUNCH_REPLACES_SHIM
+ *      TRUE if, when not waiting, LaunchProcess replaces the shim with the
+ *      application (exec) and hence only returns on failure
+ *
+ *  int WaitProcess(ChildProcess& child, ProcessAccounting* accounting)
+ *      waits for the child to exit and returns its exit code, optionally
+ *      filling in the resources it used
+ *
+ * See LAUNCHER_WIN32.H and LAUNCHER_POSIX.H
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef LAUNCHER_H
+#define LAUNCHER_H
+
+// ------------------------------------------------------------------------- //
+#include <shim_core.h>
+#include <process_accounting.h>
+
+#ifdef _WIN32
+#include <launcher_win32.h>
+#else
+#include <launcher_posix.h>
+#endif
+
+// ------------------------------------------------------------------------- //
+#endif  // LAUNCHER_H
@@ -0,0 +1,395 @@
+// ------------------------------------------------------------------------- //
+// POSIX Launcher                                                            //
+// ------------------------------------------------------------------------- //
+/**@file    LAUNCHER_POSIX.H
+ * @brief   Creates and waits for the application's process on POSIX
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * POSIX backend of LAUNCHER.H, mirroring the Win32 one:
+ *
+ *  - the argument string is split exactly as a Windows child would (see
+ *    SplitCommandLine) and the child is started with posix_spawn, changing
+ *    directory in the child (or fork when posix_spawn cannot, reporting a
+ *    failed exec back on a pipe)
+ *  - the child leads a process group of its own, which is given the
+ *    terminal when the shim has it, so that Ctrl-C and Ctrl-\ reach the
+ *    child and whatever it starts, but not the waiting shim
+ *  - SIGINT, SIGQUIT, SIGTERM and SIGHUP sent to the shim are forwarded to
+ *    the child's group, so no grandchild outlives a shim told to stop
+ *  - when the child stops (Ctrl-Z) the shim takes the terminal back and
+ *    stops too, so its parent sees the job stop, and once continued it
+ *    continues the child's group, handing the terminal back if in front
+ *  - the child gets the shim's environment, or a copy with the SHIM_ENV
+ *    overrides applied (see ENVIRONMENT.H)
+ *  - the scheduling policy (see SCHEDULE.H) is applied by the child to
+ *    itself between fork and exec (posix_spawn having no step for it), so
+ *    the shim keeps its own
+ *  - the child is reaped with wait4 for its exit code and accounting
+ *  - when relaying, the child is given pipes and the shim pumps them (see
+ *    RELAY.H)
+ *  - when not waiting there is nothing left for the shim to do, so it execs
+ *    the application in place rather than starting a new process
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef LAUNCHER_POSIX_H
+#define LAUNCHER_POSIX_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <log.h>
+#include <trace.h>
+#include <process_accounting.h>
+#include <shim_core.h>
+#include <get_argument.h>
+#include <utility_functions.h>
+#include <relay.h>
+
+extern char** environ;
+
+// glibc 2.29+ can change directory within posix_spawn
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+#define HAS_SPAWN_CHDIR 1
+#endif
+
+// ... and give it the terminal since 2.35
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 35))
+#define HAS_SPAWN_TCSETPGRP 1
+#endif
+
+
+// --------------------------- Process Creation ---------------------------- //
+volatile sig_atomic_t child_pid = 0;
+
+// Pass termination requests on to the child's process group (or the child
+// alone should it have left it)
+void ForwardSignal(int signal) {
+  if (child_pid > 0 && kill(-child_pid, signal) != 0)
+    kill(child_pid, signal);
+}
+
+
+// Terminal (of stdin, stdout or stderr) whose foreground process group is
+// the shim's, or -1
+int ForegroundTerminal() {
+  for (int fd = 0; fd < 3; fd++)
+    if (isatty(fd) && tcgetpgrp(fd) == getpgrp())
+      return fd;
+  return -1;
+}
+
+
+// Make PGID the foreground process group of TTY (if not -1), which a
+// background group may only do with SIGTTOU blocked
+void SetForeground(int tty, pid_t pgid) {
+  if (tty < 0)
+    return;
+  sigset_t ttou, old;
+  sigemptyset(&ttou);
+  sigaddset(&ttou, SIGTTOU);
+  sigprocmask(SIG_BLOCK, &ttou, &old);
+  tcsetpgrp(tty, pgid);
+  sigprocmask(SIG_SETMASK, &old, nullptr);
+}
+
+
+/**@brief  Argument vector for exec (owns the strings)
+ */
+struct ExecArgs {
+  vector<string>  strings;
+  vector<char*>   argv;
+
+  ExecArgs(const wstring& path, const wstring& args) {
+    strings.push_back(NarrowString(path));
+    for (auto& arg : SplitCommandLine(args))
+      strings.push_back(NarrowString(arg));
+    for (auto& s : strings)
+      argv.push_back(&s[0]);
+    argv.push_back(nullptr);
+  }
+};
+
+
+/**@brief  Start a process, leading a process group of its own
+ *
+ * @param  ARGV:    arguments, ARGV[0] being the path of the executable
+ * @param  DIR:     working directory (or empty)
+ * @param  ENVP:    environment
+ * @param  STDIO:   descriptors for its stdin, stdout and stderr (or nullptr to
+ *                  inherit the caller's)
+ * @param  SCHED:   scheduling policy the process applies to itself before
+ *                  exec (or nullptr), warning of what it could not
+ * @param  TTY:     terminal to make the group the foreground of (or -1)
+ *
+ * @return process ID (and group) or -1 (with errno set)
+ */
+pid_t SpawnProcess(char* const argv[], const string& dir,
+                   char* const envp[] = environ, const int* stdio = nullptr,
+                   const SchedPolicy* sched = nullptr, int tty = -1) {
+  pid_t pid = -1;
+  if (sched && sched->empty())
+    sched = nullptr;
+
+#ifdef HAS_SPAWN_CHDIR
+#ifndef HAS_SPAWN_TCSETPGRP
+  if (!sched && tty < 0) {
+#else
+  if (!sched) {
+#endif
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attr, 0);
+
+    // The group is set before the actions, and signals are blocked in the
+    // child until exec so SIGTTOU does not stop it taking the terminal
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+#ifdef HAS_SPAWN_TCSETPGRP
+    if (tty >= 0)
+      posix_spawn_file_actions_addtcsetpgrp_np(&actions, tty);
+#endif
+    if (!dir.empty())
+      posix_spawn_file_actions_addchdir_np(&actions, dir.c_str());
+    for (int i = 0; stdio && i < 3; i++)
+      posix_spawn_file_actions_adddup2(&actions, stdio[i], i);
+
+    int error = posix_spawn(&pid, argv[0], &actions, &attr, argv, envp);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    if (error) {
+      errno = error;
+      return -1;
+    }
+    return pid;
+  }
+#endif
+
+  // The child reports what it could not apply, and why it did not exec, on
+  // a pipe that a successful exec closes
+  struct Report {
+    int   sched_failed;
+    int   error;
+  };
+  int report_pipe[2];
+  if (pipe2(report_pipe, O_CLOEXEC) != 0)
+    return -1;
+
+  pid = fork();
+  if (pid == 0) {
+    setpgid(0, 0);
+    SetForeground(tty, getpid());
+    Report report = {sched ? ApplySchedPolicy(*sched) : 0, 0};
+    while (write(report_pipe[1], &report, sizeof(report)) < 0 &&
+           errno == EINTR) {}
+    for (int i = 0; stdio && i < 3; i++)
+      dup2(stdio[i], i);
+    if (dir.empty() || chdir(dir.c_str()) == 0)
+      execve(argv[0], argv, envp);
+    report.error = errno;
+    while (write(report_pipe[1], &report, sizeof(report)) < 0 &&
+           errno == EINTR) {}
+    _exit(127);
+  }
+  int error = errno;
+  if (pid > 0)
+    setpgid(pid, pid);      // as the child does, whichever comes first
+  close(report_pipe[1]);
+
+  Report report = {}, read_report;
+  for (ssize_t n; pid > 0 && (n = read(report_pipe[0], &read_report,
+                                       sizeof(read_report))) != 0; )
+    if (n == sizeof(read_report))
+      report = read_report;
+    else if (n < 0 && errno != EINTR)
+      break;
+  close(report_pipe[0]);
+
+  if (pid > 0 && sched)
+    ReportSchedPolicy(*sched, report.sched_failed);
+  if (pid > 0 && report.error) {
+    while (waitpid(pid, nullptr, 0) < 0 && errno == EINTR) {}
+    error = report.error;
+    pid = -1;
+  }
+  errno = error;
+  return pid;
+}
+
+
+// Exit code as a shell reports it, 128 + N if killed by signal N
+int ExitCode(int status) {
+  if (WIFEXITED(status))
+    return WEXITSTATUS(status);
+  if (WIFSIGNALED(status))
+    return 128 + WTERMSIG(status);
+  return 1;
+}
+
+
+/**@brief  Replace the shim with the application
+ *
+ * @return only on failure (with errno set)
+ */
+void ExecProcess(char* const argv[], const string& dir,
+                 char* const envp[] = environ) {
+  if (!dir.empty() && chdir(dir.c_str()) != 0)
+    LOG(2) << "Could not change to working directory";
+  execve(argv[0], argv, envp);
+}
+
+
+// ------------------------------- Launcher -------------------------------- //
+// LaunchProcess does not return unless it failed when not waiting
+constexpr bool LAUNCH_REPLACES_SHIM = true;
+
+struct ChildProcess {
+  pid_t     pid =           -1;
+  int       tty =           -1;     // given to the child's group
+  Relay     relay;
+};
+
+
+/**@brief  Start the application
+ *
+ * @param  PLAN:    what to run (see RESOLVELAUNCH)
+ * @param  CHILD:   the started process
+ *
+ * @return TRUE if the process was created, never returning at all if exec'd
+ */
+bool LaunchProcess(const LaunchPlan& plan, ChildProcess& child) {
+  ExecArgs exec(plan.path, plan.args);
+  string   dir = NarrowString(plan.working_dir);
+
+  if (!dir.empty() && access(dir.c_str(), F_OK) != 0)
+    LOG(2) << "Working directory does not exist, process may fail to start";
+
+  // The shim's own environment unless SHIM_ENV overrides some of it
+  EnvironmentBlock env  = BuildEnvironment(plan.environment);
+  char* const*     envp = env.empty() ? environ : env.envp.data();
+  TRACE("environment");
+
+  const int* stdio = nullptr;
+  if (plan.relay) {
+    if (child.relay.open())
+      stdio = child.relay.child;
+    else
+      LOG(2) << "Could not create the relay pipes, using the shim's stdio";
+    if (stdio && !plan.tee_file.empty())
+      child.relay.teeTo(plan.tee_file);
+  }
+
+  if (!plan.wait) {
+    // The shim becomes the application, policy and all
+    if (!plan.sched.empty()) {
+      ReportSchedPolicy(plan.sched, ApplySchedPolicy(plan.sched));
+      TRACE("sched");
+    }
+    ExecProcess(exec.argv.data(), dir, envp);
+    child.pid = -1;
+  }
+  else {
+    child.tty = ForegroundTerminal();
+    child.pid = SpawnProcess(exec.argv.data(), dir, envp, stdio, &plan.sched,
+                             child.tty);
+  }
+  int error = errno;
+  TRACE("child_resume");
+  TRACE("make_process");
+
+  if (child.pid < 0) {
+    LOG(1) << "Could not create process with command: ";
+    LOG(-1) << "'" << plan.path << " " << plan.args << "' ("
+            << strerror(error) << ")";
+    return false;
+  }
+
+  if (plan.wait) {
+    // Ctrl-C and the like reach the child's group from the terminal it was
+    // given, else through the shim
+    child_pid = child.pid;
+    signal(SIGINT, ForwardSignal);
+    signal(SIGQUIT, ForwardSignal);
+    signal(SIGTERM, ForwardSignal);
+    signal(SIGHUP, ForwardSignal);
+    TRACE("job_setup");
+  }
+
+  if (stdio) {
+    child.relay.start();
+    TRACE("relay");
+  }
+
+  return true;
+}
+
+
+/**@brief  Wait for the application to exit
+ *
+ * @param  CHILD:       process from LAUNCHPROCESS (with PLAN.WAIT)
+ * @param  ACCOUNTING:  if given, filled from its rusage (WALL_US is left)
+ *
+ * @return exit code of the process, 128 + N if killed by signal N
+ */
+int WaitProcess(ChildProcess& child, ProcessAccounting* accounting) {
+  int status = 0;
+  ProcessAccounting usage;
+
+  for (;;) {
+    if (WaitProcessAccounting(child.pid, &status, usage, WUNTRACED) < 0) {
+      SetForeground(child.tty, getpgrp());
+      return 1;
+    }
+    if (!WIFSTOPPED(status))
+      break;
+
+    // The job stopped, so the shim stops with it until continued itself
+    SetForeground(child.tty, getpgrp());
+    raise(SIGSTOP);
+    if (child.tty >= 0 && tcgetpgrp(child.tty) == getpgrp())
+      SetForeground(child.tty, child.pid);
+    kill(-child.pid, SIGCONT);
+  }
+  TRACE("wait");
+  child_pid = 0;
+  SetForeground(child.tty, getpgrp());
+
+  // Whatever it wrote last may still be in the pipes
+  child.relay.finish();
+
+  if (accounting)
+    *accounting = usage;
+
+  return ExitCode(status);
+}
+
+
+// ------------------------------------------------------------------------- //
+#endif  // LAUNCHER_POSIX_H
@@ -0,0 +1,328 @@
+// ------------------------------------------------------------------------- //
+// Win32 Launcher                                                            //
+// ------------------------------------------------------------------------- //
+/**@file    LAUNCHER_WIN32.H
+ * @brief   Creates and waits for the application's process on Windows
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Win32 backend of LAUNCHER.H. The process is created suspended and falls
+ * back to ShellExecuteEx when elevation is required. When waiting, the child
+ * is put in a job object so its whole tree dies with the shim. When relaying
+ * (see RELAY.H) it is given pipes for its stdio, and an elevated application
+ * is started through an elevated copy of the shim that connects them.
+ * Overrides from SHIM_ENV are given to CreateProcess as a prebuilt
+ * environment block (see ENVIRONMENT.H). The scheduling policy (see
+ * SCHEDULE.H) goes in the creation flags, the process, and its job, all
+ * before it is resumed.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef LAUNCHER_WIN32_H
+#define LAUNCHER_WIN32_H
+
+// ------------------------------------------------------------------------- //
+#include <windows.h>
+#include <memory>
+#include <tuple>
+#include <log.h>
+#include <trace.h>
+#include <process_accounting.h>
+#include <shim_core.h>
+#include <relay.h>
+#include <utility_functions.h>
+
+#pragma comment(lib, "SHELL32.LIB")
+
+
+#ifndef ERROR_ELEVATION_REQUIRED
+#define ERROR_ELEVATION_REQUIRED 740
+#endif
+
+
+// --------------------------- Process Creation ---------------------------- // 
+BOOL WINAPI CtrlHandler(DWORD ctrlType) {
+  switch (ctrlType) {
+    // Ignore all events, and let the child process handle them.
+  case CTRL_C_EVENT:
+  case CTRL_CLOSE_EVENT:
+  case CTRL_LOGOFF_EVENT:
+  case CTRL_BREAK_EVENT:
+  case CTRL_SHUTDOWN_EVENT:
+    return TRUE;
+
+  default:
+    return FALSE;
+  }
+}
+
+struct HandleDeleter {
+  typedef HANDLE pointer;
+  void operator()(HANDLE handle) {
+    if (handle) {
+      CloseHandle(handle);
+    }
+  }
+};
+
+namespace std {
+  typedef unique_ptr<HANDLE, HandleDeleter> unique_handle;
+}
+
+tuple<unique_handle, unique_handle> MakeProcess(
+    const wstring &path,
+    const wstring &args,
+    const wstring &workingDirectory,
+    const HANDLE *stdio = nullptr,
+    Relay *relay = nullptr,
+    const EnvironmentBlock *environment = nullptr,
+    const SchedPolicy *sched = nullptr) {
+  STARTUPINFOW        startInfo     = {};
+  PROCESS_INFORMATION processInfo   = {};
+  unique_handle       threadHandle;
+  unique_handle       processHandle;
+
+  // Build the Command Line
+  wstring cmd = path;
+  if(!args.empty())
+    cmd += L" " + args;
+  
+  // Set the Working Directory
+  LPCWSTR workingDirectoryCSTR = nullptr;
+  if (!workingDirectory.empty()) {
+      workingDirectoryCSTR = workingDirectory.c_str();
+
+      if (!PathFileExistsW(workingDirectoryCSTR))
+        LOG(2) <<
+          "Working directory does not exist, process may fail to start";
+  }
+  
+  // Give it the relay's pipes rather than the shim's handles
+  if (stdio) {
+    startInfo.cb          = sizeof(startInfo);
+    startInfo.dwFlags     = STARTF_USESTDHANDLES;
+    startInfo.hStdInput   = stdio[0];
+    startInfo.hStdOutput  = stdio[1];
+    startInfo.hStdError   = stdio[2];
+  }
+  
+  // Its own environment block, or the shim's
+  DWORD   creationFlags = CREATE_SUSPENDED;
+  LPVOID  environmentBlock = nullptr;
+  if (environment && !environment->empty()) {
+    creationFlags |= CREATE_UNICODE_ENVIRONMENT;
+    environmentBlock = (LPVOID)environment->block.data();
+  }
+  if (sched)
+    creationFlags |= SchedPriorityClass(*sched);
+  
+  // Create the Process
+  if (CreateProcessW(
+          nullptr,                 // No module name (use command line)       
+          cmd.data(),              // Command Line
+          nullptr, nullptr, TRUE,  // Inheritance (Process, Thread, Handle)
+          creationFlags,           // Suspend threads on creation
+          environmentBlock,        // Environment block (or parent's)
+          workingDirectoryCSTR,    // Starting directory         
+          &startInfo, &processInfo)) {
+    // Set the handles
+    threadHandle.reset(processInfo.hThread);
+    processHandle.reset(processInfo.hProcess);
+    
+    // Pin it before it runs (the caller resumes it)
+    if (sched && !ApplySchedPolicy(processHandle.get(), *sched, false))
+      LOG(2) << "Could not set the application's CPU affinity";
+  }
+  else if (GetLastError() == ERROR_ELEVATION_REQUIRED) {
+    // We must elevate the process, which is (basically) impossible with
+    // CreateProcess, and therefore we fallback to ShellExecuteEx, which CAN
+    // create elevated processes, at the cost of opening a new separate
+    // window. When relaying, that window is an elevated copy of the shim
+    // (hidden) that connects the application to the relay's pipes instead.
+
+    SHELLEXECUTEINFOW sei = {};
+    wstring file = path;
+    wstring params = args;
+
+    sei.cbSize = sizeof(SHELLEXECUTEINFOW);
+    sei.fMask = SEE_MASK_NOCLOSEPROCESS;
+    sei.nShow = SW_SHOW;
+    sei.lpDirectory = workingDirectoryCSTR;
+
+    // The relay host applies SHIM_ENV and SHIM_SCHED itself
+    bool hosted = relay && relay->open(false);
+    if (hosted) {
+      file = GetExecPath().wstring();
+      params = L"--shim-RelayHost " + relay->name;
+      if (!args.empty())
+        params += L" " + args;
+      sei.lpVerb = L"runas";
+      sei.nShow = SW_HIDE;
+    }
+    else if (environment && !environment->empty())
+      LOG(2) << "Environment overrides are not passed to elevated "
+             << "processes, use --shim-Relay";
+    
+    sei.lpFile = file.c_str();
+    sei.lpParameters = params.c_str();
+
+    if (!ShellExecuteExW(&sei)) {
+      LOG(1) << "Unable to create elevated process: error ";
+      LOG(-1) << GetLastError();
+      return {move(processHandle), move(threadHandle)};
+    }
+
+    processHandle.reset(sei.hProcess);
+
+    // Already running, the policy can only follow
+    if (sched && !sched->empty() && !hosted &&
+        !ApplySchedPolicy(processHandle.get(), *sched))
+      LOG(2) << "Could not apply the scheduling policy to elevated process";
+  }
+  else {
+    LOG(1) << "Could not create process with command: ";
+    LOG(-1) << "'" << cmd << "'";
+    return {move(processHandle), move(threadHandle)};
+  }
+
+  // Ignore Ctrl-C and other signals
+  if (!SetConsoleCtrlHandler(CtrlHandler, TRUE)) 
+    LOG(2) << "Could not set control handler; Ctrl-C behavior may be invalid";
+
+  return {move(processHandle), move(threadHandle)};
+}
+
+
+// ------------------------------- Launcher -------------------------------- //
+// LaunchProcess always returns, the shim exits on its own when not waiting
+constexpr bool LAUNCH_REPLACES_SHIM = false;
+
+struct ChildProcess {
+  unique_handle process;
+  unique_handle thread;
+  unique_handle job;
+  Relay         relay;
+};
+
+
+/**@brief  Start the application
+ *
+ * @param  PLAN:    what to run (see RESOLVELAUNCH)
+ * @param  CHILD:   handles of the started process
+ *
+ * @return TRUE if the process was created
+ */
+bool LaunchProcess(const LaunchPlan& plan, ChildProcess& child) {
+  // Either create the relay's pipes, or as its host connect to them
+  const HANDLE* stdio = nullptr;
+  if (plan.relay) {
+    bool opened = plan.relay_host.empty() ?
+      child.relay.open(true) : child.relay.connect(plan.relay_host);
+    if (opened)
+      stdio = child.relay.child;
+    else
+      LOG(2) << "Could not create the relay pipes, using the shim's stdio";
+    if (stdio && !plan.tee_file.empty())
+      child.relay.teeTo(plan.tee_file);
+  }
+
+  EnvironmentBlock env = BuildEnvironment(plan.environment);
+  TRACE("environment");
+
+  tie(child.process, child.thread) =
+    MakeProcess(plan.path, plan.args, plan.working_dir, stdio,
+                stdio && plan.relay_host.empty() ? &child.relay : nullptr,
+                &env, &plan.sched);
+  TRACE("make_process");
+
+  if (!child.process)
+    return false;
+
+  bool capped = plan.sched.memory_limit || plan.sched.cpu_rate;
+  if (plan.wait || capped) {
+    // A job object allows groups of processes to be managed as a unit.
+    // Operations performed on a job object affect all processes associated
+    // with the job object. Specifically here we attach to child processes to
+    // make sure they terminate when the parent terminates as well (only when
+    // waiting, otherwise the job just outlives the shim to keep the caps).
+    child.job.reset(CreateJobObject(nullptr, nullptr));
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION jobInfo = {};
+
+    jobInfo.BasicLimitInformation.LimitFlags = 
+      JOB_OBJECT_LIMIT_SILENT_BREAKAWAY_OK;
+    if (plan.wait)
+      jobInfo.BasicLimitInformation.LimitFlags |=
+        JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+    ApplySchedLimits(child.job.get(), plan.sched, jobInfo);
+    
+    SetInformationJobObject(
+      child.job.get(),
+      JobObjectExtendedLimitInformation,
+      &jobInfo,
+      sizeof(jobInfo));
+    
+    AssignProcessToJobObject(child.job.get(), child.process.get());
+    TRACE("job_setup");
+  }
+
+  // Start the thread, now its limits are in place (elevated processes are
+  // already running)
+  if (child.thread) {
+    ResumeThread(child.thread.get());
+    TRACE("child_resume");
+  }
+
+  if (stdio) {
+    child.relay.start();
+    TRACE("relay");
+  }
+  
+  return true;
+}
+
+
+/**@brief  Wait for the application to exit
+ *
+ * @param  CHILD:       process from LAUNCHPROCESS (with PLAN.WAIT)
+ * @param  ACCOUNTING:  if given, filled from the job (WALL_US is left)
+ *
+ * @return exit code of the process
+ */
+int WaitProcess(ChildProcess& child, ProcessAccounting* accounting) {
+  DWORD exitCode = 1;
+  
+  // Wait till end of process
+  WaitForSingleObject(child.process.get(), INFINITE);
+  TRACE("wait");
+
+  // Whatever it wrote last may still be in the pipes
+  child.relay.finish();
+
+  // Get the exit code
+  GetExitCodeProcess(child.process.get(), &exitCode);
+
+  // Resources used by the whole process tree
+  if (accounting)
+    QueryJobAccounting(child.job.get(), *accounting);
+
+  return exitCode;
+}
+
+
+// ------------------------------------------------------------------------- //
+#endif  // LAUNCHER_WIN32_H
@@ -21,6 +21,13 @@
  *  - automatic conversion of FILESYSTEM::PATH objects
  *  - automatic conversion of BOOL
  *  - automatic attaching to console or stream to file
+ *  - LOG is a macro so filtered statements cost a single branch and levels
+ *    above LOG_MAX_LEVEL are removed by the compiler
+ *  - the console / file is attached once, on the first emitted message, and
+ *    released when the process exits
+ *  - file output is buffered and appended once at exit (see LOG_SINK.H)
+ *  - wide strings are converted in one pass into a reused buffer (see
+ *    UTF8.H)
  *
  *
  * ------------------------------------------------------------------------- 
@@ -44,8 +51,21 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <string>
+#include <cwchar>
+#include <log_sink.h>
+#include <utf8.h>
+#ifdef _WIN32
 #include <shlwapi.h>
 #pragma comment(lib, "Shlwapi.lib")
+#else
+#include <utility_functions.h>
+#endif
+
+// Compile-time threshold, any LOG statement above this level is dead code
+#ifndef LOG_MAX_LEVEL
+#define LOG_MAX_LEVEL 100
+#endif
 
 
 using namespace std;
@@ -57,117 +77,67 @@ struct structlog {
   string    false_value =   "No";
   string    file_ext =      ".log";
   filesystem::path log_file;
+  uint64_t  rotate_size =   0;          // Rotate the log file (0 = never)
+  int       rotate_files =  1;          // ... keeping this many old files
 };
 
 structlog LOGCFG;
 
-class LOG {
+
+// ------------------------------------------------------------------------- //
+/**@brief  Process wide output stream of the log
+ *
+ * Nothing is opened until the first message is actually emitted, at which
+ * point the console is attached (or the log file opened) exactly once. The
+ * console is released when the process exits.
+ */
+class LogStream {
 public:
-  LOG(int level) {
-    openStream();
-    
-    // Positive LEVEL - print out the header first
-    msglevel = level >= 0 ? level : -level;
-    if(LOGCFG.headers) 
-      operator<<(getHeader(level));
+  ~LogStream() {
+    close();
   }
 
-  // Same as LOG(0) w/o HEADER
-  LOG() {
-    openStream();
-  }
-  
-  ~LOG() {
-    closeStream();
+  void write(const string& msg) {
+    if(stream_type == 0)
+      open();
+    
+    if(stream_type == 1)
+      cerr << msg;
+    else if(stream_type == 2)
+      stream << msg;
+    else
+      sink.write(msg);
   }
-  
-  template <class T>
-  LOG &operator<<(T const & msg) {
-    if(msglevel > LOGCFG.level)
-      return *this;
 
-    // String
-    if constexpr ( is_same_v<T, string> ) {
-      return printString(msg);
-    }
-
-    // Character
-    if constexpr ( is_convertible_v<T, char const *>) {
-      string cmsg(msg);
-      return printString(cmsg);
-    }
-
-    // Wide String
-    if constexpr ( is_same_v<T, wstring> ) {
-      return printWString(msg);
-    }
-
-    // Wide Character
-    if constexpr ( is_convertible_v<T, wchar_t const *> ) {
-      wstring wmsg(msg);
-      return printWString(wmsg);
-    }
-
-    // Path
-    if constexpr ( is_same_v<T, filesystem::path> ) {
-      return printString("'" + msg.string() + "'");
-    }
-
-    // Boolean
-    if constexpr ( is_same_v<T, bool> ) {
-      return printString(msg ? LOGCFG.true_value : LOGCFG.false_value);
-    }
+  // Console output is flushed per line so it interleaves with the child's
+  void endLine() {
+    write("\n");
+    if(stream_type == 2)
+      stream.flush();
+  }
 
-    return printString("[could not output variable]");
+  // Write out anything buffered and give back the buffer (i.e. before
+  // waiting on the child)
+  void flush() {
+    if(stream_type == 2)
+      stream.flush();
+    else if(stream_type == 3)
+      sink.release();
   }
-  
-  
+
 private:
-  int   msglevel =      0;
   ofstream stream;
-  DWORD stream_type =   0;
+  LogSink  sink;
+  int   stream_type =   0;
   // 0 - not open
-  // 1 - console app                  - write to console
+  // 1 - console app                  - write to console (always for POSIX)
   // 2 - windows app  - found console - write to console
   // 3 - windows app  - no console    - write to file
   
-  inline string getHeader(int level) {
-    return
-      level == 1 ? "ERROR - " :
-      level == 2 ? "WARN  - " :
-      level == 3 ? "INFO  - " :
-      level == 4 ? "DEBUG - " :
-      "        ";
-  }
-
-  // ---------- Print String ---------- // 
-  LOG &printString(const string msg) {
-    cerr << msg;
-    return *this;
-  }
-  
-  // ---------- Print Wide String ---------- // 
-  LOG &printWString(const wstring msg) {
-    if(msg.empty())
-      return *this;
-    
-    int sz = WideCharToMultiByte(CP_UTF8, 0, &msg[0], (int)msg.size(),
-                                 0, 0, 0, 0);
-  
-    string converted_msg(sz, 0);
-    WideCharToMultiByte(CP_UTF8, 0, &msg[0], (int)msg.size(),
-                        &converted_msg[0], sz, 0, 0);
-
-    return printString(converted_msg);
-  }
-
-  
-  void openStream() {
-    if(stream_type > 0)
-      return;
-
+  void open() {
     stream_type = 1;
-  
+
+#ifdef _WIN32
     if(AttachConsole(ATTACH_PARENT_PROCESS)) {
       stream_type = 2;
       stream = ofstream("CONOUT$", ios::out);
@@ -177,23 +147,22 @@ private:
       stream_type = 3;
       if (LOGCFG.log_file.empty())
         setLogFile();
-      stream.open(LOGCFG.log_file, ios::out | ios::app);
+      sink.setFile(LOGCFG.log_file);
+      sink.setRotation(LOGCFG.rotate_size, LOGCFG.rotate_files);
     }
-    else 
-      return;
-
-    cerr.rdbuf(stream.rdbuf());
+#endif
   }
 
   
-  void closeStream() {
+  void close() {
     if(stream_type == 0)
       return;
 
-    operator<<("\n");
-
     // Cleanup and Close the Stream
+#ifdef _WIN32
     if(stream_type == 2) {
+      stream.flush();
+      
       // Mimics a console application to some extent...
       // ...from cmd.exe console, appears to add an extra new line
       // ...from powershell.exe, does not move the cursor (returns to position
@@ -212,13 +181,15 @@ private:
     
       FreeConsole();
     }
-    else if(stream_type == 3) 
-      stream.close();
+#endif
+    if(stream_type == 3) 
+      sink.flush();
 
     stream_type = 0;
   }
 
 
+#ifdef _WIN32
   void setLogFile() {
     wchar_t applicationPath[MAX_PATH];
     const auto applicationPathSize =
@@ -228,8 +199,130 @@ private:
     LOGCFG.log_file.replace_extension(LOGCFG.file_ext);
     return;
   }
+#endif
+};
+
+LogStream LOGSTREAM;
+
+
+// ------------------------------------------------------------------------- //
+/**@brief  A single log statement (i.e. one line)
+ *
+ * Only ever constructed by the LOG macro once the level has passed the filter,
+ * hence nothing here needs to check it again.
+ */
+class LogMessage {
+public:
+  LogMessage(int level) {
+    // Positive LEVEL - print out the header first
+    // Negative LEVEL - indent in place of the header
+    if(LOGCFG.headers) 
+      operator<<(getHeader(level));
+  }
+
+  // Same as LOG(0) w/o HEADER
+  LogMessage() {}
+  
+  ~LogMessage() {
+    LOGSTREAM.endLine();
+  }
+  
+  template <class T>
+  LogMessage &operator<<(T const & msg) {
+    // String
+    if constexpr ( is_same_v<T, string> ) {
+      return printString(msg);
+    }
+
+    // Character
+    else if constexpr ( is_convertible_v<T, char const *>) {
+      return printString(msg);
+    }
+
+    // Wide String
+    else if constexpr ( is_same_v<T, wstring> ) {
+      return printWString(msg.data(), msg.size());
+    }
+
+    // Wide Character
+    else if constexpr ( is_convertible_v<T, wchar_t const *> ) {
+      return printWString(msg, wcslen(msg));
+    }
+
+    // Path
+    else if constexpr ( is_same_v<T, filesystem::path> ) {
+      return printString("'" + msg.string() + "'");
+    }
+
+    // Boolean
+    else if constexpr ( is_same_v<T, bool> ) {
+      return printString(msg ? LOGCFG.true_value : LOGCFG.false_value);
+    }
+
+    // Numbers (e.g. DWORD error and exit codes)
+    else if constexpr ( is_arithmetic_v<T> ) {
+      return printString(to_string(msg));
+    }
+
+    else
+      return printString("[could not output variable]");
+  }
+  
+  
+private:
+  inline string getHeader(int level) {
+    return
+      level == 1 ? "ERROR - " :
+      level == 2 ? "WARN  - " :
+      level == 3 ? "INFO  - " :
+      level == 4 ? "DEBUG - " :
+      "        ";
+  }
+
+  // ---------- Print String ---------- // 
+  LogMessage &printString(const string& msg) {
+    LOGSTREAM.write(msg);
+    return *this;
+  }
   
+  // ---------- Print Wide String ---------- // 
+  // Converted in one pass into a buffer kept from message to message
+  LogMessage &printWString(const wchar_t* msg, size_t size) {
+    if(size == 0)
+      return *this;
+
+    static thread_local string converted;
+    converted.clear();
+    AppendUtf8(msg, size, converted);
+    return printString(converted);
+  }
 };
 
+
+// ------------------------------------------------------------------------- //
+/**@brief  Level of a LOG statement, i.e. LOG() is 0 and LOG(-N) is N
+ */
+constexpr int LogLevelOf(int level = 0) {
+  return level < 0 ? -level : level;
+}
+
+/**@brief  Log a line
+ *
+ * Usage:  LOG(level) << ... for a line with a header
+ *         LOG(-level) << ... for an indented line of the same level
+ *         LOG() << ... for a line without a header (always emitted)
+ *
+ * A statement above LOGCFG.level is skipped with a single comparison (none of
+ * its arguments are evaluated) and one above LOG_MAX_LEVEL is removed at
+ * compile time. Written as a FOR running its statement at most once, so it
+ * nests safely within other IFs without leaving an ELSE to dangle (i.e.
+ * "if (x) LOG(1) << ...; else ..." is warning free under -Wall).
+ */
+#define LOG(...)                                                \
+  for (bool log_emit = LogLevelOf(__VA_ARGS__) <= LOG_MAX_LEVEL && \
+         LogLevelOf(__VA_ARGS__) <= LOGCFG.level;               \
+       log_emit; log_emit = false)                              \
+    LogMessage{__VA_ARGS__}
+
 // ------------------------------------------------------------------------- //
 #endif // LOG_H
@@ -0,0 +1,309 @@
+// ------------------------------------------------------------------------- //
+// Buffered Log Sink                                                         //
+// ------------------------------------------------------------------------- //
+/**@file    LOG_SINK.H
+ * @brief   Process wide, buffered writer for the log file
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Formatted log output is collected in memory and appended to the file in a
+ * single write, normally once when the process exits. Should the buffer fill
+ * up, the complete lines are written early and only the partial line kept.
+ *
+ * Each flush:
+ *  - opens the file for appending
+ *  - takes an exclusive lock (so concurrent shims never interleave lines),
+ *    the lines being dropped rather than written should it not be had
+ *  - rotates <file> to <file>.1 ... <file>.N when it would exceed ROTATE_SIZE
+ *    and starts over with the new file (bench/log_sink.cpp checks this)
+ *  - writes the buffer in one call and closes the file again
+ *
+ * Works with both Win32 and POSIX file APIs.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <cstdint>
+#include <filesystem>
+#include <system_error>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+// Tries at appending to the current file while others keep rotating it,
+// after which the lines go to whichever file was opened rather than lost
+// (but never unlocked, dropped if no try got the lock)
+#define ROTATE_ATTEMPTS 64
+
+
+// ------------------------------------------------------------------------- //
+class LogSink {
+public:
+  LogSink(size_t capacity = 64 * 1024) : capacity(capacity) {}
+
+  ~LogSink() {
+    flush();
+  }
+
+  void setFile(const filesystem::path& path) {
+    file = path;
+  }
+
+  /**@brief  Turn on size based rotation
+   *
+   * @param  SIZE:    rotate once the file would grow past this (0 = never)
+   * @param  FILES:   number of old files kept, i.e. <file>.1 ... <file>.N
+   */
+  void setRotation(uint64_t size, int files = 1) {
+    rotate_size   = size;
+    rotate_files  = files < 1 ? 1 : files;
+  }
+
+  // Buffer a message, writing out the complete lines if it would overflow
+  void write(const char* msg, size_t size) {
+    if(buffer.size() + size > capacity) {
+      size_t eol = buffer.rfind('\n');
+      if(eol != string::npos) {
+        append(buffer.data(), eol + 1);
+        buffer.erase(0, eol + 1);
+      }
+    }
+
+    if(buffer.capacity() == 0)
+      buffer.reserve(capacity);
+    buffer.append(msg, size);
+  }
+
+  void write(const string& msg) {
+    write(msg.data(), msg.size());
+  }
+
+  // Append everything buffered to the file
+  bool flush() {
+    if(buffer.empty())
+      return true;
+
+    bool ok = append(buffer.data(), buffer.size());
+    buffer.clear();
+    return ok;
+  }
+
+  // Flush, then give back the buffer until the next write
+  bool release() {
+    bool ok = flush();
+    string().swap(buffer);
+    return ok;
+  }
+
+
+private:
+  string            buffer;
+  size_t            capacity;
+  filesystem::path  file;
+  uint64_t          rotate_size     = 0;
+  int               rotate_files    = 1;
+
+
+  // --------------------- Rotate ---------------------- //
+  // Called while holding the lock, shifts <file>.N-1 -> <file>.N ... <file>
+  // -> <file>.1
+  void rotate() {
+    error_code ec;
+    for(int i = rotate_files; i > 1; i--) {
+      filesystem::path older = file.native() + numbered(i - 1);
+      if(filesystem::exists(older, ec))
+        filesystem::rename(older, file.native() + numbered(i), ec);
+    }
+    filesystem::rename(file, file.native() + numbered(1), ec);
+  }
+
+  static filesystem::path::string_type numbered(int i) {
+    filesystem::path::string_type suffix;
+    suffix += '.';
+    for(char c : to_string(i))
+      suffix += c;
+    return suffix;
+  }
+
+
+#ifdef _WIN32
+  // ---------------------- Win32 ---------------------- //
+  // Appending alone does not let LockFileEx lock the file, hence also
+  // FILE_WRITE_DATA with every write at the end (see APPEND)
+  HANDLE open() {
+    return CreateFileW(
+        file.c_str(),
+        FILE_APPEND_DATA | FILE_WRITE_DATA | FILE_READ_ATTRIBUTES,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  }
+
+  // Does the handle still refer to FILE (i.e. not rotated by someone else)?
+  bool isCurrent(HANDLE handle) {
+    HANDLE current = CreateFileW(
+        file.c_str(), FILE_READ_ATTRIBUTES,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(current == INVALID_HANDLE_VALUE)
+      return false;
+
+    BY_HANDLE_FILE_INFORMATION a, b;
+    bool same =
+      GetFileInformationByHandle(handle, &a) &&
+      GetFileInformationByHandle(current, &b) &&
+      a.dwVolumeSerialNumber == b.dwVolumeSerialNumber &&
+      a.nFileIndexHigh == b.nFileIndexHigh &&
+      a.nFileIndexLow == b.nFileIndexLow;
+    CloseHandle(current);
+    return same;
+  }
+
+  bool append(const char* data, size_t size) {
+    if(file.empty())
+      return false;
+
+    for(int attempt = 0; attempt < ROTATE_ATTEMPTS; attempt++) {
+      HANDLE handle = open();
+      if(handle == INVALID_HANDLE_VALUE)
+        return false;
+
+      OVERLAPPED region = {};
+      if(!LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD,
+                     &region)) {
+        CloseHandle(handle);
+        continue;
+      }
+
+      // Lost a race with another process rotating the file
+      if(rotate_size > 0 && !isCurrent(handle) &&
+         attempt + 1 < ROTATE_ATTEMPTS) {
+        UnlockFileEx(handle, 0, MAXDWORD, MAXDWORD, &region);
+        CloseHandle(handle);
+        continue;
+      }
+
+      // Start the next file, then append to it as anyone else would (it may
+      // have filled up and been rotated again before we hold its lock)
+      LARGE_INTEGER file_size = {};
+      GetFileSizeEx(handle, &file_size);
+      if(rotate_size > 0 && file_size.QuadPart > 0 &&
+         (uint64_t)file_size.QuadPart + size > rotate_size &&
+         attempt + 1 < ROTATE_ATTEMPTS) {
+        rotate();
+        UnlockFileEx(handle, 0, MAXDWORD, MAXDWORD, &region);
+        CloseHandle(handle);
+        continue;
+      }
+
+      // An offset of all ones writes at the end of the file
+      OVERLAPPED at_end = {};
+      at_end.Offset     = MAXDWORD;
+      at_end.OffsetHigh = MAXDWORD;
+      DWORD written = 0;
+      BOOL ok = WriteFile(handle, data, (DWORD)size, &written, &at_end);
+      UnlockFileEx(handle, 0, MAXDWORD, MAXDWORD, &region);
+      CloseHandle(handle);
+      return ok && written == size;
+    }
+    return false;
+  }
+
+#else
+  // ---------------------- POSIX ---------------------- //
+  int open() {
+    return ::open(file.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                  0644);
+  }
+
+  // Does the descriptor still refer to FILE (i.e. not rotated by someone else)?
+  bool isCurrent(int fd) {
+    struct stat a, b;
+    return
+      fstat(fd, &a) == 0 && stat(file.c_str(), &b) == 0 &&
+      a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+  }
+
+  bool append(const char* data, size_t size) {
+    if(file.empty())
+      return false;
+
+    for(int attempt = 0; attempt < ROTATE_ATTEMPTS; attempt++) {
+      int fd = open();
+      if(fd < 0)
+        return false;
+
+      int locked;
+      while((locked = flock(fd, LOCK_EX)) != 0 && errno == EINTR) {}
+      if(locked != 0) {
+        ::close(fd);
+        continue;
+      }
+
+      // Lost a race with another process rotating the file
+      if(rotate_size > 0 && !isCurrent(fd) && attempt + 1 < ROTATE_ATTEMPTS) {
+        ::close(fd);
+        continue;
+      }
+
+      // Start the next file, then append to it as anyone else would (it may
+      // have filled up and been rotated again before we hold its lock)
+      struct stat st;
+      if(rotate_size > 0 && fstat(fd, &st) == 0 && st.st_size > 0 &&
+         (uint64_t)st.st_size + size > rotate_size &&
+         attempt + 1 < ROTATE_ATTEMPTS) {
+        rotate();
+        ::close(fd);
+        continue;
+      }
+
+      // A single write to an O_APPEND file, retried only if interrupted
+      bool ok = true;
+      while(size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if(written < 0) {
+          if(errno == EINTR) continue;
+          ok = false;
+          break;
+        }
+        data += written;
+        size -= written;
+      }
+      ::close(fd);
+      return ok;
+    }
+    return false;
+  }
+#endif
+};
+
+
+// ------------------------------------------------------------------------- //
+#endif  // LOG_SINK_H
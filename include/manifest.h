@@ -0,0 +1,182 @@
+// ------------------------------------------------------------------------- //
+// Shim Manifest                                                             //
+// ------------------------------------------------------------------------- //
+/**@file    MANIFEST.H
+ * @brief   SHA-256 manifest of the shims created, and checking shims by it
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * With --manifest FILE the generator adds the shim it creates to FILE, a
+ * line each, tab separated, with paths in UTF-8:
+ *
+ *      SHA256  SIZE  SHIM  TARGET
+ *
+ * Runs at once (e.g. one per executable from a script) are merged under a
+ * lock (UpdateFile), a shim created again replacing its line. The digest is
+ * taken as the shim is written (AtomicFile::write) rather than read back,
+ * except on Windows where EndUpdateResource writes it out of sight.
+ *
+ *  ParseManifest / FormatManifest
+ *      reads / writes the lines, sorted by SHIM
+ *
+ *  AddToManifest
+ *      adds or replaces a shim's line in FILE
+ *
+ *  VerifyManifest
+ *      checks the shims against their lines, hashed by several threads at
+ *      once with large sequential reads (HashFile)
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include <sha256.h>
+#include <atomic_file.h>
+
+using namespace std;
+
+#define MANIFEST_HEADER     "# sha256\tsize\tshim\ttarget"
+
+
+struct ManifestEntry {
+  string    sha256;
+  uint64_t  size =  0;
+  string    shim;                       // paths in UTF-8
+  string    target;
+};
+
+
+// ------------------------------ Read / Write ----------------------------- //
+// Lines that are not four fields (e.g. the header) are skipped
+vector<ManifestEntry> ParseManifest(const string& text) {
+  vector<ManifestEntry> entries;
+  istringstream lines(text);
+  string line;
+  while (getline(lines, line)) {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+
+    vector<string> fields;
+    for (size_t at = 0, end = 0; end != string::npos; at = end + 1) {
+      end = line.find('\t', at);
+      fields.push_back(line.substr(at, end - at));
+    }
+    if (fields.size() != 4 || fields[0].size() != 64 || fields[2].empty() ||
+        fields[1].empty() ||
+        fields[1].find_first_not_of("0123456789") != string::npos)
+      continue;
+    entries.push_back({fields[0], strtoull(fields[1].c_str(), nullptr, 10),
+                       fields[2], fields[3]});
+  }
+  return entries;
+}
+
+string FormatManifest(vector<ManifestEntry> entries) {
+  sort(entries.begin(), entries.end(),
+       [](const ManifestEntry& a, const ManifestEntry& b) {
+         return a.shim < b.shim;
+       });
+  string text = MANIFEST_HEADER "\n";
+  for (auto& e : entries)
+    text += e.sha256 + "\t" + to_string(e.size) + "\t" + e.shim + "\t" +
+            e.target + "\n";
+  return text;
+}
+
+
+/**@brief  Add a shim to FILE, replacing any line it already has
+ *
+ * @return FALSE if FILE could not be updated, or a path would not fit on a
+ *         line (a tab or line break in it)
+ */
+bool AddToManifest(const filesystem::path& file, const ManifestEntry& entry) {
+  if ((entry.shim + entry.target).find_first_of("\t\r\n") != string::npos)
+    return false;
+
+  return UpdateFile(file, [&](const string& text) {
+    vector<ManifestEntry> entries = ParseManifest(text);
+    entries.erase(remove_if(entries.begin(), entries.end(),
+                            [&](const ManifestEntry& e) {
+                              return e.shim == entry.shim;
+                            }),
+                  entries.end());
+    entries.push_back(entry);
+    return FormatManifest(entries);
+  });
+}
+
+
+// -------------------------------- Verify --------------------------------- //
+/**@brief  Check shims against the manifest
+ *
+ * @param  ENTRIES: the manifest
+ * @param  DIR:     where the shims are, by name, if not where it says
+ * @param  THREADS: hashing at once (0 for one per CPU)
+ *
+ * @return the problem with each shim ("missing", "wrong size", "wrong
+ *         SHA-256"), or nullptr if there is none
+ */
+vector<const char*> VerifyManifest(const vector<ManifestEntry>& entries,
+                                   const filesystem::path& dir = {},
+                                   unsigned threads = 0) {
+  vector<const char*> problems(entries.size(), nullptr);
+  atomic<size_t>      next(0);
+
+  auto check = [&] {
+    for (size_t i; (i = next++) < entries.size(); ) {
+      filesystem::path shim = filesystem::u8path(entries[i].shim);
+      if (!dir.empty())
+        shim = dir / shim.filename();
+
+      string   digest;
+      uint64_t size;
+      if (!HashFile(shim, digest, size))
+        problems[i] = "missing";
+      else if (size != entries[i].size)
+        problems[i] = "wrong size";
+      else if (digest != entries[i].sha256)
+        problems[i] = "wrong SHA-256";
+    }
+  };
+
+  if (threads == 0)
+    threads = max(1u, thread::hardware_concurrency());
+  threads = (unsigned)min<size_t>(threads, entries.size());
+  vector<thread> workers;
+  for (unsigned t = 1; t < threads; t++)
+    workers.emplace_back(check);
+  check();
+  for (auto& worker : workers)
+    worker.join();
+  return problems;
+}
+
+
+// ------------------------------------------------------------------------- //
+#endif  // MANIFEST_H
@@ -0,0 +1,208 @@
+// ------------------------------------------------------------------------- //
+// Generator Metrics                                                         //
+// ------------------------------------------------------------------------- //
+/**@file    METRICS.H
+ * @brief   OpenMetrics counters of shim generation, accumulated over runs
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * With --metrics FILE the generator adds its run to FILE in the OpenMetrics
+ * text format, e.g. for a node exporter's textfile collector:
+ *
+ *  shim_exec_shims_total{result}           created, updated or skipped
+ *  shim_exec_read_bytes_total              from the template and sources
+ *  shim_exec_written_bytes_total           to the shims
+ *  shim_exec_errors_total{cause}           why shims were skipped
+ *  shim_exec_phase_duration_seconds{phase} histogram of unpack,
+ *                                          copy_resources, embed_config,
+ *                                          write and commit
+ *
+ * Runs at once (e.g. one per executable from a script) are merged under a
+ * lock on FILE.lock: the totals so far are read back, added to, and written
+ * to a temporary file that replaces FILE (UpdateFile), so a scrape never sees
+ * half of it.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+// ------------------------------------------------------------------------- //
+#include <map>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <filesystem>
+#include <atomic_file.h>
+
+using namespace std;
+
+#define METRICS_PREFIX      "shim_exec_"
+
+const char*  METRICS_RESULTS[] = {"created", "updated", "skipped"};
+const char*  METRICS_PHASES[]  = {"unpack", "copy_resources", "embed_config",
+                                  "write", "commit"};
+const char*  METRICS_ERRORS[]  = {
+  "no_source",            // SOURCE executable must be specified
+  "no_output",            // OUTPUT path must be specified
+  "source_missing",       // SOURCE path does not exist
+  "source_not_file",      // SOURCE must be a regular file
+  "not_executable",       // SOURCE must be an executable
+  "output_dir_missing",   // OUTPUT directory does not exist
+  "overwrite_source",     // Cannot overwrite SOURCE
+  "output_not_file",      // OUTPUT already exists but is not a regular file
+  "icon_unreadable",      // Could not read an icon from --iconpath
+  "args_unreadable",      // Could not read --command @FILE
+  "unpack_failed",        // Could not unpack shim
+  "embed_failed",         // Failed to add resource
+  "commit_failed"         // Could not replace OUTPUT with the new shim
+};
+const double METRICS_BUCKETS[] = {0.0001, 0.00025, 0.0005, 0.001, 0.0025,
+                                  0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5,
+                                  1, 2.5};
+
+
+// ------------------------------------------------------------------------- //
+class GeneratorMetrics {
+public:
+  // Add N to a sample, e.g. "shims_total{result=\"created\"}"
+  void add(const string& sample, double n = 1) {
+    samples[METRICS_PREFIX + sample] += n;
+  }
+
+  void addResult(const char* result) {
+    add(string("shims_total{result=\"") + result + "\"}");
+  }
+
+  void addError(const char* cause) {
+    add(string("errors_total{cause=\"") + cause + "\"}");
+  }
+
+  // Add one duration to the phase's histogram
+  void observe(const char* phase, double seconds) {
+    string labels = string("{phase=\"") + phase + "\"";
+    for (double le : METRICS_BUCKETS)
+      if (seconds <= le)
+        add("phase_duration_seconds_bucket" + labels + ",le=\"" +
+            number(le) + "\"}");
+    add("phase_duration_seconds_bucket" + labels + ",le=\"+Inf\"}");
+    add("phase_duration_seconds_count" + labels + "}");
+    add("phase_duration_seconds_sum" + labels + "}", seconds);
+  }
+
+  // Times a phase until it goes out of scope
+  struct Phase {
+    GeneratorMetrics& metrics;
+    const char*       name;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    ~Phase() {
+      metrics.observe(name, chrono::duration<double>(
+          chrono::steady_clock::now() - start).count());
+    }
+  };
+
+  Phase phase(const char* name) {
+    return Phase{*this, name};
+  }
+
+
+  // Every sample, in the OpenMetrics text format
+  string format() const {
+    ostringstream text;
+    auto family = [&](const char* name, const char* type, const char* help) {
+      text << "# TYPE " METRICS_PREFIX << name << " " << type << "\n"
+           << "# HELP " METRICS_PREFIX << name << " " << help << "\n";
+    };
+    auto sample = [&](const string& key) {
+      auto found = samples.find(METRICS_PREFIX + key);
+      text << METRICS_PREFIX << key << " "
+           << number(found == samples.end() ? 0 : found->second) << "\n";
+    };
+
+    family("shims", "counter", "Shims created, updated or skipped.");
+    for (const char* result : METRICS_RESULTS)
+      sample(string("shims_total{result=\"") + result + "\"}");
+
+    family("read_bytes", "counter", "Bytes read from templates and sources.");
+    sample("read_bytes_total");
+    family("written_bytes", "counter", "Bytes written to shims.");
+    sample("written_bytes_total");
+
+    family("errors", "counter", "Shims skipped, by cause.");
+    for (const char* cause : METRICS_ERRORS)
+      sample(string("errors_total{cause=\"") + cause + "\"}");
+
+    family("phase_duration_seconds", "histogram",
+           "Time spent in each phase of creating a shim.");
+    text << "# UNIT " METRICS_PREFIX "phase_duration_seconds seconds\n";
+    for (const char* phase : METRICS_PHASES) {
+      string labels = string("{phase=\"") + phase + "\"";
+      for (double le : METRICS_BUCKETS)
+        sample("phase_duration_seconds_bucket" + labels + ",le=\"" +
+               number(le) + "\"}");
+      sample("phase_duration_seconds_bucket" + labels + ",le=\"+Inf\"}");
+      sample("phase_duration_seconds_count" + labels + "}");
+      sample("phase_duration_seconds_sum" + labels + "}");
+    }
+
+    text << "# EOF\n";
+    return text.str();
+  }
+
+  // Add the samples of TEXT (as written by FORMAT)
+  void parse(const string& text) {
+    istringstream lines(text);
+    string line;
+    while (getline(lines, line)) {
+      size_t space = line.rfind(' ');
+      if (line.empty() || line[0] == '#' || space == string::npos)
+        continue;
+      samples[line.substr(0, space)] += strtod(line.c_str() + space + 1,
+                                               nullptr);
+    }
+  }
+
+
+  /**@brief  Add the samples to those in FILE
+   *
+   * @return FALSE if FILE could not be locked or replaced
+   */
+  bool merge(const filesystem::path& file) const {
+    return UpdateFile(file, [&](const string& text) {
+      GeneratorMetrics total = *this;
+      total.parse(text);
+      return total.format();
+    });
+  }
+
+private:
+  map<string, double> samples;
+
+  static string number(double value) {
+    ostringstream text;
+    text.precision(15);
+    text << value;
+    return text.str();
+  }
+};
+
+
+// ------------------------------------------------------------------------- //
+#endif  // METRICS_H
@@ -0,0 +1,289 @@
+// ------------------------------------------------------------------------- //
+// PE Resources                                                              //
+// ------------------------------------------------------------------------- //
+/**@file    PE_RESOURCES.H
+ * @brief   Lists and reads the resources of a PE (Windows) executable
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * A PE file's resources live in a tree in its resource section, found
+ * through the resource data directory of the optional header:
+ *
+ *     type        e.g. RT_ICON, RT_GROUP_ICON, RT_VERSION (or a name)
+ *       name      an ID (or a name)
+ *         lang    a language ID, e.g. 0x409 for en-US
+ *           data  RVA, size and code page of the bytes
+ *
+ * The tree is walked with seeks and small reads, so only the headers and
+ * directories are read, never the whole file, and resource bytes are read
+ * only when asked for. Only the standard library is used, hence the
+ * resources of an executable can be read on any platform. Every offset is
+ * checked against the section, so a truncated or malformed file simply has
+ * no (or fewer) resources.
+ *
+ *  ReadPeResources
+ *      lists the resources of a file (or stream)
+ *
+ *  ReadPeResource
+ *      gets the bytes of one
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef PE_RESOURCES_H
+#define PE_RESOURCES_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+// Resource types (as RT_* of winuser.h)
+#define PE_RT_ICON          3
+#define PE_RT_RCDATA        10
+#define PE_RT_GROUP_ICON    14
+#define PE_RT_VERSION       16
+
+// More is taken as a malformed file (e.g. entries sharing subdirectories)
+#define PE_MAX_RESOURCES    65536
+#define PE_MAX_ENTRIES      262144      // directory entries walked
+
+using namespace std;
+
+struct PeResource {
+  uint16_t  type =          0;          // 0 if named, see TYPE_NAME
+  wstring   type_name;
+  uint16_t  id =            0;          // 0 if named, see NAME
+  wstring   name;
+  uint16_t  lang =          0;
+  uint32_t  code_page =     0;
+  uint64_t  offset =        0;          // of the bytes in the file
+  uint32_t  size =          0;
+};
+
+
+// ------------------------------ PE Headers ------------------------------- //
+/**@brief  Reads little endian integers of a PE file
+ */
+class PeReader {
+public:
+  PeReader(istream& file) : file(file) {}
+
+  bool read(uint64_t offset, void* data, size_t size) {
+    file.clear();
+    file.seekg(offset);
+    file.read((char*)data, size);
+    return file.gcount() == (streamsize)size;
+  }
+
+  // Unsigned integer of SIZE bytes at OFFSET (0 if past the end)
+  uint32_t get(uint64_t offset, int size) {
+    unsigned char bytes[4] = {};
+    if (!read(offset, bytes, size))
+      return 0;
+
+    uint32_t value = 0;
+    for (int i = 0; i < size; i++)
+      value |= (uint32_t)bytes[i] << (8 * i);
+    return value;
+  }
+
+  // Length of the file
+  uint64_t length() {
+    file.clear();
+    file.seekg(0, ios::end);
+    streamoff end = file.tellg();
+    return end > 0 ? (uint64_t)end : 0;
+  }
+
+private:
+  istream&  file;
+};
+
+
+// The resource section: where it is in memory and in the file
+struct PeSection {
+  uint32_t  rva =           0;          // of the resource directory
+  uint32_t  size =          0;          // of the directory's section from RVA
+  uint64_t  offset =        0;          // of RVA in the file
+};
+
+/**@brief  Find the resource section
+ *
+ * @return FALSE if FILE is not a PE file or has no resources
+ */
+bool FindPeResourceSection(PeReader& pe, PeSection& rsrc) {
+  unsigned char magic[4];
+  if (!pe.read(0, magic, 2) || memcmp(magic, "MZ", 2))
+    return false;
+
+  uint32_t header = pe.get(0x3C, 4);          // e_lfanew
+  if (!pe.read(header, magic, 4) || memcmp(magic, "PE\0\0", 4))
+    return false;
+
+  uint32_t coff      = header + 4;
+  uint16_t sections  = pe.get(coff + 2, 2);
+  uint16_t opt_size  = pe.get(coff + 16, 2);
+  uint32_t optional  = coff + 20;
+  uint16_t opt_magic = pe.get(optional, 2);
+
+  // Data directories follow the PE32 / PE32+ specific fields
+  uint32_t dirs = opt_magic == 0x10B ? 96 : opt_magic == 0x20B ? 112 : 0;
+  if (!dirs || pe.get(optional + dirs - 4, 4) < 3 ||  // NumberOfRvaAndSizes
+      dirs + 3 * 8 > opt_size)
+    return false;
+  rsrc.rva = pe.get(optional + dirs + 2 * 8, 4);
+  if (!rsrc.rva)
+    return false;
+
+  // Section holding the directory
+  uint32_t table = optional + opt_size;
+  for (uint16_t s = 0; s < sections; s++) {
+    uint32_t at        = table + s * 40;
+    uint32_t virt_size = pe.get(at + 8, 4);
+    uint32_t address   = pe.get(at + 12, 4);
+    uint32_t raw_size  = pe.get(at + 16, 4);
+    uint32_t raw       = pe.get(at + 20, 4);
+    uint32_t size      = max(virt_size, raw_size);
+    if (rsrc.rva < address || rsrc.rva - address >= size)
+      continue;
+
+    // Only what is in the file can be read
+    uint32_t skip   = rsrc.rva - address;
+    uint64_t length = pe.length();
+    if (skip >= raw_size || (uint64_t)raw + skip >= length)
+      return false;
+    rsrc.offset = (uint64_t)raw + skip;
+    rsrc.size   = min<uint64_t>(raw_size - skip, length - rsrc.offset);
+    return true;
+  }
+  return false;
+}
+
+// Name (a length prefixed UTF-16 string) at OFFSET within the section
+wstring ReadPeName(PeReader& pe, const PeSection& rsrc, uint32_t offset) {
+  if ((uint64_t)offset + 2 > rsrc.size)
+    return L"";
+  uint16_t length = pe.get(rsrc.offset + offset, 2);
+  wstring  name;
+  for (uint32_t i = 0; i < length && offset + 4 + 2 * i <= rsrc.size; i++)
+    name += (wchar_t)pe.get(rsrc.offset + offset + 2 + 2 * i, 2);
+  return name;
+}
+
+/**@brief  Walk a directory of the tree, adding the resources under it
+ *
+ * @param  LEVEL:   0 - types, 1 - names, 2 - languages
+ * @param  BUDGET:  entries that may still be walked
+ */
+void WalkPeDirectory(PeReader& pe, const PeSection& rsrc, uint32_t offset,
+                     int level, PeResource resource,
+                     vector<PeResource>& resources, size_t& budget) {
+  if ((uint64_t)offset + 16 > rsrc.size)
+    return;
+  uint32_t entries = pe.get(rsrc.offset + offset + 12, 2) +
+    pe.get(rsrc.offset + offset + 14, 2);
+
+  for (uint32_t e = 0; e < entries; e++) {
+    uint64_t at = (uint64_t)offset + 16 + e * 8;
+    if (at + 8 > rsrc.size || resources.size() >= PE_MAX_RESOURCES ||
+        budget == 0)
+      return;
+    budget--;
+    uint32_t key  = pe.get(rsrc.offset + at, 4);
+    uint32_t data = pe.get(rsrc.offset + at + 4, 4);
+
+    // Named (high bit, an offset to the name) or an ID
+    wstring  name =
+      key & 0x80000000 ? ReadPeName(pe, rsrc, key & 0x7FFFFFFF) : L"";
+    uint16_t id   = key & 0x80000000 ? 0 : (uint16_t)key;
+    if (level == 0) {
+      resource.type      = id;
+      resource.type_name = name;
+    }
+    else if (level == 1) {
+      resource.id   = id;
+      resource.name = name;
+    }
+    else
+      resource.lang = id;
+
+    // A subdirectory (high bit) above the languages, the data entry below
+    bool directory = data & 0x80000000;
+    data &= 0x7FFFFFFF;
+    if (level < 2) {
+      if (directory && data > offset)     // only forward, hence no loops
+        WalkPeDirectory(pe, rsrc, data, level + 1, resource, resources,
+                        budget);
+      continue;
+    }
+    if (directory || (uint64_t)data + 16 > rsrc.size)
+      continue;
+
+    uint32_t rva       = pe.get(rsrc.offset + data, 4);
+    resource.size      = pe.get(rsrc.offset + data + 4, 4);
+    resource.code_page = pe.get(rsrc.offset + data + 8, 4);
+    if (rva < rsrc.rva ||
+        (uint64_t)rva - rsrc.rva + resource.size > rsrc.size)
+      continue;                               // not within the section
+    resource.offset = rsrc.offset + (rva - rsrc.rva);
+    resources.push_back(resource);
+  }
+}
+
+
+// -------------------------------- Public --------------------------------- //
+/**@brief  List the resources of a PE file
+ *
+ * @param  FILE:        the executable (or DLL), read with seeks
+ * @param  RESOURCES:   every resource found, in the order of the tree
+ *
+ * @return FALSE if FILE is not a PE file or has no resource section
+ */
+bool ReadPeResources(istream& file, vector<PeResource>& resources) {
+  resources.clear();
+  PeReader  pe(file);
+  PeSection rsrc;
+  if (!FindPeResourceSection(pe, rsrc))
+    return false;
+  size_t budget = PE_MAX_ENTRIES;
+  WalkPeDirectory(pe, rsrc, 0, 0, PeResource(), resources, budget);
+  return true;
+}
+
+bool ReadPeResources(const filesystem::path& path,
+                     vector<PeResource>& resources) {
+  ifstream file(path, ios::in | ios::binary);
+  return file && ReadPeResources(file, resources);
+}
+
+
+/**@brief  Get the bytes of a resource listed by READPERESOURCES
+ */
+bool ReadPeResource(istream& file, const PeResource& resource, string& data) {
+  data.resize(resource.size);
+  return PeReader(file).read(resource.offset, &data[0], resource.size);
+}
+
+
+// ------------------------------------------------------------------------- //
+#endif  // PE_RESOURCES_H
@@ -0,0 +1,169 @@
+// ------------------------------------------------------------------------- //
+// Process Accounting                                                        //
+// ------------------------------------------------------------------------- //
+/**@file    PROCESS_ACCOUNTING.H
+ * @brief   Resource usage of a child process (tree) once it has exited
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Defines the following:
+ *
+ *  ProcessAccounting
+ *      wall / user / kernel time, peak memory, I/O bytes and the number of
+ *      processes in the tree
+ *
+ *  QueryJobAccounting      (Win32)
+ *      fills it from the job object the child was assigned to, i.e. the
+ *      whole process tree
+ *
+ *  WaitProcessAccounting   (POSIX)
+ *      reaps the child with wait4 and fills it from its rusage, which covers
+ *      the child and any descendants it waited for. Peak memory is that of
+ *      the largest single process and the process count is always 1.
+ *
+ *  FormatAccounting
+ *      one JSON line for the log or a sidecar file
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef PROCESS_ACCOUNTING_H
+#define PROCESS_ACCOUNTING_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#endif
+
+#include <utility_functions.h>
+
+using namespace std;
+
+struct ProcessAccounting {
+  uint64_t  wall_us =       0;
+  uint64_t  user_us =       0;
+  uint64_t  kernel_us =     0;
+  uint64_t  peak_memory =   0;          // bytes
+  uint64_t  read_bytes =    0;
+  uint64_t  write_bytes =   0;
+  uint64_t  processes =     0;
+};
+
+
+#ifdef _WIN32
+/**@brief  Get the accounting of every process (ever) assigned to a job
+ *
+ * @param  JOB:     job object handle
+ * @param  ACC:     accounting to fill (WALL_US is left to the caller)
+ *
+ * @return TRUE if the job could be queried
+ */
+bool QueryJobAccounting(HANDLE job, ProcessAccounting& acc) {
+  JOBOBJECT_BASIC_AND_IO_ACCOUNTING_INFORMATION basic = {};
+  JOBOBJECT_EXTENDED_LIMIT_INFORMATION extended = {};
+
+  if (!QueryInformationJobObject(
+          job, JobObjectBasicAndIoAccountingInformation,
+          &basic, sizeof(basic), nullptr))
+    return false;
+
+  QueryInformationJobObject(
+      job, JobObjectExtendedLimitInformation,
+      &extended, sizeof(extended), nullptr);
+
+  // Times are in 100ns ticks
+  acc.user_us       = basic.BasicInfo.TotalUserTime.QuadPart / 10;
+  acc.kernel_us     = basic.BasicInfo.TotalKernelTime.QuadPart / 10;
+  acc.processes     = basic.BasicInfo.TotalProcesses;
+  acc.read_bytes    = basic.IoInfo.ReadTransferCount;
+  acc.write_bytes   = basic.IoInfo.WriteTransferCount;
+  acc.peak_memory   = extended.PeakJobMemoryUsed;
+  return true;
+}
+
+#else
+/**@brief  Wait for a child and get its accounting
+ *
+ * @param  PID:     child process
+ * @param  STATUS:  wait status as from waitpid
+ * @param  ACC:     accounting to fill (WALL_US is left to the caller)
+ * @param  OPTIONS: as for waitpid (e.g. WUNTRACED to return when it stops,
+ *                  ACC then being incomplete)
+ *
+ * @return PID on success or -1 as waitpid
+ */
+pid_t WaitProcessAccounting(pid_t pid, int* status, ProcessAccounting& acc,
+                            int options = 0) {
+  struct rusage usage = {};
+  pid_t result;
+  do
+    result = wait4(pid, status, options, &usage);
+  while (result < 0 && errno == EINTR);
+
+  if (result < 0)
+    return result;
+
+  acc.user_us       =
+    (uint64_t)usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec;
+  acc.kernel_us     =
+    (uint64_t)usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
+  acc.processes     = 1;
+
+  // Blocks are 512 bytes and RSS is in kilobytes (bytes on macOS)
+  acc.read_bytes    = (uint64_t)usage.ru_inblock * 512;
+  acc.write_bytes   = (uint64_t)usage.ru_oublock * 512;
+#ifdef __APPLE__
+  acc.peak_memory   = (uint64_t)usage.ru_maxrss;
+#else
+  acc.peak_memory   = (uint64_t)usage.ru_maxrss * 1024;
+#endif
+  return result;
+}
+#endif
+
+
+/**@brief  Accounting as a single JSON line
+ *
+ * @param  SHIM:        name of the shim
+ * @param  EXIT_CODE:   exit code of the child
+ * @param  ACC:         accounting
+ */
+string FormatAccounting(const string& shim, long long exit_code,
+                        const ProcessAccounting& acc) {
+  return
+    "{\"shim\":"       + JsonString(shim) +
+    ",\"exit_code\":"   + to_string(exit_code) +
+    ",\"wall_us\":"     + to_string(acc.wall_us) +
+    ",\"user_us\":"     + to_string(acc.user_us) +
+    ",\"kernel_us\":"   + to_string(acc.kernel_us) +
+    ",\"peak_memory\":" + to_string(acc.peak_memory) +
+    ",\"read_bytes\":"  + to_string(acc.read_bytes) +
+    ",\"write_bytes\":" + to_string(acc.write_bytes) +
+    ",\"processes\":"   + to_string(acc.processes) + "}";
+}
+
+
+// ------------------------------------------------------------------------- //
+#endif  // PROCESS_ACCOUNTING_H
@@ -0,0 +1,585 @@
+// ------------------------------------------------------------------------- //
+// Stdio Relay                                                               //
+// ------------------------------------------------------------------------- //
+/**@file    RELAY.H
+ * @brief   Connects the application's stdin / stdout / stderr to the shim's
+ *          through pipes
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * With --shim-Relay the application is given pipes rather than the shim's
+ * own handles, and the shim pumps between the two until the application
+ * closes its end:
+ *
+ *  shim stdin  --> pump --> pipe --> application stdin
+ *  shim stdout <-- pump <-- pipe <-- application stdout
+ *  shim stderr <-- pump <-- pipe <-- application stderr
+ *
+ * Each direction has its own thread moving RELAY_CHUNK bytes at a time
+ * through pipes of RELAY_PIPE_SIZE, so a slow reader holds up the writer
+ * (backpressure) rather than buffering without end. End of file travels
+ * with the data: once the shim's stdin ends the application's does, and
+ * once the shim's stdout / stderr goes away the application's writes fail
+ * as they would on a broken pipe.
+ *
+ * On Windows the pipes are named so that an elevated application, which
+ * can only be started through ShellExecuteEx and hence cannot inherit
+ * handles, can still be connected: the shim starts an elevated copy of
+ * itself as the relay host (--shim-RelayHost <pipe>), which opens the pipes
+ * and launches the application on them. The pipe side is overlapped, so
+ * the next read (or write) is under way while the last is written out.
+ *
+ * On Linux the pumps splice between the pipes and the shim's handles,
+ * moving pages rather than copying, when those are pipes or files. Others
+ * (a terminal, a socket) are read / written: splicing from or to a socket
+ * holds the pipe's lock while the socket blocks, so the application could
+ * not even exit until the socket had data or room.
+ *
+ * With --shim-Tee the stdout / stderr pumps also queue what they pass on in
+ * a ring buffer each (see RING_BUFFER.H), which a writer thread appends to
+ * the shim's log file. The pumps never wait for the log: when the disk
+ * falls behind and a buffer is full the copy is dropped and counted, and
+ * the count reported in the log once the application has exited.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef RELAY_H
+#define RELAY_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <filesystem>
+#include <condition_variable>
+#include <log.h>
+#include <log_sink.h>
+#include <ring_buffer.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#define RELAY_CHUNK         (256 * 1024)
+#define RELAY_PIPE_SIZE     (1024 * 1024)
+#define TEE_BUFFER_SIZE     (4 * 1024 * 1024)
+
+using namespace std;
+
+
+// ---------------------------------- Tee ---------------------------------- //
+/**@brief  Copies the application's output into the log file
+ *
+ * Each pump is the only producer of its ring buffer and the writer thread
+ * the only consumer of both.
+ */
+class LogTee {
+public:
+  LogTee(const filesystem::path& file) :
+      output(TEE_BUFFER_SIZE), error(TEE_BUFFER_SIZE),
+      sink(TEE_BUFFER_SIZE) {
+    sink.setFile(file);
+    sink.setRotation(LOGCFG.rotate_size, LOGCFG.rotate_files);
+    writer = thread(&LogTee::run, this);
+  }
+
+  ~LogTee() {
+    finish();
+  }
+
+  // Called by the pump of STREAM (1 = stdout, 2 = stderr), never blocks
+  // (other than briefly to wake the writer should it be asleep)
+  void push(int stream, const char* data, size_t size) {
+    (stream == 1 ? output : error).push(data, size);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (sleeping) {
+      lock_guard<mutex> wake(lock);
+      ready.notify_one();
+    }
+  }
+
+  // Write out the rest (once the pumps are done) and report any drops
+  void finish() {
+    if (!writer.joinable())
+      return;
+    {
+      lock_guard<mutex> wake(lock);
+      done = true;
+      ready.notify_one();
+    }
+    writer.join();
+
+    if (uint64_t dropped = output.dropped() + error.dropped())
+      LOG(2) << "Tee dropped " << dropped << " bytes of output from the log";
+  }
+
+private:
+  RingBuffer          output;
+  RingBuffer          error;
+  LogSink             sink;
+  thread              writer;
+  atomic<bool>        done{false};
+  atomic<bool>        sleeping{false};
+  mutex               lock;
+  condition_variable  ready;
+
+  void run() {
+    unique_ptr<char[]> chunk(new char[RELAY_CHUNK]);
+    size_t unflushed = 0;
+
+    for (;;) {
+      bool finishing = done;
+      size_t n = 0;
+      // Append in large writes while busy, and whatever is left when idle
+      for (RingBuffer* ring : {&output, &error})
+        while (size_t got = ring->pop(chunk.get(), RELAY_CHUNK)) {
+          sink.write(chunk.get(), got);
+          n         += got;
+          unflushed += got;
+          if (unflushed >= TEE_BUFFER_SIZE / 2) {
+            sink.flush();
+            unflushed = 0;
+          }
+        }
+
+      if (n == 0 && unflushed > 0) {
+        sink.flush();
+        unflushed = 0;
+      }
+
+      if (n == 0) {
+        if (finishing)
+          break;
+
+        // Sleep unless something was pushed since the rings were emptied
+        unique_lock<mutex> wait(lock);
+        sleeping = true;
+        if (!done && output.size() == 0 && error.size() == 0)
+          ready.wait_for(wait, chrono::milliseconds(100));
+        sleeping = false;
+      }
+    }
+
+    if (uint64_t dropped = output.dropped() + error.dropped())
+      sink.write("[shim] " + to_string(dropped) +
+                 " bytes of output were not logged, the log fell behind\n");
+    sink.flush();
+  }
+};
+
+
+#ifdef _WIN32
+// ------------------------------ Named Pipes ------------------------------ //
+#define RELAY_PIPE_PREFIX   L"\\\\.\\pipe\\shim-relay-"
+
+#ifndef PIPE_REJECT_REMOTE_CLIENTS
+#define PIPE_REJECT_REMOTE_CLIENTS 0x00000008
+#endif
+
+// Pipe I of the relay NAME (0 = stdin, 1 = stdout, 2 = stderr)
+wstring RelayPipeName(const wstring& name, int i) {
+  return name + L"-" + to_wstring(i);
+}
+
+
+// Open the application's end of pipe I, inheritable so it can be given to it
+HANDLE OpenRelayPipe(const wstring& name, int i) {
+  SECURITY_ATTRIBUTES sa = {sizeof(sa), nullptr, TRUE};
+  HANDLE pipe = CreateFileW(
+    RelayPipeName(name, i).c_str(),
+    i == 0 ? GENERIC_READ | FILE_WRITE_ATTRIBUTES : GENERIC_WRITE,
+    0, &sa, OPEN_EXISTING, 0, nullptr);
+  return pipe == INVALID_HANDLE_VALUE ? nullptr : pipe;
+}
+
+
+// Wait for the application's end to be opened, or STOP to be set
+bool ConnectRelayPipe(HANDLE pipe, HANDLE stop) {
+  OVERLAPPED ov = {};
+  ov.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+  // Already opened, or opened and closed again by an application that has
+  // written and exited before the pump got here, its output still buffered
+  DWORD n;
+  bool  connected = ConnectNamedPipe(pipe, &ov);
+  DWORD error     = connected ? ERROR_SUCCESS : GetLastError();
+  connected = connected || error == ERROR_PIPE_CONNECTED ||
+    error == ERROR_NO_DATA;
+  if (!connected && error == ERROR_IO_PENDING) {
+    HANDLE events[2] = {ov.hEvent, stop};
+    if (WaitForMultipleObjects(2, events, FALSE, INFINITE) == WAIT_OBJECT_0)
+      connected = GetOverlappedResult(pipe, &ov, &n, FALSE);
+    else {
+      CancelIo(pipe);
+      GetOverlappedResult(pipe, &ov, &n, TRUE);
+    }
+  }
+
+  CloseHandle(ov.hEvent);
+  return connected;
+}
+
+
+bool WriteAll(HANDLE to, const char* data, DWORD size) {
+  while (size > 0) {
+    DWORD n = 0;
+    if (!WriteFile(to, data, size, &n, nullptr) || n == 0)
+      return false;
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+
+// Shim's stdin --> pipe, reading the next chunk while the last is written
+void PumpToPipe(HANDLE from, HANDLE pipe, HANDLE stop) {
+  if (ConnectRelayPipe(pipe, stop)) {
+    unique_ptr<char[]> buffer[2] = {
+      unique_ptr<char[]>(new char[RELAY_CHUNK]),
+      unique_ptr<char[]>(new char[RELAY_CHUNK])};
+    OVERLAPPED ov = {};
+    ov.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+    DWORD n, written;
+    bool  pending = false;
+    for (int cur = 0; ; cur ^= 1) {
+      if (!ReadFile(from, buffer[cur].get(), RELAY_CHUNK, &n, nullptr) ||
+          n == 0)
+        break;
+      if (pending && !GetOverlappedResult(pipe, &ov, &written, TRUE)) {
+        pending = false;
+        break;
+      }
+      pending = WriteFile(pipe, buffer[cur].get(), n, nullptr, &ov) ||
+        GetLastError() == ERROR_IO_PENDING;
+      if (!pending)
+        break;
+    }
+    if (pending)
+      GetOverlappedResult(pipe, &ov, &written, TRUE);
+
+    // Let the application read what is left before it sees the end
+    FlushFileBuffers(pipe);
+    CloseHandle(ov.hEvent);
+  }
+  CloseHandle(pipe);
+}
+
+
+// Pipe --> shim's stdout / stderr (and the tee as STREAM), the next read
+// overlapping the last write
+void PumpFromPipe(HANDLE pipe, HANDLE to, HANDLE stop, LogTee* tee,
+                  int stream) {
+  if (ConnectRelayPipe(pipe, stop)) {
+    unique_ptr<char[]> buffer[2] = {
+      unique_ptr<char[]>(new char[RELAY_CHUNK]),
+      unique_ptr<char[]>(new char[RELAY_CHUNK])};
+    OVERLAPPED ov = {};
+    ov.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+    auto read = [&](int i) {
+      return ReadFile(pipe, buffer[i].get(), RELAY_CHUNK, nullptr, &ov) ||
+        GetLastError() == ERROR_IO_PENDING;
+    };
+
+    DWORD n;
+    bool  pending = read(0);
+    for (int cur = 0; pending; ) {
+      if (!GetOverlappedResult(pipe, &ov, &n, TRUE) || n == 0)
+        break;                                  // broken pipe, i.e. the end
+      int done = cur;
+      cur ^= 1;
+      pending = read(cur);
+      if (tee)
+        tee->push(stream, buffer[done].get(), n);
+      if (!WriteAll(to, buffer[done].get(), n)) {
+        if (pending) {
+          CancelIo(pipe);
+          GetOverlappedResult(pipe, &ov, &n, TRUE);
+        }
+        break;
+      }
+    }
+    CloseHandle(ov.hEvent);
+  }
+  CloseHandle(pipe);
+}
+
+
+// --------------------------------- Relay --------------------------------- //
+class Relay {
+public:
+  wstring   name;                       // of the pipes (see RelayPipeName)
+  HANDLE    child[3] =      {};         // the application's ends
+
+  ~Relay() {
+    finish();
+    close();
+  }
+
+  /**@brief  Create the pipes
+   *
+   * @param  DIRECT:  also open the application's ends, rather than leaving
+   *                  them for a relay host to open
+   */
+  bool open(bool direct) {
+    close();
+    name = RELAY_PIPE_PREFIX + to_wstring(GetCurrentProcessId()) + L"-" +
+      to_wstring(GetTickCount64());
+
+    for (int i = 0; i < 3; i++) {
+      server[i] = CreateNamedPipeW(
+        RelayPipeName(name, i).c_str(),
+        (i == 0 ? PIPE_ACCESS_OUTBOUND : PIPE_ACCESS_INBOUND) |
+        FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+        PIPE_TYPE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+        1, RELAY_PIPE_SIZE, RELAY_PIPE_SIZE, 0, nullptr);
+      if (server[i] == INVALID_HANDLE_VALUE) {
+        server[i] = nullptr;
+        close();
+        return false;
+      }
+      if (direct && !(child[i] = OpenRelayPipe(name, i))) {
+        close();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Open the application's ends of the relay NAME (in the relay host)
+  bool connect(const wstring& relay_name) {
+    close();
+    name = relay_name;
+    for (int i = 0; i < 3; i++)
+      if (!(child[i] = OpenRelayPipe(name, i))) {
+        close();
+        return false;
+      }
+    return true;
+  }
+
+  // Copy the application's output into FILE as well
+  void teeTo(const filesystem::path& file) {
+    tee = make_unique<LogTee>(file);
+  }
+
+  // Pump once the application has been started with its ends
+  void start() {
+    closeChild();
+    if (!server[0])
+      return;
+
+    stop = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+    // The shim's stdin may never end, hence that pump is not waited for
+    thread(PumpToPipe, GetStdHandle(STD_INPUT_HANDLE), server[0], stop)
+      .detach();
+    output = thread(PumpFromPipe, server[1],
+                    GetStdHandle(STD_OUTPUT_HANDLE), stop, tee.get(), 1);
+    error = thread(PumpFromPipe, server[2],
+                   GetStdHandle(STD_ERROR_HANDLE), stop, tee.get(), 2);
+    server[0] = server[1] = server[2] = nullptr;  // owned by the pumps
+  }
+
+  // Wait for the application's output to be written (once it has exited)
+  void finish() {
+    if (stop)
+      SetEvent(stop);           // pipes never connected, i.e. host failed
+    if (output.joinable())
+      output.join();
+    if (error.joinable())
+      error.join();
+    if (tee)
+      tee->finish();
+  }
+
+private:
+  HANDLE    server[3] =     {};         // the shim's ends
+  HANDLE    stop =          nullptr;
+  thread    output;
+  thread    error;
+  unique_ptr<LogTee> tee;
+
+  void closeChild() {
+    for (auto& h : child) {
+      if (h)
+        CloseHandle(h);
+      h = nullptr;
+    }
+  }
+
+  void close() {
+    closeChild();
+    for (auto& h : server) {
+      if (h)
+        CloseHandle(h);
+      h = nullptr;
+    }
+    if (stop)
+      CloseHandle(stop);
+    stop = nullptr;
+  }
+};
+
+
+#else
+// --------------------------------- Pumps --------------------------------- //
+// Whether splice never blocks on FD holding a pipe's lock, i.e. a pipe or file
+bool Spliceable(int fd) {
+  struct stat st;
+  return fstat(fd, &st) == 0 && (S_ISFIFO(st.st_mode) || S_ISREG(st.st_mode));
+}
+
+
+/**@brief  Copy FROM to TO until either ends, then close OWNED
+ *
+ * Closing the pipe end it owns is what passes the end on: the application
+ * reads end of file on its stdin, or gets EPIPE writing its stdout. With a
+ * TEE the data has to be seen, hence is read rather than spliced.
+ */
+void Pump(int from, int to, int owned, LogTee* tee = nullptr,
+          int stream = 0) {
+  bool splicing = !tee && Spliceable(from) && Spliceable(to);
+  unique_ptr<char[]> buffer;
+
+  for (;;) {
+    ssize_t n = -1;
+#ifdef __linux__
+    if (splicing) {
+      n = splice(from, nullptr, to, nullptr, RELAY_CHUNK,
+                 SPLICE_F_MOVE | SPLICE_F_MORE);
+      if (n < 0 && (errno == EINVAL || errno == ENOSYS)) {
+        splicing = false;
+        continue;
+      }
+    }
+    else
+#endif
+    {
+      if (!buffer)
+        buffer.reset(new char[RELAY_CHUNK]);
+      n = read(from, buffer.get(), RELAY_CHUNK);
+      if (n > 0 && tee)
+        tee->push(stream, buffer.get(), n);
+      for (ssize_t done = 0, w; n > 0 && done < n; done += w) {
+        w = write(to, buffer.get() + done, n - done);
+        if (w < 0 && errno == EINTR)
+          w = 0;
+        else if (w <= 0) {
+          n = -1;
+          break;
+        }
+      }
+    }
+
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      break;
+  }
+  close(owned);
+}
+
+
+// --------------------------------- Relay --------------------------------- //
+class Relay {
+public:
+  int       child[3] =      {-1, -1, -1};   // the application's ends
+
+  ~Relay() {
+    finish();
+    for (int fd : child)
+      if (fd >= 0)
+        close(fd);
+    for (int fd : shim)
+      if (fd >= 0)
+        close(fd);
+  }
+
+  // Create the pipes
+  bool open() {
+    for (int i = 0; i < 3; i++) {
+      int fds[2];
+      if (pipe2(fds, O_CLOEXEC) != 0)
+        return false;
+
+      // stdin is written by the shim, stdout / stderr read
+      child[i]  = i == 0 ? fds[0] : fds[1];
+      shim[i]   = i == 0 ? fds[1] : fds[0];
+#ifdef F_SETPIPE_SZ
+      fcntl(shim[i], F_SETPIPE_SZ, RELAY_PIPE_SIZE);
+#endif
+    }
+    return true;
+  }
+
+  // Copy the application's output into FILE as well
+  void teeTo(const filesystem::path& file) {
+    tee = make_unique<LogTee>(file);
+  }
+
+  // Pump once the application has been started with its ends
+  void start() {
+    for (int& fd : child) {
+      close(fd);
+      fd = -1;
+    }
+
+    // Failed writes are reported as EPIPE rather than killing the shim
+    signal(SIGPIPE, SIG_IGN);
+
+    // The shim's stdin may never end, hence that pump is not waited for
+    thread(Pump, STDIN_FILENO, shim[0], shim[0], nullptr, 0).detach();
+    output  = thread(Pump, shim[1], STDOUT_FILENO, shim[1], tee.get(), 1);
+    error   = thread(Pump, shim[2], STDERR_FILENO, shim[2], tee.get(), 2);
+    shim[0] = shim[1] = shim[2] = -1;       // owned by the pumps
+  }
+
+  // Wait for the application's output to be written (once it has exited)
+  void finish() {
+    if (output.joinable())
+      output.join();
+    if (error.joinable())
+      error.join();
+    if (tee)
+      tee->finish();
+  }
+
+private:
+  int       shim[3] =       {-1, -1, -1};   // the shim's ends
+  thread    output;
+  thread    error;
+  unique_ptr<LogTee> tee;
+};
+#endif
+
+
+// ------------------------------------------------------------------------- //
+#endif  // RELAY_H
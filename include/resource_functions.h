@@ -28,8 +28,9 @@
 // ------------------------------------------------------------------------- //
 #include <string>
 #include <log.h>
+#include <icon_resources.h>
 
-
+#ifdef _WIN32
 // ---------------------------- Read Resources ----------------------------- // 
 bool HasResourceData(LPCSTR name) {
   if (FindResource(NULL, name, RT_RCDATA)) 
@@ -72,36 +73,69 @@ bool GetResourceFile(string name, const filesystem::path& path) {
   // Save the resource to it
 
   DWORD bytes_written   = 0;
-  WriteFile(file, data_ptr, data_size, &bytes_written, NULL);
+  BOOL  written         =
+    WriteFile(file, data_ptr, data_size, &bytes_written, NULL) &&
+    bytes_written == data_size;
   CloseHandle(file);
-  return true;
+  return written;
 }
 
 
 // ----------------------------- Add Resources ----------------------------- // 
-BOOL AddResourceData (filesystem::path target, LPCSTR name, wstring arg) {
-  HANDLE resource   = BeginUpdateResourceW(target.c_str(), FALSE);
-  BOOL bUpdate      = UpdateResource(
-      resource,                 // Handle
-      RT_RCDATA,                // Resource Type
-      name,                     // Resource Name
-      MAKELANGID(LANG_NEUTRAL, SUBLANG_NEUTRAL),
-      (LPVOID)arg.c_str(),      // Resource String
-      arg.size() * sizeof(wchar_t));
-  
-  if (!bUpdate)
-    LOG(1) << "Failed to add resource: " << name;
-  else 
-    LOG(3) << "Added resource: " << name << " = " << arg;
+// Several resources added at once, the file being rewritten only once by
+// COMMIT rather than once per resource
+class ResourceUpdate {
+public:
+  bool begin(const filesystem::path& target) {
+    resource = BeginUpdateResourceW(target.c_str(), FALSE);
+    return resource != nullptr;
+  }
 
-  EndUpdateResource(resource, FALSE);
-  
-  return bUpdate;
+  bool add(LPCSTR name, const wstring& arg) {
+    BOOL bUpdate    = resource && UpdateResource(
+        resource,                 // Handle
+        RT_RCDATA,                // Resource Type
+        name,                     // Resource Name
+        MAKELANGID(LANG_NEUTRAL, SUBLANG_NEUTRAL),
+        (LPVOID)arg.c_str(),      // Resource String
+        arg.size() * sizeof(wchar_t));
+    
+    if (!bUpdate)
+      LOG(1) << "Failed to add resource: " << name;
+    else 
+      LOG(3) << "Added resource: " << name << " = " << arg;
+    return bUpdate;
+  }
+
+  bool commit() {
+    bool written = resource && EndUpdateResource(resource, FALSE);
+    resource = nullptr;
+    return written;
+  }
+
+  ~ResourceUpdate() {
+    if (resource)
+      EndUpdateResource(resource, TRUE);  // discard
+  }
+
+private:
+  HANDLE resource =         nullptr;
+};
+
+BOOL AddResourceData (filesystem::path target, LPCSTR name, wstring arg) {
+  ResourceUpdate update;
+  return update.begin(target) && update.add(name, arg) && update.commit();
 }
 
 
+// Resources are part of the mapped image, there is nothing to give back
+void ReleaseResourceData() {}
+
+
 // ---------------------------- Copy Resources ----------------------------- //
 HANDLE resource_handle;
+vector<IconResource> copied_icons;      // written once pruned, see OPTIMIZEICONS
+bool copy_icons;                        // unless others are given instead
 
 BOOL CALLBACK enumLangsFunc(HMODULE hModule, LPCTSTR lpType, LPCTSTR lpName,
                    WORD wLang, LONG lParam) {
@@ -110,6 +144,20 @@ BOOL CALLBACK enumLangsFunc(HMODULE hModule, LPCTSTR lpType, LPCTSTR lpName,
   HGLOBAL hResLoad =    LoadResource(hModule, hRes);
   LPVOID lpResLock =    LockResource(hResLoad);
 
+  // Icons are only collected here
+  if (lpType == RT_ICON || lpType == RT_GROUP_ICON) {
+    IconResource icon;
+    icon.type = lpType == RT_ICON ? PE_RT_ICON : PE_RT_GROUP_ICON;
+    icon.lang = wLang;
+    if (IS_INTRESOURCE(lpName))
+      icon.id = (USHORT)(ULONG_PTR)lpName;
+    else
+      icon.name = lpName;
+    icon.data.assign((const char*)lpResLock, SizeofResource(hModule, hRes));
+    copied_icons.push_back(icon);
+    return TRUE;
+  }
+
   UpdateResource(resource_handle, lpType, lpName, wLang,
                  lpResLock,                        // ptr to resource info
                  SizeofResource(hModule, hRes));   // size of resource info
@@ -142,13 +190,41 @@ BOOL CALLBACK enumNamesFunc(HMODULE hModule, LPCTSTR lpType, LPTSTR lpName,
 
 BOOL CALLBACK enumTypesFunc(HMODULE hModule, LPTSTR lpType, LONG lParam) {
   // Only Copy Icons and Version Info
-  if(lpType == RT_ICON || lpType == RT_VERSION || lpType == RT_GROUP_ICON)
+  if(lpType == RT_VERSION ||
+     (copy_icons && (lpType == RT_ICON || lpType == RT_GROUP_ICON)))
     EnumResourceNames(hModule, lpType, enumNamesFunc, 0);
   return TRUE;
 }
 
-BOOL CopyResources(filesystem::path target, filesystem::path source) {
+// Write the icons collected by ENUMLANGSFUNC, pruned by POLICY
+void WriteIcons(const IconPolicy& policy) {
+  IconStats stats = OptimizeIcons(copied_icons, policy);
+  for (auto& icon : copied_icons) {
+    LPCSTR name = icon.name.empty() ?
+      MAKEINTRESOURCE(icon.id) : icon.name.c_str();
+    UpdateResource(resource_handle,
+                   icon.type == PE_RT_ICON ? RT_ICON : RT_GROUP_ICON,
+                   name, icon.lang, (LPVOID)icon.data.data(),
+                   icon.data.size());
+  }
+  vector<IconResource>().swap(copied_icons);
+
+  if (stats.images_in)
+    LOG(3) << "Copied " << stats.groups << " ICON GROUP(s) with "
+           << stats.images_out << " of " << stats.images_in << " ICON(s), "
+           << stats.bytes_out << " of " << stats.bytes_in << " bytes";
+  if (stats.over_limit)
+    LOG(2) << "Icons still exceed " << policy.max_bytes
+           << " bytes, every group is down to one image";
+}
+
+// ICONS (e.g. from READICONRESOURCES) replace those of SOURCE if given
+BOOL CopyResources(filesystem::path target, filesystem::path source,
+                   const IconPolicy& policy = IconPolicy(),
+                   const vector<IconResource>& icons = {}) {
   resource_handle = BeginUpdateResourceW(target.c_str(), FALSE);
+  copied_icons    = icons;
+  copy_icons      = icons.empty();
   
   HMODULE hExe =
     LoadLibraryExW(source.c_str(), NULL, LOAD_LIBRARY_AS_DATAFILE);
@@ -159,6 +235,7 @@ BOOL CopyResources(filesystem::path target, filesystem::path source) {
   }
 
   EnumResourceTypes(hExe, enumTypesFunc, 0);
+  WriteIcons(policy);
 
   EndUpdateResource(resource_handle, FALSE);
   
@@ -171,5 +248,192 @@ BOOL CopyResources(filesystem::path target, filesystem::path source) {
 }  
 
 
+#else
+// ------------------------ Read Resources (POSIX) ------------------------- //
+// Without PE resources the configuration is NAME = VALUE text, one per line,
+// where NAME is the resource name less "SHIM_" (e.g. SHIM_PATH --> path):
+//
+//     path = /opt/app/bin/app
+//     args = --some-flag "quoted argument"
+//     type = CONSOLE
+//
+// A NAME given on several lines has a multi-line VALUE, one line each (e.g.
+// the env overrides of SHIM_ENV).
+//
+// The generator patches it into the shim's own SHIM_CONFIG_SECTION (see
+// ELF_CONFIG.H), past which a long one continues at the end of the file.
+// An unpatched shim falls back to a Scoop style file next to it,
+// <shim path>.shim.
+//
+#include <map>
+#include <set>
+#include <fstream>
+#include <sstream>
+#include <elf_config.h>
+#include <utility_functions.h>
+
+// Read through volatile, the compiler must not assume it is still unpatched
+__attribute__((section(SHIM_CONFIG_SECTION), used))
+volatile ShimConfigBlock SHIM_CONFIG = {SHIM_CONFIG_MAGIC, 0, {}};
+
+
+map<string, wstring> ParseResourceText(const string& text) {
+  map<string, wstring> resources;
+  set<string>          seen;
+  istringstream lines(text);
+  string line;
+  while (getline(lines, line)) {
+    size_t eq = line.find('=');
+    if (eq == string::npos)
+      continue;
+
+    auto trim = [](string s) {
+      s.erase(0, s.find_first_not_of(" \t\r"));
+      s.erase(s.find_last_not_of(" \t\r") + 1);
+      return s;
+    };
+    
+    string key = trim(line.substr(0, eq));
+    transform(key.begin(), key.end(), key.begin(), ::tolower);
+    wstring& value = resources[key];
+    if (!seen.insert(key).second)               // a line of several
+      value += L"\n";
+    value += WidenString(trim(line.substr(eq + 1)));
+  }
+  return resources;
+}
+
+string FormatResourceText(const map<string, wstring>& resources) {
+  string text;
+  for (auto& [key, value] : resources) {
+    // A line each, even an empty one (which getline would drop at the end)
+    string lines = NarrowString(value);
+    for (size_t at = 0, end = 0; end != string::npos; at = end + 1) {
+      end = lines.find('\n', at);
+      text += key + " = " + lines.substr(at, end - at) + "\n";
+    }
+  }
+  return text;
+}
+
+map<string, wstring>& ShimResources() {
+  static map<string, wstring> resources;
+  static bool loaded = false;
+  if (loaded)
+    return resources;
+  loaded = true;
+
+  uint32_t size = SHIM_CONFIG.size;
+  if (size > SHIM_CONFIG_CAPACITY) {
+    // The rest is at the end of the shim's file, read along with the block
+    string text;
+    if (ReadElfConfig(GetExecPath(), text))
+      resources = ParseResourceText(text);
+  }
+  else if (size > 0) {
+    string text(size, '\0');
+    for (uint32_t i = 0; i < size; i++)
+      text[i] = SHIM_CONFIG.data[i];
+    resources = ParseResourceText(text);
+  }
+  else {
+    ifstream file(GetExecPath().string() + ".shim");
+    resources = ParseResourceText(
+        string(istreambuf_iterator<char>(file), istreambuf_iterator<char>()));
+  }
+  return resources;
+}
+
+// The configuration is only needed until the application is launched
+void ReleaseResourceData() {
+  Release(ShimResources());
+}
+
+string ResourceKey(const char* name) {
+  string key = name;
+  if (key.rfind("SHIM_", 0) == 0)
+    key.erase(0, 5);
+  transform(key.begin(), key.end(), key.begin(), ::tolower);
+  return key;
+}
+
+bool HasResourceData(const char* name) {
+  return ShimResources().count(ResourceKey(name)) > 0;
+}
+
+bool GetResourceData(const char* name, wstring& arg) {
+  auto& resources = ShimResources();
+  auto  found     = resources.find(ResourceKey(name));
+  if (found == resources.end())
+    return false;
+  arg = found->second;
+  return true;
+}
+
+
+// ------------------------- Add Resources (POSIX) ------------------------- //
+// Several resources added at once, the configuration being read and written
+// only once: patched into TARGET, or into a copy of IMAGE written out whole
+class ResourceUpdate {
+public:
+  bool begin(const filesystem::path& target) {
+    string text;
+    path  = target;
+    ready = ReadElfConfig(target, text);
+    resources = ParseResourceText(text);
+    return ready;
+  }
+
+  bool begin(iostream& shim, function<bool(const char*, size_t)> write) {
+    string text;
+    image = &shim;
+    copy  = move(write);
+    ready = ReadElfConfig(shim, text);
+    resources = ParseResourceText(text);
+    return ready;
+  }
+
+  bool add(const char* name, const wstring& arg) {
+    if (!ready) {
+      LOG(1) << "Failed to add resource: " << name;
+      return false;
+    }
+    resources[ResourceKey(name)] = arg;
+    LOG(3) << "Added resource: " << name << " = " << arg;
+    return true;
+  }
+
+  bool commit() {
+    string text = FormatResourceText(resources);
+    bool written = false;
+    if (ready && text.size() > SHIM_CONFIG_MAX)
+      LOG(1) << "The configuration is " << text.size() << " bytes, over "
+             << "the " << SHIM_CONFIG_MAX << " a shim holds";
+    else if (ready)
+      written = image ? CopyElfShim(*image, text, copy) :
+        WriteElfConfig(path, text);
+    if (!written && image)
+      LOG(1) << "Failed to write the shim with its resources";
+    else if (!written)
+      LOG(1) << "Failed to write resources to " << path;
+    ready = false;
+    return written;
+  }
+
+private:
+  filesystem::path      path;
+  iostream*             image =     nullptr;
+  function<bool(const char*, size_t)> copy;
+  map<string, wstring>  resources;
+  bool                  ready =     false;
+};
+
+bool AddResourceData(filesystem::path target, const char* name, wstring arg) {
+  ResourceUpdate update;
+  return update.begin(target) && update.add(name, arg) && update.commit();
+}
+#endif
+
+
 // ------------------------------------------------------------------------- //
 #endif  /* RESOURCE_FUNCTIONS_H */
@@ -0,0 +1,247 @@
+// ------------------------------------------------------------------------- //
+// Response Files                                                            //
+// ------------------------------------------------------------------------- //
+/**@file    RESPONSE_FILE.H
+ * @brief   Arguments passed in a file (@FILE) rather than on a command line
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * A command line is at most RESPONSE_COMMAND_LIMIT characters on Windows,
+ * the embedded arguments included, past which CreateProcess fails outright.
+ * Compilers, linkers and the like read their arguments from @FILE instead:
+ *
+ *  ResponseFile
+ *      writes the tail of a shim's arguments, as they would have been on the
+ *      command line, to a temporary file in UTF-8 for an application created
+ *      with --response-file (see RESOLVELAUNCH). Converted a chunk at a time
+ *      straight from the arguments, and removed once the application has
+ *      exited unless the shim did not wait for it.
+ *
+ *  ResponseDecoder / ReadResponseFile
+ *      reads the generator's --command @FILE, UTF-8 with its lines joined by
+ *      spaces, a block at a time. Only a character cut off at the end of a
+ *      block (3 bytes at most) is held back, so it reads the same whichever
+ *      way the file is split (see fuzz/response.cpp).
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef RESPONSE_FILE_H
+#define RESPONSE_FILE_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <cstdlib>
+#include <unistd.h>
+#endif
+
+#include <utility_functions.h>
+
+using namespace std;
+
+#define RESPONSE_COMMAND_LIMIT  32767   // characters, CreateProcess' limit
+#define RESPONSE_PATH_ROOM      300     // for " @<temporary file>"
+#define RESPONSE_WRITE_CHUNK    16384   // characters converted at a time
+#define RESPONSE_READ_SIZE      65536   // bytes read at a time
+
+
+// -------------------------------- Writing -------------------------------- //
+class ResponseFile {
+public:
+  /**@brief  Write ARGS from FROM on to a new temporary file
+   *
+   * @return FALSE if it could not be written (nothing is left behind)
+   */
+  bool write(const wstring& args, size_t from) {
+    remove();
+#ifdef _WIN32
+    wchar_t dir[MAX_PATH + 1], name[MAX_PATH + 1];
+    if (!GetTempPathW(MAX_PATH + 1, dir) ||
+        !GetTempFileNameW(dir, L"shm", 0, name))
+      return false;
+    file = name;
+    HANDLE handle = CreateFileW(name, GENERIC_WRITE, 0, nullptr,
+                                TRUNCATE_EXISTING, FILE_ATTRIBUTE_TEMPORARY,
+                                nullptr);
+    bool written = handle != INVALID_HANDLE_VALUE;
+#else
+    error_code ec;
+    string name = (filesystem::temp_directory_path(ec) /
+                   "shim-XXXXXX.rsp").string();
+    int handle = mkstemps(&name[0], 4);
+    if (handle < 0)
+      return false;
+    file = name;
+    bool written = true;
+#endif
+
+    for (size_t at = from; written && at < args.size(); ) {
+      size_t n = min<size_t>(RESPONSE_WRITE_CHUNK, args.size() - at);
+      // Not between the halves of a surrogate pair (UTF-16)
+      if (at + n < args.size() && args[at + n - 1] >= 0xD800 &&
+          args[at + n - 1] <= 0xDBFF)
+        n--;
+      string bytes = NarrowString(args.substr(at, n));
+      at += n;
+#ifdef _WIN32
+      DWORD done = 0;
+      written = WriteFile(handle, bytes.data(), (DWORD)bytes.size(), &done,
+                          nullptr) && done == bytes.size();
+#else
+      written = ::write(handle, bytes.data(), bytes.size()) ==
+        (ssize_t)bytes.size();
+#endif
+    }
+
+#ifdef _WIN32
+    if (handle != INVALID_HANDLE_VALUE)
+      written = CloseHandle(handle) && written;
+#else
+    written = ::close(handle) == 0 && written;
+#endif
+    if (!written)
+      remove();
+    return written;
+  }
+
+  const filesystem::path& path() const {
+    return file;
+  }
+
+  // Leave it for an application still running when the shim exits
+  void keep() {
+    file.clear();
+  }
+
+  void remove() {
+    error_code ec;
+    if (!file.empty())
+      filesystem::remove(file, ec);
+    file.clear();
+  }
+
+  ~ResponseFile() {
+    remove();
+  }
+
+private:
+  filesystem::path  file;
+};
+
+
+// -------------------------------- Reading -------------------------------- //
+class ResponseDecoder {
+public:
+  // Decode BYTES onto ARGS, holding back a character cut off at the end
+  void feed(const char* bytes, size_t size, wstring& args) {
+    string text = move(pending);
+    text.append(bytes, size);
+    for (char& c : text)
+      if (c == '\r' || c == '\n')
+        c = ' ';
+
+    // A lead byte in the last three whose character is not complete
+    size_t cut = text.size();
+    for (size_t back = 1; back <= 3 && back <= text.size(); back++) {
+      unsigned char b = text[text.size() - back];
+      if ((b & 0xC0) == 0x80)
+        continue;
+      size_t len = b >= 0xF0 && b < 0xF5 ? 4 : b >= 0xE0 ? 3 : b >= 0xC2 ? 2 :
+        1;
+      if (len > back && b < 0xF5)
+        cut = text.size() - back;
+      break;
+    }
+    pending = text.substr(cut);
+    text.resize(cut);
+    append(text, args);
+  }
+
+  // The end of the file, after which ARGS is complete
+  void finish(wstring& args) {
+    append(pending, args);
+    pending.clear();
+    args.erase(args.find_last_not_of(L" \t") + 1);
+  }
+
+private:
+  string    pending;                    // a character cut off
+  bool      started =       false;
+
+  void append(const string& text, wstring& args) {
+    if (text.empty())
+      return;
+    wstring wide = WidenString(text);
+    // Less a byte order mark
+    args.append(wide, !started && wide[0] == 0xFEFF ? 1 : 0, wstring::npos);
+    started = true;
+  }
+};
+
+
+/**@brief  Read the arguments held in FILE
+ *
+ * @param  FILE:    UTF-8 (with or without a byte order mark), any lines
+ *                  joined by spaces
+ * @param  ARGS:    its arguments, as they would be on a command line
+ *
+ * @return FALSE if it could not be read
+ */
+bool ReadResponseFile(const filesystem::path& file, wstring& args) {
+  ResponseDecoder decoder;
+  vector<char>    buffer(RESPONSE_READ_SIZE);
+  args.clear();
+
+#ifdef _WIN32
+  HANDLE handle = CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (handle == INVALID_HANDLE_VALUE)
+    return false;
+  DWORD n = 0;
+  bool  read;
+  while ((read = ReadFile(handle, buffer.data(), (DWORD)buffer.size(), &n,
+                          nullptr)) && n > 0)
+    decoder.feed(buffer.data(), n, args);
+  CloseHandle(handle);
+#else
+  int handle = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+  if (handle < 0)
+    return false;
+  ssize_t n;
+  while ((n = ::read(handle, buffer.data(), buffer.size())) > 0)
+    decoder.feed(buffer.data(), n, args);
+  bool read = n == 0;
+  ::close(handle);
+#endif
+
+  decoder.finish(args);
+  return read;
+}
+
+
+// ------------------------------------------------------------------------- //
+#endif  // RESPONSE_FILE_H
@@ -0,0 +1,112 @@
+// ------------------------------------------------------------------------- //
+// Ring Buffer                                                               //
+// ------------------------------------------------------------------------- //
+/**@file    RING_BUFFER.H
+ * @brief   Lock-free single producer, single consumer byte queue
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * One thread pushes, another pops, and neither ever waits on the other: the
+ * producer only advances HEAD and the consumer only TAIL, each published
+ * with release / acquire ordering so the bytes between them are visible
+ * before the position is. Both count up without wrapping (the index into
+ * the buffer is the count masked by its power of two size).
+ *
+ * A push that does not fit is dropped whole and counted rather than waiting
+ * for room, so the producer's speed never depends on the consumer's.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+// ------------------------------------------------------------------------- //
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+
+// ------------------------------------------------------------------------- //
+class RingBuffer {
+public:
+  // CAPACITY is rounded up to a power of two, and left uninitialized so
+  // pages are only committed as the producer first reaches them
+  RingBuffer(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity)
+      size <<= 1;
+    buffer.reset(new char[size]);
+    mask = size - 1;
+  }
+
+  // Producer: queue all of DATA, or drop all of it if there is no room
+  bool push(const char* data, size_t size) {
+    size_t h = head.load(memory_order_relaxed);
+    size_t t = tail.load(memory_order_acquire);
+    if (mask + 1 - (h - t) < size) {
+      drops.fetch_add(size, memory_order_relaxed);
+      return false;
+    }
+
+    size_t at    = h & mask;
+    size_t first = min(size, mask + 1 - at);
+    memcpy(&buffer[at], data, first);
+    memcpy(&buffer[0], data + first, size - first);
+    head.store(h + size, memory_order_release);
+    return true;
+  }
+
+  // Consumer: dequeue up to SIZE bytes into DATA, returning how many
+  size_t pop(char* data, size_t size) {
+    size_t t = tail.load(memory_order_relaxed);
+    size_t h = head.load(memory_order_acquire);
+    size = min(size, h - t);
+
+    size_t at    = t & mask;
+    size_t first = min(size, mask + 1 - at);
+    memcpy(data, &buffer[at], first);
+    memcpy(data + first, &buffer[0], size - first);
+    tail.store(t + size, memory_order_release);
+    return size;
+  }
+
+  // Bytes pushed but not yet popped
+  size_t size() const {
+    return head.load(memory_order_acquire) - tail.load(memory_order_acquire);
+  }
+
+  // Bytes dropped for want of room
+  uint64_t dropped() const {
+    return drops.load(memory_order_relaxed);
+  }
+
+private:
+  unique_ptr<char[]>          buffer;
+  size_t                      mask;
+  alignas(64) atomic<size_t>  head{0};    // written by the producer only
+  alignas(64) atomic<size_t>  tail{0};    // written by the consumer only
+  atomic<uint64_t>            drops{0};
+};
+
+
+// ------------------------------------------------------------------------- //
+#endif  // RING_BUFFER_H
@@ -0,0 +1,340 @@
+// ------------------------------------------------------------------------- //
+// Scheduling Policy                                                         //
+// ------------------------------------------------------------------------- //
+/**@file    SCHEDULE.H
+ * @brief   CPU affinity, priority and memory / CPU caps for the application
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * The generator embeds the policy (--affinity, --priority, --memory-limit,
+ * --cpu-rate) as SHIM_SCHED, one setting per line:
+ *
+ *     affinity 0-3,6                   CPUs the application may run on
+ *     priority below                   idle, below, normal, above or high
+ *     memory 536870912                 bytes it may commit
+ *     cpu 50                           percent of the machine it may use
+ *
+ *  ParseSchedPolicy / FormatSchedPolicy
+ *      reads / writes SHIM_SCHED
+ *
+ *  SetSchedSetting
+ *      checks and sets one setting as the generator is given it
+ *
+ *  ApplySchedPolicy / ApplySchedLimits / ReportSchedPolicy
+ *      Windows: the priority class goes in the process creation flags, the
+ *      affinity is set while the process is still suspended, and the caps
+ *      are limits of its job (covering the whole process tree).
+ *      POSIX: the application's process applies the policy to itself
+ *      between fork and exec, leaving the shim's own untouched (an
+ *      unprivileged shim could not raise its priority back), or the shim
+ *      does just before it execs the application in its place. There is no
+ *      CPU rate cap without cgroups, so it is ignored (the generator warns
+ *      of it).
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <sstream>
+#include <cstdint>
+#include <cwchar>
+#include <cwctype>
+#include <algorithm>
+#include <log.h>
+#include <utility_functions.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+
+// -------------------------------- Policy --------------------------------- //
+enum SchedPriority {
+  PRIORITY_INHERIT,                     // whatever the shim has
+  PRIORITY_IDLE,
+  PRIORITY_BELOW,
+  PRIORITY_NORMAL,
+  PRIORITY_ABOVE,
+  PRIORITY_HIGH
+};
+
+const wchar_t* SCHED_PRIORITY_NAMES[] = {
+  L"inherit", L"idle", L"below", L"normal", L"above", L"high"
+};
+
+struct SchedPolicy {
+  uint64_t      affinity =      0;      // CPU N is bit N, 0 for any
+  SchedPriority priority =      PRIORITY_INHERIT;
+  uint64_t      memory_limit =  0;      // bytes, 0 for none
+  unsigned      cpu_rate =      0;      // percent, 0 for none
+
+  bool empty() const {
+    return !affinity && priority == PRIORITY_INHERIT && !memory_limit &&
+      !cpu_rate;
+  }
+};
+
+
+// Parses a CPU list (e.g. 0-3,6) into a mask, 0 if invalid
+uint64_t ParseCpuList(const wstring& list) {
+  uint64_t       mask = 0;
+  wistringstream items(list);
+  wstring        item;
+  while (getline(items, item, L',')) {
+    wchar_t*      end;
+    unsigned long first = wcstoul(item.c_str(), &end, 10), last = first;
+    if (end == item.c_str())
+      return 0;
+    if (*end == L'-')
+      last = wcstoul(end + 1, &end, 10);
+    if (*end || last < first || last > 63)
+      return 0;
+    for (unsigned long cpu = first; cpu <= last; cpu++)
+      mask |= uint64_t(1) << cpu;
+  }
+  return mask;
+}
+
+// Formats a mask as a CPU list, e.g. 0-3,6
+wstring FormatCpuList(uint64_t mask) {
+  wstring list;
+  for (int cpu = 0; cpu < 64; cpu++) {
+    if (!(mask >> cpu & 1))
+      continue;
+    int last = cpu;
+    while (last < 63 && mask >> (last + 1) & 1)
+      last++;
+    if (!list.empty())
+      list += L",";
+    list += to_wstring(cpu);
+    if (last > cpu)
+      list += L"-" + to_wstring(last);
+    cpu = last;
+  }
+  return list;
+}
+
+/**@brief  Check and set one setting of the policy
+ *
+ * @param  KEY:     affinity, priority, memory or cpu
+ * @param  VALUE:   CPU list, priority name, size (e.g. 512M) or percent
+ *
+ * @return FALSE if either is not understood (the policy is left as is)
+ */
+bool SetSchedSetting(SchedPolicy& policy, const wstring& key,
+                     const wstring& value) {
+  if (key == L"affinity") {
+    uint64_t mask = ParseCpuList(value);
+    if (!mask)
+      return false;
+    policy.affinity = mask;
+    return true;
+  }
+  if (key == L"priority") {
+    wstring name = value;
+    transform(name.begin(), name.end(), name.begin(), ::towlower);
+    for (int p = PRIORITY_IDLE; p <= PRIORITY_HIGH; p++)
+      if (name == SCHED_PRIORITY_NAMES[p]) {
+        policy.priority = (SchedPriority)p;
+        return true;
+      }
+    return false;
+  }
+  if (key == L"memory") {
+    uint64_t bytes = ParseSize(value);
+    if (!bytes)
+      return false;
+    policy.memory_limit = bytes;
+    return true;
+  }
+  if (key == L"cpu") {
+    wchar_t* end;
+    unsigned long rate = wcstoul(value.c_str(), &end, 10);
+    if (*end == L'%')
+      end++;
+    if (end == value.c_str() || *end || rate < 1 || rate > 100)
+      return false;
+    policy.cpu_rate = rate;
+    return true;
+  }
+  return false;
+}
+
+
+/**@brief  Read SHIM_SCHED, skipping any line that is not understood
+ */
+SchedPolicy ParseSchedPolicy(const wstring& text) {
+  SchedPolicy    policy;
+  wistringstream lines(text);
+  wstring        line;
+  while (getline(lines, line)) {
+    size_t space = line.find(L' ');
+    if (space != wstring::npos)
+      SetSchedSetting(policy, line.substr(0, space), line.substr(space + 1));
+  }
+  return policy;
+}
+
+/**@brief  Write SHIM_SCHED (empty if there is no policy)
+ */
+wstring FormatSchedPolicy(const SchedPolicy& policy) {
+  wstring text;
+  auto add = [&](const wchar_t* key, const wstring& value) {
+    text += (text.empty() ? L"" : L"\n") + wstring(key) + L" " + value;
+  };
+  if (policy.affinity)
+    add(L"affinity", FormatCpuList(policy.affinity));
+  if (policy.priority != PRIORITY_INHERIT)
+    add(L"priority", SCHED_PRIORITY_NAMES[policy.priority]);
+  if (policy.memory_limit)
+    add(L"memory", to_wstring(policy.memory_limit));
+  if (policy.cpu_rate)
+    add(L"cpu", to_wstring(policy.cpu_rate));
+  return text;
+}
+
+
+#ifdef _WIN32
+// -------------------------------- Win32 ---------------------------------- //
+// Creation flag of the priority class (0 to inherit)
+DWORD SchedPriorityClass(const SchedPolicy& policy) {
+  switch (policy.priority) {
+  case PRIORITY_IDLE:     return IDLE_PRIORITY_CLASS;
+  case PRIORITY_BELOW:    return BELOW_NORMAL_PRIORITY_CLASS;
+  case PRIORITY_NORMAL:   return NORMAL_PRIORITY_CLASS;
+  case PRIORITY_ABOVE:    return ABOVE_NORMAL_PRIORITY_CLASS;
+  case PRIORITY_HIGH:     return HIGH_PRIORITY_CLASS;
+  default:                return 0;
+  }
+}
+
+/**@brief  Apply the policy to a process (before it is resumed)
+ *
+ * For processes not created with the priority flag, e.g. elevated ones
+ *
+ * @return FALSE if any of it could not be
+ */
+bool ApplySchedPolicy(HANDLE process, const SchedPolicy& policy,
+                      bool priority = true) {
+  bool applied = true;
+  if (priority && SchedPriorityClass(policy))
+    applied = SetPriorityClass(process, SchedPriorityClass(policy)) && applied;
+  if (policy.affinity)
+    applied = SetProcessAffinityMask(process, (DWORD_PTR)policy.affinity) &&
+      applied;
+  return applied;
+}
+
+/**@brief  Apply the caps of the policy to a job
+ *
+ * @param  LIMITS:  the job's limits, to which the memory cap is added (they
+ *                  are set by the caller)
+ */
+void ApplySchedLimits(HANDLE job, const SchedPolicy& policy,
+                      JOBOBJECT_EXTENDED_LIMIT_INFORMATION& limits) {
+  if (policy.memory_limit) {
+    limits.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_JOB_MEMORY;
+    limits.JobMemoryLimit = (SIZE_T)policy.memory_limit;
+  }
+
+  if (policy.cpu_rate) {
+    JOBOBJECT_CPU_RATE_CONTROL_INFORMATION rate = {};
+    rate.ControlFlags = JOB_OBJECT_CPU_RATE_CONTROL_ENABLE |
+      JOB_OBJECT_CPU_RATE_CONTROL_HARD_CAP;
+    rate.CpuRate      = policy.cpu_rate * 100;     // in 1/100ths of a percent
+    if (!SetInformationJobObject(job, JobObjectCpuRateControlInformation,
+                                 &rate, sizeof(rate)))
+      LOG(2) << "Could not cap the application's CPU rate";
+  }
+}
+
+
+#else
+// -------------------------------- POSIX ---------------------------------- //
+// What APPLYSCHEDPOLICY could not apply
+enum SchedFailure {
+  SCHED_AFFINITY_FAILED =  1,
+  SCHED_PRIORITY_FAILED =  2,
+  SCHED_MEMORY_FAILED =    4
+};
+
+/**@brief  Apply the policy to the calling process
+ *
+ * Called in the application's process between fork and exec, so it only
+ * makes system calls (no allocation, locking or logging), or by the shim
+ * about to exec the application in its place.
+ *
+ * @return the SCHED_*_FAILED of what could not be applied, 0 if all was
+ */
+int ApplySchedPolicy(const SchedPolicy& policy) {
+  int failed = 0;
+
+  if (policy.affinity) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu = 0; cpu < 64; cpu++)
+      if (policy.affinity >> cpu & 1)
+        CPU_SET(cpu, &cpus);
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0)
+      failed |= SCHED_AFFINITY_FAILED;
+  }
+
+  static const int NICE[] = {0, 19, 10, 0, -5, -10};
+  if (policy.priority != PRIORITY_INHERIT &&
+      setpriority(PRIO_PROCESS, 0, NICE[policy.priority]) != 0)
+    failed |= SCHED_PRIORITY_FAILED;
+
+  if (policy.memory_limit) {
+    rlimit limit;
+    if (getrlimit(RLIMIT_AS, &limit) == 0) {
+      limit.rlim_cur = min<uint64_t>(policy.memory_limit, limit.rlim_max);
+      if (setrlimit(RLIMIT_AS, &limit) != 0)
+        failed |= SCHED_MEMORY_FAILED;
+    }
+    else
+      failed |= SCHED_MEMORY_FAILED;
+  }
+
+  return failed;
+}
+
+// Warn of what APPLYSCHEDPOLICY could not apply (FAILED)
+void ReportSchedPolicy(const SchedPolicy& policy, int failed) {
+  if (failed & SCHED_AFFINITY_FAILED)
+    LOG(2) << "Could not set the application's CPU affinity";
+  if (failed & SCHED_PRIORITY_FAILED)
+    LOG(2) << "Could not set the application's priority";
+  if (failed & SCHED_MEMORY_FAILED)
+    LOG(2) << "Could not cap the application's memory";
+  if (policy.cpu_rate)
+    LOG(3) << "CPU rate caps are not supported on this platform";
+}
+#endif
+
+
+// ------------------------------------------------------------------------- //
+#endif  // SCHEDULE_H
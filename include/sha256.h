@@ -0,0 +1,205 @@
+// ------------------------------------------------------------------------- //
+// SHA-256                                                                   //
+// ------------------------------------------------------------------------- //
+/**@file    SHA256.H
+ * @brief   Streaming SHA-256 (FIPS 180-4) of memory and of files
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Plain C++, so the digest is the same on every platform (and matches
+ * certutil -hashfile FILE SHA256 or sha256sum FILE):
+ *
+ *  Sha256
+ *      fed with UPDATE as bytes are produced, in pieces of any size, then
+ *      FINISH gives the digest in lowercase hex
+ *
+ *  HashFile
+ *      the digest and size of a file, read sequentially in HASH_READ_SIZE
+ *      pieces
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef SHA256_H
+#define SHA256_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#define HASH_READ_SIZE      (1 << 20)
+
+
+// -------------------------------- Digest --------------------------------- //
+class Sha256 {
+public:
+  void update(const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    length += size;
+
+    // Top up a partial block first, then whole blocks straight from DATA
+    if (used > 0) {
+      size_t n = min(size, sizeof(block) - used);
+      memcpy(block + used, bytes, n);
+      used += n, bytes += n, size -= n;
+      if (used < sizeof(block))
+        return;
+      compress(block);
+      used = 0;
+    }
+    for (; size >= sizeof(block); bytes += sizeof(block), size -= sizeof(block))
+      compress(bytes);
+    memcpy(block, bytes, size);
+    used = size;
+  }
+
+  void update(const string& data) {
+    update(data.data(), data.size());
+  }
+
+  // The digest in lowercase hex, after which the object starts over
+  string finish() {
+    uint64_t bits = length * 8;
+    uint8_t  pad[72] = {0x80};
+    size_t   n = (used < 56 ? 56 : 120) - used;
+    for (int i = 0; i < 8; i++)
+      pad[n + i] = (uint8_t)(bits >> (56 - 8 * i));
+    update(pad, n + 8);
+
+    static const char hex[] = "0123456789abcdef";
+    string digest;
+    for (uint32_t word : state)
+      for (int shift = 28; shift >= 0; shift -= 4)
+        digest += hex[(word >> shift) & 0xF];
+    *this = Sha256();
+    return digest;
+  }
+
+private:
+  uint32_t  state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  uint8_t   block[64];
+  size_t    used =      0;
+  uint64_t  length =    0;
+
+  static uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+  }
+
+  void compress(const uint8_t* data) {
+    static const uint32_t k[64] = {
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+      0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+      0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+      0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+      0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+      0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+      0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+      0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+      0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+      0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+      0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++)
+      w[i] = (uint32_t)data[4 * i] << 24 | (uint32_t)data[4 * i + 1] << 16 |
+             (uint32_t)data[4 * i + 2] << 8 | data[4 * i + 3];
+    for (int i = 16; i < 64; i++) {
+      uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ w[i - 15] >> 3;
+      uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ w[i - 2] >> 10;
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+             e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+      uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) +
+                    ((e & f) ^ (~e & g)) + k[i] + w[i];
+      uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) +
+                    ((a & b) ^ (a & c) ^ (b & c));
+      h = g, g = f, f = e, e = d + t1;
+      d = c, c = b, b = a, a = t1 + t2;
+    }
+    state[0] += a, state[1] += b, state[2] += c, state[3] += d;
+    state[4] += e, state[5] += f, state[6] += g, state[7] += h;
+  }
+};
+
+
+// --------------------------------- Files --------------------------------- //
+/**@brief  Hash a file
+ *
+ * @param  PATH:    file
+ * @param  DIGEST:  its SHA-256, in lowercase hex
+ * @param  SIZE:    its size in bytes
+ *
+ * @return FALSE if it could not be read
+ */
+bool HashFile(const filesystem::path& path, string& digest, uint64_t& size) {
+  Sha256          hash;
+  vector<uint8_t> buffer(HASH_READ_SIZE);
+  size = 0;
+
+#ifdef _WIN32
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  DWORD n = 0;
+  bool  read;
+  while ((read = ReadFile(file, buffer.data(), buffer.size(), &n, nullptr)) &&
+         n > 0) {
+    hash.update(buffer.data(), n);
+    size += n;
+  }
+  CloseHandle(file);
+#else
+  int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file < 0)
+    return false;
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(file, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+  ssize_t n;
+  while ((n = ::read(file, buffer.data(), buffer.size())) > 0) {
+    hash.update(buffer.data(), n);
+    size += n;
+  }
+  bool read = n == 0;
+  ::close(file);
+#endif
+
+  digest = hash.finish();
+  return read;
+}
+
+
+// ------------------------------------------------------------------------- //
+#endif  // SHA256_H
@@ -0,0 +1,251 @@
+// ------------------------------------------------------------------------- //
+// Shim Core                                                                 //
+// ------------------------------------------------------------------------- //
+/**@file    SHIM_CORE.H
+ * @brief   Platform independent decisions made by the shim
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Everything the shim decides before handing over to the platform launcher
+ * (see LAUNCHER.H) lives here so it can be exercised without Win32:
+ *
+ *  ParseShimOptions
+ *      strips the --shim-* arguments from the command line
+ *
+ *  LoadShimConfig / ValidateShimConfig
+ *      reads the embedded configuration (target path, arguments, type,
+ *      environment overrides, scheduling policy and whether it reads
+ *      response files) and checks it still points at something sensible
+ *
+ *  ResolveLaunch
+ *      combines the two into a LaunchPlan: what to run, with which
+ *      arguments (and which of them go in a response file), from which
+ *      directory, and whether to wait for it
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef SHIM_CORE_H
+#define SHIM_CORE_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <system_error>
+#include <trace.h>
+#include <resource_functions.h>
+#include <get_argument.h>
+#include <environment.h>
+#include <schedule.h>
+#include <response_file.h>
+
+#define SHIM_ARG_PREFIX L"--shim"
+
+using namespace std;
+
+
+// ---------------------------- Shim Arguments ----------------------------- //
+bool GetShimArg(vector<wstring> &args, wstring pattern) {
+  wstring argFormat = SHIM_ARG_PREFIX;
+  argFormat += L"[a-z]*-";
+  argFormat += pattern;
+  argFormat += L"[a-z]*";
+  return GetArgument(args, argFormat);
+}
+
+
+struct ShimOptions {
+  bool      log =           false;
+  bool      wait =          false;
+  bool      exit =          false;
+  bool      gui =           false;
+  bool      use_target =    false;
+  bool      noop =          false;
+  bool      trace =         false;
+  bool      profile =       false;
+  bool      relay =         false;      // stdio through pipes (see RELAY.H)
+  bool      tee =           false;      // ... copying its output to the log
+  wstring   relay_host;                 // pipes to relay for another shim
+  bool      help =          false;      // unknown --shim argument
+  wstring   calling_args;               // everything else
+};
+
+
+/**@brief  Parse the shim's own arguments from its command line
+ *
+ * @param  COMMAND_LINE:    full command line including the shim itself
+ *
+ * @return options with CALLING_ARGS holding the arguments to pass on
+ */
+ShimOptions ParseShimOptions(const wstring& command_line) {
+  ShimOptions options;
+  wstring     program;
+
+  vector<wstring> arg_list  = ParseArguments(command_line);
+  GetArgument(arg_list, 0, program);
+  TRACE("parse_args");
+
+  // Before --shim-Relay, whose pattern matches it as well
+  GetArgument(arg_list, L"--shim-RelayHost", options.relay_host);
+
+  options.log               = GetShimArg(arg_list, L"l");
+  options.wait              = GetShimArg(arg_list, L"w");
+  options.exit              = GetShimArg(arg_list, L"e");
+  options.gui               = GetShimArg(arg_list, L"g");
+  options.use_target        = GetShimArg(arg_list, L"u");
+  options.noop              = GetShimArg(arg_list, L"n");
+  options.tee               = GetShimArg(arg_list, L"tee");   // before "t"
+  options.trace             = GetShimArg(arg_list, L"t");
+  options.profile           = GetShimArg(arg_list, L"p");
+  options.relay             = GetShimArg(arg_list, L"r");
+
+  // If there still exists an argument starting with "--shim", its for help
+  options.help              = GetArgument(arg_list, L"--shim.*");
+  TRACE("shim_args");
+
+  // Any arguments left, save to pass to parent executable
+  options.calling_args      = CollapseArguments(arg_list);
+  return options;
+}
+
+
+// ----------------------------- Embedded Data ----------------------------- //
+struct ShimConfig {
+  wstring   path;                       // SHIM_PATH
+  wstring   args;                       // SHIM_ARGS
+  wstring   type;                       // SHIM_TYPE
+  wstring   env;                        // SHIM_ENV
+  wstring   sched;                      // SHIM_SCHED
+  wstring   response;                   // SHIM_RESPONSE
+};
+
+
+/**@brief  Read the configuration embedded in the shim
+ *
+ * @return TRUE if it has an application path
+ */
+bool LoadShimConfig(ShimConfig& config) {
+  bool has_path = GetResourceData("SHIM_PATH", config.path);
+  TRACE("res_path");
+  GetResourceData("SHIM_ARGS", config.args);
+  TRACE("res_args");
+  GetResourceData("SHIM_TYPE", config.type);
+  TRACE("res_type");
+  GetResourceData("SHIM_ENV", config.env);
+  TRACE("res_env");
+  GetResourceData("SHIM_SCHED", config.sched);
+  TRACE("res_sched");
+  GetResourceData("SHIM_RESPONSE", config.response);
+  TRACE("res_response");
+  return has_path;
+}
+
+
+/**@brief  Check the configuration points to a valid application
+ *
+ * @param  CONFIG:      embedded configuration
+ * @param  SHIM_PATH:   path of the shim itself
+ *
+ * @return nullptr if valid otherwise the reason why not
+ */
+const char* ValidateShimConfig(const ShimConfig& config,
+                               const filesystem::path& shim_path) {
+  error_code ec;
+  if (config.path.empty())
+    return "Shim has no application path. ";
+  if (!filesystem::exists(config.path, ec))
+    return "Shim application path does not exist. ";
+  if (filesystem::equivalent(shim_path, config.path, ec))
+    return "Shim points to itself. ";
+  return nullptr;
+}
+
+
+// ----------------------------- Launch Plan ------------------------------- //
+struct LaunchPlan {
+  wstring   path;                       // application to run
+  wstring   args;                       // embedded + calling arguments
+  wstring   working_dir;
+  vector<EnvOverride> environment;      // applied to the shim's environment
+  SchedPolicy sched;                    // affinity, priority and caps
+  bool      wait =          false;      // wait for it to exit
+  bool      relay =         false;      // stdio through pipes
+  wstring   relay_host;                 // pipes to connect it to instead
+  filesystem::path tee_file;            // copy its output here as well
+  size_t    response_at =   wstring::npos; // args from here in a file
+};
+
+
+/**@brief  Decide how to launch the application
+ *
+ * @param  OPTIONS:     shim arguments (with EXIT already implied by GUI)
+ * @param  CONFIG:      embedded configuration
+ * @param  SHIM_DIR:    directory of the shim
+ * @param  CURR_DIR:    current directory
+ */
+LaunchPlan ResolveLaunch(const ShimOptions& options, const ShimConfig& config,
+                         const wstring& shim_dir, const wstring& curr_dir) {
+  LaunchPlan plan;
+  plan.path = config.path;
+
+  // Console shims wait unless told otherwise, GUI only if told to
+  plan.wait = config.type == L"CONSOLE" ? !options.exit : options.wait;
+
+  // Combine the embedded and calling arguments
+  plan.args = config.args;
+  if (!options.calling_args.empty() && !plan.args.empty())
+    plan.args += L" ";
+  plan.args += options.calling_args;
+
+  // for console application, set wd to where the shim was called from
+  wstring fallback_dir = config.type == L"CONSOLE" ? curr_dir : shim_dir;
+
+  plan.working_dir = options.use_target ?
+    filesystem::path(config.path).parent_path().wstring() : fallback_dir;
+
+  plan.environment = ParseEnvOverrides(config.env);
+  plan.sched       = ParseSchedPolicy(config.sched);
+
+  // Relaying needs the shim to stay and pump
+  plan.relay = options.relay || options.tee || !options.relay_host.empty();
+  plan.wait  = plan.wait || plan.relay;
+
+  // A relay host is started by a shim that has already resolved the rest
+  if (!options.relay_host.empty()) {
+    plan.relay_host   = options.relay_host;
+    plan.args         = options.calling_args;
+    plan.working_dir  = curr_dir;
+  }
+
+  // Arguments too long for a command line go in a response file, if the
+  // application reads one: the calling arguments if the rest then fits,
+  // otherwise all of them
+  if (!config.response.empty() &&
+      plan.path.size() + 1 + plan.args.size() >= RESPONSE_COMMAND_LIMIT) {
+    size_t embedded = plan.relay_host.empty() ? config.args.size() : 0;
+    plan.response_at = embedded > 0 && embedded < plan.args.size() &&
+      plan.path.size() + embedded + RESPONSE_PATH_ROOM <
+      RESPONSE_COMMAND_LIMIT ? embedded + 1 : 0;
+  }
+
+  return plan;
+}
+
+
+// ------------------------------------------------------------------------- //
+#endif  // SHIM_CORE_H
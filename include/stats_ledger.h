@@ -0,0 +1,441 @@
+// ------------------------------------------------------------------------- //
+// Launch Statistics Ledger                                                  //
+// ------------------------------------------------------------------------- //
+/**@file    STATS_LEDGER.H
+ * @brief   Per-shim invocation counters in a shared memory-mapped file
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * With SHIM_STATS set, every shim records its invocation in STATS_FILE_NAME,
+ * next to it (or in the directory SHIM_STATS names), which the generator
+ * summarizes with --stats DIR.
+ *
+ * The file is a header and a fixed number of fixed size slots, one per shim
+ * name, every field a little-endian 64-bit integer (32-bit in the header)
+ * at a fixed offset so the same file reads the same on any platform:
+ *
+ *      header      magic, version, slot count, slot size, bucket count
+ *      slot        key     hash of the name, 0 while free
+ *                  name    up to 64 bytes, NUL padded
+ *                  count, failures, wall time (us), last used (Unix time)
+ *                  histogram of wall time, bucket N counting [2^N, 2^N+1) us
+ *                  exec count
+ *
+ * A shim that execs the application (not waiting, on POSIX) is gone before
+ * the outcome is known, so it only adds to the exec count: count, failures
+ * and wall time are of the runs a shim waited for.
+ *
+ * Shims never lock it. A name's slot is found by probing from its hash and
+ * claimed with a compare-and-swap on the key, after which every update is an
+ * atomic add (or store) on the mapping, so concurrent shims never wait on
+ * each other. A full ledger simply stops recording new names.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef STATS_LEDGER_H
+#define STATS_LEDGER_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <algorithm>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+#define STATS_FILE_NAME     L"shim_stats.bin"
+#define STATS_MAGIC         0x314154534D494853ull   // "SHIMSTA1"
+#define STATS_VERSION       1
+#define STATS_SLOTS         1024
+#define STATS_NAME_SIZE     64
+#define STATS_BUCKETS       32
+
+static_assert(atomic<uint64_t>::is_always_lock_free &&
+              sizeof(atomic<uint64_t>) == 8, "64-bit atomics in the file");
+
+// The fields are mapped as native integers, which are little-endian on
+// every target (MSVC has no big-endian one)
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "the stats file is little-endian, and mapped as native integers"
+#endif
+
+
+// -------------------------------- Layout --------------------------------- //
+struct StatsHeader {
+  atomic<uint64_t>  magic;
+  atomic<uint32_t>  version;
+  atomic<uint32_t>  slots;
+  atomic<uint32_t>  slot_size;
+  atomic<uint32_t>  buckets;
+  uint64_t          reserved[5];
+};
+
+struct StatsSlot {
+  atomic<uint64_t>  key;
+  atomic<uint64_t>  name[STATS_NAME_SIZE / 8];
+  atomic<uint64_t>  count;
+  atomic<uint64_t>  failures;
+  atomic<uint64_t>  wall_us;
+  atomic<uint64_t>  last_used;
+  atomic<uint64_t>  histogram[STATS_BUCKETS];
+  atomic<uint64_t>  execs;
+  uint64_t          reserved[2];
+};
+
+static_assert(sizeof(StatsHeader) == 64 && sizeof(StatsSlot) == 384,
+              "stats file layout");
+
+constexpr size_t STATS_FILE_SIZE =
+  sizeof(StatsHeader) + STATS_SLOTS * sizeof(StatsSlot);
+
+
+// A copy of one slot, for reading
+struct StatsRecord {
+  string    name;
+  uint64_t  count =         0;
+  uint64_t  failures =      0;
+  uint64_t  wall_us =       0;
+  uint64_t  last_used =     0;
+  uint64_t  histogram[STATS_BUCKETS] = {};
+  uint64_t  execs =         0;
+};
+
+
+// FNV-1a, never 0 (which marks a free slot)
+uint64_t StatsKey(const string& name) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (unsigned char c : name)
+    hash = (hash ^ c) * 0x100000001b3ull;
+  return hash ? hash : 1;
+}
+
+// Bucket of a wall time, N for [2^N, 2^N+1) us
+int StatsBucket(uint64_t wall_us) {
+  int bucket = 0;
+  while (wall_us >>= 1)
+    bucket++;
+  return min(bucket, STATS_BUCKETS - 1);
+}
+
+
+// -------------------------------- Ledger --------------------------------- //
+class StatsLedger {
+public:
+  StatsLedger() = default;
+  StatsLedger(const StatsLedger&) = delete;
+  StatsLedger& operator=(const StatsLedger&) = delete;
+
+  ~StatsLedger() {
+    close();
+  }
+
+  /**@brief  Map the ledger file
+   *
+   * @param  FILE:    path of the ledger
+   * @param  CREATE:  create (or extend) it if needed, otherwise it must exist
+   *
+   * @return TRUE if mapped and of this layout
+   */
+  bool open(const filesystem::path& file, bool create = true) {
+    close();
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileW(
+        file.c_str(), GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        create ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+      return false;
+
+    LARGE_INTEGER size = {};
+    GetFileSizeEx(handle, &size);
+    HANDLE mapping = nullptr;
+    if (create || (uint64_t)size.QuadPart >= STATS_FILE_SIZE)
+      // Mapping more than the file has extends it
+      mapping = CreateFileMappingW(handle, nullptr, PAGE_READWRITE, 0,
+                                   (DWORD)STATS_FILE_SIZE, nullptr);
+    CloseHandle(handle);
+    if (!mapping)
+      return false;
+    base = (char*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0,
+                                STATS_FILE_SIZE);
+    CloseHandle(mapping);
+    if (!base)
+      return false;
+#else
+    int fd = ::open(file.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0),
+                    0666);
+    if (fd < 0)
+      return false;
+
+    // Every shim extends it to the same size, so racing to do so is harmless
+    struct stat st;
+    bool sized = fstat(fd, &st) == 0 &&
+      ((uint64_t)st.st_size >= STATS_FILE_SIZE ||
+       (create && ftruncate(fd, STATS_FILE_SIZE) == 0));
+    void* mapped = sized ? mmap(nullptr, STATS_FILE_SIZE,
+                                PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) :
+                           MAP_FAILED;
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+      return false;
+    base = (char*)mapped;
+#endif
+
+    // The first to map a new file writes the header
+    StatsHeader* h = header();
+    if (create && h->magic.load(memory_order_acquire) == 0) {
+      h->version.store(STATS_VERSION, memory_order_relaxed);
+      h->slots.store(STATS_SLOTS, memory_order_relaxed);
+      h->slot_size.store(sizeof(StatsSlot), memory_order_relaxed);
+      h->buckets.store(STATS_BUCKETS, memory_order_relaxed);
+      uint64_t empty = 0;
+      h->magic.compare_exchange_strong(empty, STATS_MAGIC,
+                                       memory_order_release);
+    }
+
+    if (h->magic.load(memory_order_acquire) != STATS_MAGIC ||
+        h->version.load(memory_order_relaxed) != STATS_VERSION ||
+        h->slots.load(memory_order_relaxed) != STATS_SLOTS ||
+        h->slot_size.load(memory_order_relaxed) != sizeof(StatsSlot) ||
+        h->buckets.load(memory_order_relaxed) != STATS_BUCKETS) {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  void close() {
+    if (!base)
+      return;
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+#else
+    munmap(base, STATS_FILE_SIZE);
+#endif
+    base = nullptr;
+  }
+
+  bool isOpen() const {
+    return base != nullptr;
+  }
+
+
+  /**@brief  Record one invocation
+   *
+   * @param  NAME:    of the shim (truncated to STATS_NAME_SIZE)
+   * @param  WALL_US: how long it took
+   * @param  FAILED:  if it failed to launch or the application failed
+   *
+   * @return FALSE if the ledger is not open or full
+   */
+  bool record(string name, uint64_t wall_us, bool failed) {
+    name.resize(min(name.size(), (size_t)STATS_NAME_SIZE));
+    StatsSlot* s = find(name);
+    if (!s)
+      return false;
+
+    s->count.fetch_add(1, memory_order_relaxed);
+    if (failed)
+      s->failures.fetch_add(1, memory_order_relaxed);
+    s->wall_us.fetch_add(wall_us, memory_order_relaxed);
+    s->histogram[StatsBucket(wall_us)].fetch_add(1, memory_order_relaxed);
+    s->last_used.store(time(nullptr), memory_order_relaxed);
+    return true;
+  }
+
+
+  /**@brief  Record an invocation that exec'd the application, its outcome
+   *         and wall time unknown
+   *
+   * @return FALSE if the ledger is not open or full
+   */
+  bool recordExec(string name) {
+    name.resize(min(name.size(), (size_t)STATS_NAME_SIZE));
+    StatsSlot* s = find(name);
+    if (!s)
+      return false;
+
+    s->execs.fetch_add(1, memory_order_relaxed);
+    s->last_used.store(time(nullptr), memory_order_relaxed);
+    return true;
+  }
+
+
+  // A copy of every slot in use
+  vector<StatsRecord> records() const {
+    vector<StatsRecord> all;
+    for (size_t i = 0; base && i < STATS_SLOTS; i++) {
+      StatsSlot* s = slot(i);
+      if (!s->key.load(memory_order_acquire))
+        continue;
+
+      StatsRecord r;
+      char name[STATS_NAME_SIZE + 1] = {};
+      for (size_t w = 0; w < STATS_NAME_SIZE / 8; w++) {
+        uint64_t word = s->name[w].load(memory_order_relaxed);
+        for (size_t b = 0; b < 8; b++)
+          name[w * 8 + b] = (char)(word >> (8 * b));
+      }
+      r.name      = name;
+      r.count     = s->count.load(memory_order_relaxed);
+      r.failures  = s->failures.load(memory_order_relaxed);
+      r.wall_us   = s->wall_us.load(memory_order_relaxed);
+      r.last_used = s->last_used.load(memory_order_relaxed);
+      for (size_t b = 0; b < STATS_BUCKETS; b++)
+        r.histogram[b] = s->histogram[b].load(memory_order_relaxed);
+      r.execs     = s->execs.load(memory_order_relaxed);
+      all.push_back(r);
+    }
+    return all;
+  }
+
+private:
+  char*  base =             nullptr;
+
+  StatsHeader* header() const {
+    return (StatsHeader*)base;
+  }
+
+  StatsSlot* slot(size_t i) const {
+    return (StatsSlot*)(base + sizeof(StatsHeader)) + i;
+  }
+
+  // Slot of NAME, claiming a free one for it if it has none
+  StatsSlot* find(const string& name) {
+    if (!base)
+      return nullptr;
+
+    uint64_t key = StatsKey(name);
+    for (size_t probe = 0; probe < STATS_SLOTS; probe++) {
+      StatsSlot* s     = slot((key + probe) % STATS_SLOTS);
+      uint64_t   found = s->key.load(memory_order_acquire);
+      if (found == key)
+        return s;
+      if (found)
+        continue;
+
+      // Free: take it, unless another shim just did (maybe for NAME)
+      if (s->key.compare_exchange_strong(found, key, memory_order_acq_rel)) {
+        for (size_t w = 0; w < STATS_NAME_SIZE / 8; w++) {
+          uint64_t word = 0;
+          for (size_t b = 0; b < 8 && w * 8 + b < name.size(); b++)
+            word |= uint64_t((unsigned char)name[w * 8 + b]) << (8 * b);
+          s->name[w].store(word, memory_order_relaxed);
+        }
+        return s;
+      }
+      if (found == key)
+        return s;
+    }
+    return nullptr;
+  }
+};
+
+
+// ------------------------------- Summary --------------------------------- //
+// Upper bound of the bucket holding the Pth percentile of RECORD's wall time
+uint64_t StatsPercentile(const StatsRecord& record, double p) {
+  uint64_t rank = (uint64_t)(p * record.count + 0.5), seen = 0;
+  for (int b = 0; b < STATS_BUCKETS; b++) {
+    seen += record.histogram[b];
+    if (seen >= max<uint64_t>(rank, 1))
+      return uint64_t(2) << b;
+  }
+  return 0;
+}
+
+// Microseconds as a short time, e.g. 12.5ms
+string FormatStatsTime(uint64_t us) {
+  char text[32];
+  if (us < 1000)
+    snprintf(text, sizeof(text), "%lluus", (unsigned long long)us);
+  else if (us < 1000000)
+    snprintf(text, sizeof(text), "%.1fms", us / 1e3);
+  else
+    snprintf(text, sizeof(text), "%.1fs", us / 1e6);
+  return text;
+}
+
+
+/**@brief  Table of the records, most used first
+ *
+ * CALLS counts every run, EXEC'D those whose outcome is unknown, and the
+ * rest are of the runs waited for. Percentiles are bucket upper bounds, i.e.
+ * within a factor of two.
+ */
+string FormatStatsTable(vector<StatsRecord> records) {
+  sort(records.begin(), records.end(),
+       [](const StatsRecord& a, const StatsRecord& b) {
+         return a.count + a.execs > b.count + b.execs;
+       });
+
+  string text;
+  char   line[256];
+  snprintf(line, sizeof(line),
+           "%-32s %9s %8s %8s %10s %8s %8s %8s %8s  %s\n", "SHIM", "CALLS",
+           "EXEC'D", "FAILED", "TOTAL", "MEAN", "P50", "P90", "P99",
+           "LAST USED");
+  text += line;
+
+  for (auto& r : records) {
+    char   used[32] = "-";
+    time_t last     = (time_t)r.last_used;
+    if (last) {
+      tm local = {};
+#ifdef _WIN32
+      localtime_s(&local, &last);
+#else
+      localtime_r(&last, &local);
+#endif
+      strftime(used, sizeof(used), "%Y-%m-%d %H:%M:%S", &local);
+    }
+
+    snprintf(line, sizeof(line),
+             "%-32s %9llu %8llu %8llu %10s %8s %8s %8s %8s  %s\n",
+             r.name.substr(0, 32).c_str(),
+             (unsigned long long)(r.count + r.execs),
+             (unsigned long long)r.execs, (unsigned long long)r.failures,
+             FormatStatsTime(r.wall_us).c_str(),
+             FormatStatsTime(r.count ? r.wall_us / r.count : 0).c_str(),
+             FormatStatsTime(StatsPercentile(r, 0.50)).c_str(),
+             FormatStatsTime(StatsPercentile(r, 0.90)).c_str(),
+             FormatStatsTime(StatsPercentile(r, 0.99)).c_str(), used);
+    text += line;
+  }
+  return text;
+}
+
+
+// ------------------------------------------------------------------------- //
+#endif  // STATS_LEDGER_H
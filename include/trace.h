@@ -0,0 +1,116 @@
+// ------------------------------------------------------------------------- //
+// Startup Tracing                                                           //
+// ------------------------------------------------------------------------- //
+/**@file    TRACE.H
+ * @brief   Timestamps the phases of the shim's startup
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Each TRACE(phase) records a high resolution timestamp into a fixed table
+ * (no allocation, no system calls beyond reading the clock) once tracing is
+ * enabled, and is a single test of a flag otherwise. The shim enables it
+ * before the first mark when tracing may have been requested (--shim-Trace
+ * or SHIM_TRACE set), and the table is then written to the log as a single
+ * JSON line giving the microseconds spent in each phase, e.g.
+ *
+ *   {"shim":"APP.EXE","unit":"us","exec_path":21,...,"total":912}
+ *
+ * Building with SHIM_TRACE=0 compiles every mark away.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+// ------------------------------------------------------------------------- //
+#include <chrono>
+#include <string>
+#include <utility_functions.h>
+
+#ifndef SHIM_TRACE
+#define SHIM_TRACE 1
+#endif
+
+#define TRACE_MAX_MARKS 32
+
+using namespace std;
+
+struct structtrace {
+  bool      enabled =       false;      // Record marks, written on exit
+  int       count =         0;
+  const char* phase[TRACE_MAX_MARKS];
+  chrono::steady_clock::time_point time[TRACE_MAX_MARKS];
+};
+
+structtrace TRACECFG;
+
+
+#if SHIM_TRACE
+/**@brief  Record the end of a phase (if tracing is enabled)
+ */
+inline void TraceMark(const char* phase) {
+  if (TRACECFG.enabled && TRACECFG.count < TRACE_MAX_MARKS) {
+    TRACECFG.phase[TRACECFG.count] = phase;
+    TRACECFG.time[TRACECFG.count++] = chrono::steady_clock::now();
+  }
+}
+
+
+/**@brief  Format the recorded marks as a JSON line
+ *
+ * The first mark is the start, every other is the time spent since the
+ * previous mark. START_TO_<RESUME> is the time from the start until the mark
+ * named RESUME and TOTAL until the last mark.
+ *
+ * @param  SHIM:    name of the shim (UTF-8)
+ * @param  RESUME:  name of the mark where the child was resumed
+ */
+string TraceLine(const string& shim, const char* resume = "child_resume") {
+  auto us = [](chrono::steady_clock::duration d) {
+    return to_string(chrono::duration_cast<chrono::microseconds>(d).count());
+  };
+
+  string line = "{\"shim\":" + JsonString(shim) + ",\"unit\":\"us\"";
+  if (TRACECFG.count == 0)
+    return line + "}";
+
+  for (int i = 1; i < TRACECFG.count; i++) {
+    line += ",\"" + string(TRACECFG.phase[i]) + "\":";
+    line += us(TRACECFG.time[i] - TRACECFG.time[i - 1]);
+  }
+
+  for (int i = 1; i < TRACECFG.count; i++) {
+    if (string(TRACECFG.phase[i]) == resume) {
+      line += ",\"start_to_" + string(resume) + "\":";
+      line += us(TRACECFG.time[i] - TRACECFG.time[0]);
+      break;
+    }
+  }
+
+  line += ",\"total\":";
+  line += us(TRACECFG.time[TRACECFG.count - 1] - TRACECFG.time[0]);
+  return line + "}";
+}
+
+#define TRACE(phase)    TraceMark(phase)
+#else
+#define TRACE(phase)    ((void)0)
+#endif
+
+// ------------------------------------------------------------------------- //
+#endif  // TRACE_H
@@ -0,0 +1,267 @@
+// ------------------------------------------------------------------------- //
+// UTF-8 Encoding                                                            //
+// ------------------------------------------------------------------------- //
+/**@file    UTF8.H
+ * @brief   Wide strings to UTF-8 in one pass, ASCII runs a vector at a time
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * Everything the shims print or store goes through here, wide strings being
+ * UTF-16 on Windows and UTF-32 elsewhere:
+ *
+ *  EncodeUtf8
+ *      converts UTF-16 (char16_t) or UTF-32 (char32_t) into a buffer of at
+ *      least UTF8_MAX_BYTES a unit, in one pass with no sizing pass before.
+ *      A surrogate pair is one character, a lone surrogate (or anything past
+ *      U+10FFFF) becomes U+FFFD as with WideCharToMultiByte.
+ *
+ *  AppendUtf8
+ *      converts a wide string onto the end of a string, which as a buffer
+ *      kept from one call to the next (see LOG) is not reallocated
+ *
+ * Text is mostly ASCII (paths, flags, log lines), so blocks of 16 (SSE2) or
+ * 32 (AVX2) units are checked at once and, when ASCII, narrowed by packing.
+ * Any other block is converted a character at a time. The path is chosen
+ * once by what the CPU runs (Utf8Best), AVX2 being compiled for it alone so
+ * the build needs no flags. UTF8_SIMD=0 leaves only the scalar path, which
+ * is also what other CPUs get. fuzz/utf8.cpp checks every path against a
+ * plain reference, bench/arguments.cpp times them.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef UTF8_H
+#define UTF8_H
+
+// ------------------------------------------------------------------------- //
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+#ifndef UTF8_SIMD
+#define UTF8_SIMD 1
+#endif
+
+#if UTF8_SIMD && (defined(__x86_64__) || defined(_M_X64))
+#define UTF8_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define UTF8_AVX2_TARGET
+#else
+#define UTF8_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#else
+#define UTF8_X86 0
+#endif
+
+using namespace std;
+
+// Most bytes a unit of U becomes (a pair of UTF-16 units is 4 bytes)
+#define UTF8_MAX_BYTES(U)   (sizeof(U) == 2 ? 3 : 4)
+
+// The wide string's units
+typedef conditional_t<sizeof(wchar_t) == 2, char16_t, char32_t> WideUnit;
+
+enum Utf8Path { UTF8_SCALAR, UTF8_SSE2, UTF8_AVX2 };
+
+
+// ------------------------------- Characters ------------------------------ //
+// Encode the character at SRC[I] to OUT, moving past both
+template <class U>
+inline char* EncodeCodePoint(const U* src, size_t n, size_t& i, char* out) {
+  uint32_t c = src[i++];
+  if (sizeof(U) == 2 && c >= 0xD800 && c <= 0xDBFF && i < n &&
+      src[i] >= 0xDC00 && src[i] <= 0xDFFF)
+    c = 0x10000 + ((c - 0xD800) << 10) + (src[i++] - 0xDC00);
+  else if (c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+    c = 0xFFFD;
+
+  if (c < 0x80)
+    *out++ = (char)c;
+  else if (c < 0x800) {
+    *out++ = (char)(0xC0 | (c >> 6));
+    *out++ = (char)(0x80 | (c & 0x3F));
+  }
+  else if (c < 0x10000) {
+    *out++ = (char)(0xE0 | (c >> 12));
+    *out++ = (char)(0x80 | ((c >> 6) & 0x3F));
+    *out++ = (char)(0x80 | (c & 0x3F));
+  }
+  else {
+    *out++ = (char)(0xF0 | (c >> 18));
+    *out++ = (char)(0x80 | ((c >> 12) & 0x3F));
+    *out++ = (char)(0x80 | ((c >> 6) & 0x3F));
+    *out++ = (char)(0x80 | (c & 0x3F));
+  }
+  return out;
+}
+
+
+// ------------------------------ Vector Paths ----------------------------- //
+#if UTF8_X86
+// 16 units to 16 bytes if all are ASCII
+template <class U>
+inline bool AsciiBlockSse2(const U* src, char* out) {
+  const __m128i* in = (const __m128i*)src;
+  __m128i packed;
+  if (sizeof(U) == 2) {
+    __m128i a = _mm_loadu_si128(in), b = _mm_loadu_si128(in + 1);
+    __m128i high = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16(-0x80));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) !=
+        0xFFFF)
+      return false;
+    packed = _mm_packus_epi16(a, b);
+  }
+  else {
+    __m128i a = _mm_loadu_si128(in),     b = _mm_loadu_si128(in + 1);
+    __m128i c = _mm_loadu_si128(in + 2), d = _mm_loadu_si128(in + 3);
+    __m128i high = _mm_and_si128(
+        _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)),
+        _mm_set1_epi32(-0x80));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, _mm_setzero_si128())) !=
+        0xFFFF)
+      return false;
+    packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+  }
+  _mm_storeu_si128((__m128i*)out, packed);
+  return true;
+}
+
+// 32 units to 32 bytes if all are ASCII (packing works within each 128 bit
+// lane, hence the permutes putting them back in order)
+template <class U>
+UTF8_AVX2_TARGET inline bool AsciiBlockAvx2(const U* src, char* out) {
+  const __m256i* in = (const __m256i*)src;
+  __m256i packed;
+  if (sizeof(U) == 2) {
+    __m256i a = _mm256_loadu_si256(in), b = _mm256_loadu_si256(in + 1);
+    if (!_mm256_testz_si256(_mm256_or_si256(a, b),
+                            _mm256_set1_epi16(-0x80)))
+      return false;
+    packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+  }
+  else {
+    __m256i a = _mm256_loadu_si256(in),     b = _mm256_loadu_si256(in + 1);
+    __m256i c = _mm256_loadu_si256(in + 2), d = _mm256_loadu_si256(in + 3);
+    if (!_mm256_testz_si256(
+            _mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d)),
+            _mm256_set1_epi32(-0x80)))
+      return false;
+    packed = _mm256_permutevar8x32_epi32(
+        _mm256_packus_epi16(_mm256_packs_epi32(a, b),
+                            _mm256_packs_epi32(c, d)),
+        _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+  }
+  _mm256_storeu_si256((__m256i*)out, packed);
+  return true;
+}
+
+// Whole blocks while ASCII, otherwise the block a character at a time
+template <class U, size_t BLOCK, bool (*ASCII)(const U*, char*)>
+inline size_t EncodeBlocks(const U* src, size_t n, char* dst) {
+  char*  out = dst;
+  size_t i   = 0;
+  while (n - i >= BLOCK) {
+    if (ASCII(src + i, out)) {
+      i   += BLOCK;
+      out += BLOCK;
+      continue;
+    }
+    for (size_t end = i + BLOCK; i < end; )
+      out = EncodeCodePoint(src, n, i, out);
+  }
+  while (i < n)
+    out = EncodeCodePoint(src, n, i, out);
+  return out - dst;
+}
+
+template <class U>
+UTF8_AVX2_TARGET size_t EncodeUtf8Avx2(const U* src, size_t n, char* dst) {
+  return EncodeBlocks<U, 32, AsciiBlockAvx2<U>>(src, n, dst);
+}
+#endif
+
+
+// -------------------------------- Encoding ------------------------------- //
+// The fastest path this CPU runs
+Utf8Path Utf8Best() {
+#if UTF8_X86
+  static const Utf8Path best = [] {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+      return UTF8_SSE2;
+    __cpuid(info, 1);
+    bool os_saves = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return os_saves && (info[1] & (1 << 5)) ? UTF8_AVX2 : UTF8_SSE2;
+#else
+    return __builtin_cpu_supports("avx2") ? UTF8_AVX2 : UTF8_SSE2;
+#endif
+  }();
+  return best;
+#else
+  return UTF8_SCALAR;
+#endif
+}
+
+
+/**@brief  Convert N units of UTF-16 or UTF-32 to UTF-8
+ *
+ * @param  DST:     room for UTF8_MAX_BYTES(U) * N bytes
+ * @param  PATH:    a path other than the best, which the CPU must run
+ *
+ * @return bytes written
+ */
+template <class U>
+size_t EncodeUtf8(const U* src, size_t n, char* dst,
+                  Utf8Path path = Utf8Best()) {
+  static_assert(sizeof(U) == 2 || sizeof(U) == 4, "UTF-16 or UTF-32");
+#if UTF8_X86
+  if (path == UTF8_AVX2)
+    return EncodeUtf8Avx2(src, n, dst);
+  if (path == UTF8_SSE2)
+    return EncodeBlocks<U, 16, AsciiBlockSse2<U>>(src, n, dst);
+#endif
+  char* out = dst;
+  for (size_t i = 0; i < n; )
+    out = EncodeCodePoint(src, n, i, out);
+  return out - dst;
+}
+
+
+/**@brief  Convert N wide characters onto the end of OUT
+ *
+ * OUT grows to what the worst case needs and is cut back after, so a buffer
+ * used again keeps its capacity.
+ */
+void AppendUtf8(const wchar_t* src, size_t n, string& out) {
+  size_t at = out.size();
+  out.resize(at + n * UTF8_MAX_BYTES(WideUnit));
+  out.resize(at + EncodeUtf8((const WideUnit*)src, n, &out[at]));
+}
+
+void AppendUtf8(const wstring& src, string& out) {
+  AppendUtf8(src.data(), src.size(), out);
+}
+
+
+// ------------------------------------------------------------------------- //
+#endif  // UTF8_H
@@ -31,11 +31,30 @@
  *      upper cases a string
  *  
  *  NarrowString
- *      converts a wstring -> string
+ *      converts a wstring -> string (UTF-8, see UTF8.H)
+ *  
+ *  WidenString
+ *      converts a string -> wstring (POSIX ARGV, and UTF-8 files)
+ *  
+ *  JsonString
+ *      quotes a UTF-8 string as a JSON string
  *  
  *  GetExecPath
  *      gets the path of the executable
  *  
+ *  GetEnvironmentValue
+ *      gets an environment variable, FALSE if it is not set
+ *  
+ *  ParseSize
+ *      converts a size with an optional K, M, or G suffix (e.g. "64K") into
+ *      bytes
+ *  
+ *  Release
+ *      frees the memory held by a string, vector, or struct of them
+ *  
+ *  TrimMemory
+ *      returns free heap memory to the system and trims the working set
+ *  
  * ------------------------------------------------------------------------- 
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -55,10 +74,21 @@
 #define UTILITY_FUNCTIONS_H
 
 // ------------------------------------------------------------------------- //
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <cstdlib>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#endif
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <cwctype>
+#include <algorithm>
 #include <filesystem>
+#include <utf8.h>
 
 using namespace std;
 
@@ -86,7 +116,7 @@ wstring UnquoteString(const wstring& input) {
 
 
 bool TrimQuotes(wstring& s) {
-  if(s.front() == '"' && s.back() == '"') {
+  if(s.size() >= 2 && s.front() == '"' && s.back() == '"') {
     s.erase(s.begin());
     s.erase(s.end()-1);
     return true;
@@ -101,20 +131,48 @@ bool UpperCase(wstring& s) {
 }
 
 
-// Convert Wide --> Narrow
+// Convert Wide --> Narrow (UTF-8) in one pass (see UTF8.H)
 string NarrowString(const wstring& wstr) {
-  if (wstr.empty())
-    return string();
-  
-  int sz = WideCharToMultiByte(
-      CP_UTF8, 0, &wstr[0], (int)wstr.size(),
-      0, 0, 0, 0);
-  
-  string res(sz, 0);
-  WideCharToMultiByte(
-      CP_UTF8, 0, &wstr[0], (int)wstr.size(),
-      &res[0], sz, 0, 0);
-  
+  string res;
+  AppendUtf8(wstr, res);
+  return res;
+}
+
+
+// Quote (UTF-8) as a JSON string, escaping quotes, backslashes and controls
+string JsonString(const string& str) {
+  string res = "\"";
+  for (unsigned char c : str) {
+    if (c == '"' || c == '\\')
+      res += '\\';
+    if (c >= 0x20) {
+      res += (char)c;
+      continue;
+    }
+    const char* hex = "0123456789abcdef";
+    res += "\\u00";
+    res += hex[c >> 4];
+    res += hex[c & 15];
+  }
+  return res + "\"";
+}
+
+
+#ifdef _WIN32
+// Convert Narrow (UTF-8) --> Wide, invalid bytes become U+FFFD
+wstring WidenString(const string& str) {
+  if (str.empty())
+    return wstring();
+
+  int sz = MultiByteToWideChar(
+      CP_UTF8, 0, &str[0], (int)str.size(),
+      0, 0);
+
+  wstring res(sz, 0);
+  MultiByteToWideChar(
+      CP_UTF8, 0, &str[0], (int)str.size(),
+      &res[0], sz);
+
   return res;
 }
 
@@ -126,5 +184,111 @@ filesystem::path GetExecPath() {
 }  
 
 
+bool GetEnvironmentValue(const wchar_t* name, wstring& value) {
+  value.clear();
+  DWORD sz = GetEnvironmentVariableW(name, nullptr, 0);
+  if (sz == 0)
+    return false;
+
+  value.resize(sz);
+  sz = GetEnvironmentVariableW(name, &value[0], sz);
+  value.resize(sz);
+  return true;
+}
+
+#else
+// Convert Narrow (UTF-8) --> Wide (UTF-32), invalid bytes become U+FFFD
+wstring WidenString(const string& str) {
+  wstring res;
+  res.reserve(str.size());
+
+  for (size_t i = 0; i < str.size(); ) {
+    unsigned char b = str[i];
+    size_t   len = b < 0x80 ? 1 : b < 0xC2 ? 0 : b < 0xE0 ? 2 : b < 0xF0 ? 3 :
+                   b < 0xF5 ? 4 : 0;
+    uint32_t c   = len == 1 ? b : len == 2 ? b & 0x1F : len == 3 ? b & 0x0F :
+                   b & 0x07;
+
+    size_t n = 1;
+    for (; len > 1 && n < len && i + n < str.size(); n++) {
+      unsigned char cb = str[i + n];
+      if ((cb & 0xC0) != 0x80)
+        break;
+      c = (c << 6) | (cb & 0x3F);
+    }
+
+    // Truncated, overlong, or surrogate
+    if (len == 0 || n < len ||
+        (len == 3 && (c < 0x800 || (c >= 0xD800 && c <= 0xDFFF))) ||
+        (len == 4 && (c < 0x10000 || c > 0x10FFFF))) {
+      res += (wchar_t)0xFFFD;
+      i += len == 0 ? 1 : n;
+      continue;
+    }
+
+    res += (wchar_t)c;
+    i += len;
+  }
+  return res;
+}
+
+
+filesystem::path GetExecPath() {
+  error_code ec;
+  return filesystem::read_symlink("/proc/self/exe", ec);
+}  
+
+
+bool GetEnvironmentValue(const wchar_t* name, wstring& value) {
+  value.clear();
+  const char* env = getenv(NarrowString(name).c_str());
+  if (env == nullptr)
+    return false;
+
+  value = WidenString(env);
+  return true;
+}
+#endif
+
+
+// Unlike clear(), also gives back the allocation (swapped into EMPTY)
+template <typename T>
+void Release(T& value) {
+  T empty;
+  swap(value, empty);
+}
+
+
+void TrimMemory() {
+#ifdef _WIN32
+  HeapCompact(GetProcessHeap(), 0);
+  SetProcessWorkingSetSize(GetCurrentProcess(), (SIZE_T)-1, (SIZE_T)-1);
+#elif defined(__GLIBC__)
+  malloc_trim(0);
+#endif
+}
+
+
+uint64_t ParseSize(const wstring& s) {
+  size_t end = 0;
+  uint64_t size = 0;
+  try {
+    size = stoull(s, &end);
+  }
+  catch (...) {
+    return 0;
+  }
+  
+  if (end < s.size()) {
+    switch (towupper(s[end])) {
+    case 'G': size <<= 10; [[fallthrough]];
+    case 'M': size <<= 10; [[fallthrough]];
+    case 'K': size <<= 10;
+    }
+  }
+  return size;
+}
+
+
 // ------------------------------------------------------------------------- //
 #endif // UTILITY_FUNCTIONS_H
@@ -0,0 +1,317 @@
+// ------------------------------------------------------------------------- //
+// Directory Watching                                                        //
+// ------------------------------------------------------------------------- //
+/**@file    WATCH.H
+ * @brief   Change notifications of a directory tree, coalesced into batches
+ * @author  John P. Hilbert
+ * @email   jphilbert@gmail.com
+ * @date    10/18/2026
+ *
+ * -------------------------------------------------------------------------
+ * With --watch DIR the generator keeps the shims of OUTPUT in step with the
+ * executables under DIR. An install or uninstall touches many files in a
+ * burst, so the changes are not acted on one by one:
+ *
+ *  ChangeCoalescer
+ *      collects the paths changed, each once, and hands them over as a
+ *      batch once no change has come for QUIET, or MAX_WAIT after the first
+ *      (so a steady trickle still gets through). A path under a directory
+ *      that changed itself is left out, the directory covering it. Lost
+ *      events (OVERFLOW) make the batch a rescan of everything. Time is
+ *      passed in, so it runs as well on a synthetic stream of events (see
+ *      fuzz/watch.cpp) as on real ones.
+ *
+ *  DirectoryWatcher
+ *      adds the paths the OS reports changed under DIR to a ChangeCoalescer:
+ *      ReadDirectoryChangesW on Windows, inotify (a watch per directory,
+ *      added as directories appear) on Linux
+ *
+ * What a batch means for the shims is up to the caller, which looks at each
+ * path as it is then rather than at the events that led there.
+ *
+ * -------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <https://www.gnu.org/licenses/>.
+ * ------------------------------------------------------------------------- */
+
+#ifndef WATCH_H
+#define WATCH_H
+
+// ------------------------------------------------------------------------- //
+#include <set>
+#include <map>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cerrno>
+#include <cstdint>
+#include <algorithm>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+using namespace std;
+
+#define WATCH_QUIET_MS      500         // a burst ends after this long quiet
+#define WATCH_MAX_WAIT_MS   5000        // nor is any change held longer
+#define WATCH_BUFFER_SIZE   65536
+
+
+// ------------------------------- Coalescing ------------------------------ //
+class ChangeCoalescer {
+public:
+  typedef chrono::steady_clock::time_point time_point;
+
+  ChangeCoalescer(chrono::milliseconds quiet =
+                    chrono::milliseconds(WATCH_QUIET_MS),
+                  chrono::milliseconds max_wait =
+                    chrono::milliseconds(WATCH_MAX_WAIT_MS))
+    : quiet(quiet), max_wait(max_wait) {}
+
+  void add(const filesystem::path& path, time_point now) {
+    filesystem::path normal = path.lexically_normal();
+    if (!normal.has_filename() && normal.has_relative_path())
+      normal = normal.parent_path();    // "dir/" is "dir"
+    touch(now);
+    paths.insert(normal);
+  }
+
+  // Events were lost, so anything may have changed
+  void overflow(time_point now) {
+    touch(now);
+    rescan = true;
+  }
+
+  bool pending() const {
+    return rescan || !paths.empty();
+  }
+
+  // When the batch is due, time_point::max() if there is none
+  time_point due() const {
+    if (!pending())
+      return time_point::max();
+    return min(last + quiet, first + max_wait);
+  }
+
+  /**@brief  Take the batch if it is due by NOW
+   *
+   * @param  CHANGED: the paths changed, none under another
+   * @param  ALL:     TRUE if events were lost, CHANGED then being empty
+   *
+   * @return FALSE if there is no batch due yet
+   */
+  bool take(time_point now, vector<filesystem::path>& changed, bool& all) {
+    changed.clear();
+    all = rescan;
+    if (!pending() || now < due())
+      return false;
+
+    if (!rescan)
+      for (auto& path : paths)
+        if (!covered(path))
+          changed.push_back(path);
+    paths.clear();
+    rescan = false;
+    return true;
+  }
+
+private:
+  chrono::milliseconds      quiet;
+  chrono::milliseconds      max_wait;
+  set<filesystem::path>     paths;
+  bool                      rescan =    false;
+  time_point                first;
+  time_point                last;
+
+  void touch(time_point now) {
+    if (!pending())
+      first = now;
+    last = now;
+  }
+
+  // By a directory above it that changed too
+  bool covered(const filesystem::path& path) const {
+    for (auto p = path.parent_path(); p.has_relative_path();
+         p = p.parent_path())
+      if (paths.count(p))
+        return true;
+    return false;
+  }
+};
+
+
+// -------------------------------- Watching ------------------------------- //
+class DirectoryWatcher {
+public:
+  /**@brief  Start watching ROOT and everything under it
+   *
+   * @return FALSE if it cannot be watched
+   */
+  bool open(const filesystem::path& root_dir) {
+    root = root_dir;
+#ifdef _WIN32
+    dir = CreateFileW(root.c_str(), FILE_LIST_DIRECTORY,
+                      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                      nullptr, OPEN_EXISTING,
+                      FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+                      nullptr);
+    if (dir == INVALID_HANDLE_VALUE)
+      return false;
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    return overlapped.hEvent && request();
+#else
+    notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    return notify >= 0 && watchTree(root);
+#endif
+  }
+
+  /**@brief  Wait up to TIMEOUT (forever if negative) for changes
+   *
+   * @param  CHANGES: to add the paths changed to
+   *
+   * @return FALSE if watching failed (e.g. ROOT was removed)
+   */
+  bool wait(chrono::milliseconds timeout, ChangeCoalescer& changes) {
+#ifdef _WIN32
+    DWORD waited = WaitForSingleObject(
+        overlapped.hEvent,
+        timeout.count() < 0 ? INFINITE : (DWORD)timeout.count());
+    if (waited == WAIT_TIMEOUT)
+      return true;
+    DWORD size = 0;
+    if (waited != WAIT_OBJECT_0 ||
+        !GetOverlappedResult(dir, &overlapped, &size, FALSE))
+      return false;
+
+    auto now = chrono::steady_clock::now();
+    if (size == 0)                      // the buffer overflowed
+      changes.overflow(now);
+    for (DWORD at = 0; size > 0; ) {
+      auto info = (const FILE_NOTIFY_INFORMATION*)(buffer + at);
+      changes.add(root / wstring(info->FileName,
+                                 info->FileNameLength / sizeof(WCHAR)), now);
+      if (info->NextEntryOffset == 0)
+        break;
+      at += info->NextEntryOffset;
+    }
+    return request();
+#else
+    struct pollfd ready = {notify, POLLIN, 0};
+    int polled = poll(&ready, 1, timeout.count() < 0 ? -1 :
+                      (int)min<int64_t>(timeout.count(), INT32_MAX));
+    if (polled <= 0)
+      return polled == 0 || errno == EINTR;
+
+    ssize_t size;
+    while ((size = read(notify, buffer, sizeof(buffer))) > 0) {
+      auto now = chrono::steady_clock::now();
+      for (ssize_t at = 0; at < size; ) {
+        auto event = (const struct inotify_event*)(buffer + at);
+        at += sizeof(struct inotify_event) + event->len;
+
+        if (event->mask & IN_Q_OVERFLOW) {
+          changes.overflow(now);
+          continue;
+        }
+        auto found = watches.find(event->wd);
+        if (found == watches.end())
+          continue;
+        if (event->mask & IN_IGNORED) {
+          watches.erase(found);
+          continue;
+        }
+
+        filesystem::path path = found->second;
+        if (event->len > 0)
+          path /= event->name;
+        if ((event->mask & IN_ISDIR) &&
+            (event->mask & (IN_CREATE | IN_MOVED_TO)))
+          watchTree(path);
+        changes.add(path, now);
+      }
+    }
+    return watches.count(root_watch) > 0;
+#endif
+  }
+
+  ~DirectoryWatcher() {
+#ifdef _WIN32
+    if (dir != INVALID_HANDLE_VALUE) {
+      CancelIo(dir);
+      CloseHandle(dir);
+    }
+    if (overlapped.hEvent)
+      CloseHandle(overlapped.hEvent);
+#else
+    if (notify >= 0)
+      close(notify);
+#endif
+  }
+
+private:
+  filesystem::path  root;
+#ifdef _WIN32
+  HANDLE            dir =           INVALID_HANDLE_VALUE;
+  OVERLAPPED        overlapped =    {};
+  alignas(DWORD) BYTE buffer[WATCH_BUFFER_SIZE];
+
+  bool request() {
+    ResetEvent(overlapped.hEvent);
+    return ReadDirectoryChangesW(
+        dir, buffer, sizeof(buffer), TRUE,
+        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+        nullptr, &overlapped, nullptr);
+  }
+
+#else
+  int                     notify =      -1;
+  int                     root_watch =  -1;
+  map<int, filesystem::path> watches;
+  alignas(struct inotify_event) char buffer[WATCH_BUFFER_SIZE];
+
+  // A watch on DIR and every directory under it (files created there before
+  // the watch was added are covered by DIR's own event)
+  bool watchTree(const filesystem::path& dir) {
+    const uint32_t mask = IN_CREATE | IN_CLOSE_WRITE | IN_ATTRIB |
+      IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR;
+    int wd = inotify_add_watch(notify, dir.c_str(), mask);
+    if (wd < 0)
+      return false;
+    watches[wd] = dir;
+    if (dir == root)
+      root_watch = wd;
+
+    error_code ec;
+    for (filesystem::recursive_directory_iterator it(
+             dir, filesystem::directory_options::skip_permission_denied, ec),
+         end; !ec && it != end; it.increment(ec))
+      if (it->is_directory(ec)) {
+        int sub = inotify_add_watch(notify, it->path().c_str(), mask);
+        if (sub >= 0)
+          watches[sub] = it->path();
+      }
+    return true;
+  }
+#endif
+};
+
+
+// ------------------------------------------------------------------------- //
+#endif  // WATCH_H
@@ -1,134 +1,13 @@
 #include <version.h>
 #include <log.h>
-#include <resource_functions.h>
-#include <get_argument.h>
+#include <trace.h>
+#include <process_accounting.h>
+#include <shim_core.h>
+#include <launcher.h>
+#include <stats_ledger.h>
 #include <utility_functions.h>
 
-#pragma comment(lib, "SHELL32.LIB")
-
-
-#ifndef ERROR_ELEVATION_REQUIRED
-#define ERROR_ELEVATION_REQUIRED 740
-#endif
-
 #define BUFSIZE 4096
-#define SHIM_ARG_PREFIX L"--shim"
-
-bool GetShimArg(vector<wstring> &args, wstring pattern) {
-  wstring argFormat = SHIM_ARG_PREFIX;
-  argFormat += L"[a-z]*-";
-  argFormat += pattern;
-  argFormat += L"[a-z]*";
-  return GetArgument(args, argFormat);
-}
-
-
-// --------------------------- Process Creation ---------------------------- // 
-BOOL WINAPI CtrlHandler(DWORD ctrlType) {
-  switch (ctrlType) {
-    // Ignore all events, and let the child process handle them.
-  case CTRL_C_EVENT:
-  case CTRL_CLOSE_EVENT:
-  case CTRL_LOGOFF_EVENT:
-  case CTRL_BREAK_EVENT:
-  case CTRL_SHUTDOWN_EVENT:
-    return TRUE;
-
-  default:
-    return FALSE;
-  }
-}
-
-struct HandleDeleter {
-  typedef HANDLE pointer;
-  void operator()(HANDLE handle) {
-    if (handle) {
-      CloseHandle(handle);
-    }
-  }
-};
-
-namespace std {
-  typedef unique_ptr<HANDLE, HandleDeleter> unique_handle;
-}
-
-tuple<unique_handle, unique_handle> MakeProcess(
-    const wstring &path,
-    const wstring &args,
-    const wstring &workingDirectory) {
-  STARTUPINFOW        startInfo     = {};
-  PROCESS_INFORMATION processInfo   = {};
-  unique_handle       threadHandle;
-  unique_handle       processHandle;
-
-  // Build the Command Line
-  wstring cmd = path;
-  if(!args.empty())
-    cmd += L" " + args;
-  
-  // Set the Working Directory
-  LPCWSTR workingDirectoryCSTR = nullptr;
-  if (!workingDirectory.empty()) {
-      workingDirectoryCSTR = workingDirectory.c_str();
-
-      if (!PathFileExistsW(workingDirectoryCSTR))
-        LOG(2) <<
-          "Working directory does not exist, process may fail to start";
-  }
-  
-  // Create the Process
-  if (CreateProcessW(
-          nullptr,                 // No module name (use command line)       
-          cmd.data(),              // Command Line
-          nullptr, nullptr, TRUE,  // Inheritance (Process, Thread, Handle)
-          CREATE_SUSPENDED,        // Suspend threads on creation
-          nullptr,                 // Use parent's environment block          
-          workingDirectoryCSTR,    // Starting directory         
-          &startInfo, &processInfo)) {
-    // Set the handles
-    threadHandle.reset(processInfo.hThread);
-    processHandle.reset(processInfo.hProcess);
-    
-    // Start the thread
-    ResumeThread(threadHandle.get());
-  }
-  else if (GetLastError() == ERROR_ELEVATION_REQUIRED) {
-    // We must elevate the process, which is (basically) impossible with
-    // CreateProcess, and therefore we fallback to ShellExecuteEx, which CAN
-    // create elevated processes, at the cost of opening a new separate
-    // window.  Theoretically, this could be fixed (or rather, worked around)
-    // using pipes and IPC, but... this is a question for another day.
-
-    SHELLEXECUTEINFOW sei = {};
-
-    sei.cbSize = sizeof(SHELLEXECUTEINFOW);
-    sei.fMask = SEE_MASK_NOCLOSEPROCESS;
-    sei.lpFile = path.c_str();
-    sei.lpParameters = args.c_str();
-    sei.nShow = SW_SHOW;
-    sei.lpDirectory = workingDirectoryCSTR;
-
-    if (!ShellExecuteExW(&sei)) {
-      LOG(1) << "Unable to create elevated process: error ";
-      LOG(-1) << GetLastError();
-      return {move(processHandle), move(threadHandle)};
-    }
-
-    processHandle.reset(sei.hProcess);
-  }
-  else {
-    LOG(1) << "Could not create process with command: ";
-    LOG(-1) << "'" << cmd << "'";
-    return {move(processHandle), move(threadHandle)};
-  }
-
-  // Ignore Ctrl-C and other signals
-  if (!SetConsoleCtrlHandler(CtrlHandler, TRUE)) 
-    LOG(2) << "Could not set control handler; Ctrl-C behavior may be invalid";
-
-  return {move(processHandle), move(threadHandle)};
-}
-
 
 
 // ----------------------------- Help Message ------------------------------ // 
@@ -153,7 +32,7 @@ additional information.
 They are not case-sensitive and have an equivilent shimgen alias for
 Chocolately compatibility.
 
-Technically the arguments need only match "--shim[a-z]*-[hlwegun][a-z]*".
+Technically the arguments need only match "--shim[a-z]*-[hlweguntpr][a-z]*".
 
 All other argument are passed to the parent executable.
 
@@ -161,7 +40,10 @@ All other argument are passed to the parent executable.
 
     --shim-Log      Turns on diagnostic messaging in the console. If a windows
                         application executed without a console, a file (<shim
-                        path>.SHIM.LOG) will be generated instead.
+                        path>.SHIM.LOG) will be generated instead. Setting the
+                        environment variable SHIM_LOG_ROTATE to a size (e.g.
+                        1M) rotates this file to <shim path>.SHIM.LOG.1 once it
+                        would grow larger.
                         (alias --shimgen-log)
 
     --shim-Wait     Explicitly tell the shim to wait for target to exit. Useful
@@ -194,42 +76,175 @@ All other argument are passed to the parent executable.
 
     --shim-NoOp     Executes the shim without calling the target application.
                         Logging is implicitly turned on.
-                        (alias --shimgen-noop))V0G0N";
+                        (alias --shimgen-noop)
+
+    --shim-Trace    Times each phase of the shim's startup and writes them to
+                        the log as a single JSON line (in microseconds) when
+                        the shim exits. Setting the environment variable
+                        SHIM_TRACE has the same effect without changing the
+                        command line.
+
+    --shim-Profile  When waiting for the target, writes the resources used by
+                        it and any process it started to the log as a single
+                        JSON line: wall, user and kernel time, peak memory, I/O
+                        bytes and process count. Setting the environment
+                        variable SHIM_PROFILE_FILE to a path appends the same
+                        line to that file instead (or as well).
+
+    --shim-Relay    Connects the target's stdin, stdout and stderr to the
+                        shim's through pipes, with the shim waiting for it and
+                        copying between the two. On Windows this keeps the
+                        console of a target that must run elevated, by starting
+                        it through an elevated copy of the shim, rather than
+                        opening it in a new window.
+
+    --shim-Tee      Relays as --shim-Relay does, also appending everything the
+                        target writes to stdout and stderr to the shim's log
+                        file (<shim path>.LOG). The target is never held up by
+                        the log: should the disk fall behind, output is left
+                        out of the log and the number of bytes is noted there
+                        instead.
+
+    Setting the environment variable SHIM_STATS counts every run of the shim
+    in the ledger shim_stats.bin next to it (or in the directory SHIM_STATS
+    names): calls, failures and wall time, summarized by shim_exec --stats.
+    Failures and wall time are of the runs the shim waited for, those that
+    exec'd the application being counted as such.
+
+    A shim created with --response-file passes arguments that would make the
+    command line longer than 32,767 characters to the target in a temporary
+    file, as @FILE, removed once the target exits if the shim waits for it.)V0G0N";
   
   exit(0);
 }
 
 
+// ----------------------------- Startup Trace ----------------------------- // 
+// Whether tracing may have been requested, known before the first mark so
+// that nothing is timed otherwise: SHIM_TRACE is set or there is a --shim
+// argument at all (tracing is disabled again once it is parsed if it was not
+// --shim-Trace)
+#if SHIM_TRACE
+bool TraceRequested(const wstring& command_line) {
+  wstring value;
+  if (GetEnvironmentValue(L"SHIM_TRACE", value))
+    return true;
+  const wstring prefix = SHIM_ARG_PREFIX;
+  return search(command_line.begin(), command_line.end(), prefix.begin(),
+                prefix.end(), [](wchar_t c, wchar_t p) {
+                  return (wchar_t)towlower(c) == p;
+                }) != command_line.end();
+}
+#endif
+
+
+// Writes the trace however ShimMain returns
+struct TraceReport {
+  wstring shim;
+  bool    reported =        false;
+  
+  void report() {
+#if SHIM_TRACE
+    if (!TRACECFG.enabled || reported)
+      return;
+    reported = true;
+    TRACE("exit");
+    LOG() << TraceLine(NarrowString(shim));
+#endif
+  }
+
+  ~TraceReport() {
+    report();
+  }
+};
+
+
+// Counts the invocation in the stats ledger however ShimMain returns
+struct StatsReport {
+  filesystem::path  file;               // empty unless SHIM_STATS is set
+  string            shim;
+  const int&        exit_code;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  bool              reported =      false;
+
+  // EXEC: the shim is about to become the application, whose outcome and
+  // wall time it will never see
+  void report(bool exec = false) {
+    if (file.empty() || reported)
+      return;
+    reported = true;
+
+    uint64_t wall_us = chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now() - start).count();
+    StatsLedger ledger;
+    if (!ledger.open(file) ||
+        !(exec ? ledger.recordExec(shim) :
+                 ledger.record(shim, wall_us, exit_code != 0)))
+      LOG(3) << "Could not record the invocation in " << file;
+  }
+
+  ~StatsReport() {
+    report();
+  }
+};
+
+
 // ----------------------------- Main Function ----------------------------- // 
-int ShimMain() {
-  DWORD exitCode            = 1;
+int ShimMain(wstring command_line) {
+  int exitCode              = 1;
+#if SHIM_TRACE
+  TRACECFG.enabled          = TraceRequested(command_line);
+#endif
+  TRACE("start");
   
   // --------------------- Get Command Line Arguments ---------------------- //
   filesystem::path thisExecPath  = GetExecPath();
-  wstring shimExe           = thisExecPath.filename().c_str();
+  wstring shimExe           = thisExecPath.filename().wstring();
   UpperCase(shimExe);
-  wstring shimDir           = thisExecPath.parent_path().c_str();
-  wstring currDir           = filesystem::current_path().c_str();
+  wstring shimDir           = thisExecPath.parent_path().wstring();
+  wstring currDir           = filesystem::current_path().wstring();
+  TRACE("exec_path");
 
-  wstring calling_cmd       = GetCommandLineW();
-  vector<wstring> arg_list  = ParseArguments(calling_cmd);
-  GetArgument(arg_list, 0, calling_cmd);
-      
-  bool shimArgLog           = GetShimArg(arg_list, L"l");    
-  bool shimArgWait          = GetShimArg(arg_list, L"w");
-  bool shimArgExit          = GetShimArg(arg_list, L"e");
-  bool isWindowsApp         = GetShimArg(arg_list, L"g");
-  bool shimArgUseTarget     = GetShimArg(arg_list, L"u");
-  bool shimArgNoop          = GetShimArg(arg_list, L"n");
+  ShimOptions options       = ParseShimOptions(command_line);
+  Release(command_line);
+
+  // Errors and warnings always reach the console, the rest only when asked
+  // for, so that a shim's output is the application's alone
+  if (!options.log && !options.noop)
+    LOGCFG.level            = 2;
 
   // If there still exists an argument starting with "--shim" and just run help 
-  if(GetArgument(arg_list, L"--shim.*")) ShowHelp();
+  if(options.help) ShowHelp();
+
+  // Trace either by flag or environment (leaving the command line untouched),
+  // no longer if TraceRequested only saw another --shim argument
+  wstring traceEnv;
+  TraceReport traceReport   = {shimExe};
+  TRACECFG.enabled          =
+    options.trace || GetEnvironmentValue(L"SHIM_TRACE", traceEnv);
+
+  // Profile the child to the log and / or append it to a sidecar file
+  wstring profileFile;
+  GetEnvironmentValue(L"SHIM_PROFILE_FILE", profileFile);
+
+  // Count the invocation in the shim's directory's ledger (or SHIM_STATS's)
+  wstring statsEnv;
+  StatsReport statsReport   =
+    {{}, NarrowString(thisExecPath.filename().wstring()), exitCode};
+  if (GetEnvironmentValue(L"SHIM_STATS", statsEnv)) {
+    error_code ec;
+    statsReport.file        = filesystem::is_directory(statsEnv, ec) ?
+      statsEnv : shimDir;
+    statsReport.file       /= STATS_FILE_NAME;
+  }
 
-  // Any arguments left, save to pass to parent executable
-  wstring calling_args      = CollapseArguments(arg_list);
+  // Optionally rotate the log file, i.e. SHIM_LOG_ROTATE=1M
+  wstring logRotate;
+  if (GetEnvironmentValue(L"SHIM_LOG_ROTATE", logRotate))
+    LOGCFG.rotate_size      = ParseSize(logRotate);
       
   // Print useful info
-  if (shimArgLog || shimArgNoop) {
+  if (options.log || options.noop) {
     LOG() << horizontal_line_bold;
     LOG() << shimExe << " - SHIM";
     LOG() << horizontal_line_bold;
@@ -246,154 +261,200 @@ int ShimMain() {
     LOG();
     
     LOG() << "Command Line Parameters:";
-    LOG() << "  GUI:          " << isWindowsApp; 
-    LOG() << "  Log:          " << shimArgLog  ; 
-    LOG() << "  NoOp:         " << shimArgNoop ;
-    LOG() << "  Exit:         " << shimArgExit ; 
-    LOG() << "  Wait:         " << shimArgWait ; 
-    LOG() << "  Use Target:   " << shimArgUseTarget;
-
-    if(calling_args.empty()) {
+    LOG() << "  GUI:          " << options.gui; 
+    LOG() << "  Log:          " << options.log; 
+    LOG() << "  NoOp:         " << options.noop;
+    LOG() << "  Exit:         " << options.exit; 
+    LOG() << "  Wait:         " << options.wait; 
+    LOG() << "  Use Target:   " << options.use_target;
+    LOG() << "  Trace:        " << TRACECFG.enabled;
+    LOG() << "  Profile:      " << options.profile;
+    LOG() << "  Relay:        " << options.relay;
+    LOG() << "  Tee:          " << options.tee;
+
+    if(options.calling_args.empty()) {
       LOG() << "  App Args:     "
             << "<NONE>";    }
     else {
       LOG() << "  App Args:     "
-            << "'" << calling_args << "'";
+            << "'" << options.calling_args << "'";
     }
     LOG();
   }
 
-  shimArgLog =  shimArgLog || shimArgNoop;    
-  shimArgExit = shimArgExit || isWindowsApp;
+  options.log   = options.log || options.noop;    
+  options.exit  = options.exit || options.gui;
 
-  if (shimArgExit && shimArgWait) {
+  if (options.exit && options.wait) {
     LOG(1) << "SHIM-WAIT cannot be used with SHIM-EXIT or SHIM-GUI";
     return exitCode;
   }
 
   
   // ------------------------- Get Exec Arguments -------------------------- // 
-  wstring appPath   = L"";
-  wstring appDir    = L"";
-  wstring appArgs   = L"";
-  wstring shimType  = L"";
+  ShimConfig config;
+  LoadShimConfig(config);
+  ReleaseResourceData();
   
-  if (!GetResourceData("SHIM_PATH", appPath)) {
-    LOG(1)  << "Shim has no application path. ";
-    LOG(-1) << "Shim is no longer valid and must be regenerated.";
-    return exitCode;
-  }
-  else if (!filesystem::exists(appPath)) {
-    LOG(1) << "Shim application path does not exist. ";
-    LOG(-1) << "Shim is no longer valid and must be regenerated.";
-    return exitCode;
-  }
-  else if (filesystem::equivalent(thisExecPath, appPath)) {
-    LOG(1) << "Shim points to itself. ";
+  if (const char* invalid = ValidateShimConfig(config, thisExecPath)) {
+    LOG(1)  << invalid;
     LOG(-1) << "Shim is no longer valid and must be regenerated.";
     return exitCode;
   }
   else
     exitCode = 0;
+  TRACE("validate");
 
-  appDir = filesystem::path(appPath).parent_path().c_str();
-  GetResourceData("SHIM_ARGS", appArgs);
-  GetResourceData("SHIM_TYPE", shimType);
+  LaunchPlan plan = ResolveLaunch(options, config, shimDir, currDir);
 
-  // Here forward we'll just use shimArgWait
-  if (shimType == L"CONSOLE")
-    shimArgWait = !shimArgExit;
+  // Tee the application's output into the shim's log file
+  if (options.tee) {
+    plan.tee_file = thisExecPath;
+    plan.tee_file.replace_extension(LOGCFG.file_ext);
+  }
 
   // Print useful info
-  if (shimArgLog) {
+  if (options.log) {
     LOG() << "Embedded Parameters:";
-    LOG() << "  Shim Type:    " << shimType; 
-    LOG() << "  App Name:     " << filesystem::path(appPath).stem();
-    LOG() << "  App Path:     " << "'" << appDir << "'";
-    if(appArgs.empty()) 
+    LOG() << "  Shim Type:    " << config.type; 
+    LOG() << "  App Name:     " << filesystem::path(config.path).stem();
+    LOG() << "  App Path:     " << filesystem::path(config.path).parent_path();
+    if(config.args.empty()) 
       LOG() << "  App Args:     " << "<NONE>";
     else 
-      LOG() << "  App Args:     " << "'" << appArgs << "'";
+      LOG() << "  App Args:     " << "'" << config.args << "'";
+    for (auto& o : plan.environment)
+      LOG() << "  App Env:      "
+            << (o.op == ENV_PREPEND ? "prepend " :
+                o.op == ENV_APPEND  ? "append "  : "set ")
+            << FromEnvString(o.name) << "=" << FromEnvString(o.value);
+    wistringstream sched(FormatSchedPolicy(plan.sched));
+    for (wstring line; getline(sched, line); )
+      LOG() << "  App Sched:    " << line;
+    if (!config.response.empty())
+      LOG() << "  App Response: " << "@FILE past "
+            << RESPONSE_COMMAND_LIMIT << " characters";
     LOG();
 
-    if (shimArgWait) {
+    if (plan.wait) {
       LOG(3) << "Waiting for process to finish ";
-      if (shimType == L"CONSOLE")
+      if (config.type == L"CONSOLE")
         LOG(-3) << "(default for CONSOLE shim)";
       else
         LOG(-3) << "(overridden for GUI shim)";
     }
     else {
       LOG(3) << "Exiting immediately once started ";
-      if (shimType == L"CONSOLE")
+      if (config.type == L"CONSOLE")
         LOG(-3) << "(overridden for CONSOLE shim)";
       else
         LOG(-3) << "(default for GUI shim)";
     }
     LOG();
   }
-
-  // Combine the calling and embedded arguments
-  if (!calling_args.empty() && !appArgs.empty())
-    appArgs += L" ";
-  appArgs += calling_args;
-
-  // for console application, set wd to where the shim was called from
-  wstring fallback_dir = shimType == L"CONSOLE" ? currDir : shimDir;
-
-  wstring working_dir = shimArgUseTarget ? appDir : fallback_dir;
   
   
+  // The plan holds the arguments from here on, so they are not kept twice
+  Release(options.calling_args);
+  Release(config.args);
+
+  // Hand the arguments too long for a command line over in a file, written
+  // straight from PLAN.ARGS, which then keeps only the rest
+  ResponseFile responseFile;
+  if (plan.response_at != wstring::npos && !options.noop) {
+    if (responseFile.write(plan.args, plan.response_at)) {
+      plan.args.resize(plan.response_at);
+      plan.args.shrink_to_fit();
+      plan.args += QuoteArgument(L"@" + responseFile.path().wstring());
+    }
+    else
+      LOG(2) << "Could not write a response file, passing the arguments "
+             << "on the command line";
+    TRACE("response_file");
+  }
   
   // ----------------------------- Execute App ----------------------------- //
-  if (shimArgLog) {
+  if (options.log) {
     LOG() << "Creating process for application";
-    LOG() << "  APP: " << "'" << appPath << "'";
-    LOG() << "  ARG: " << "'" << appArgs << "'";
-    LOG() << "  DIR: " << "'" << working_dir << "'";
+    LOG() << "  APP: " << "'" << plan.path << "'";
+    LOG() << "  ARG: " << "'" << plan.args << "'";
+    LOG() << "  DIR: " << "'" << plan.working_dir << "'";
     LOG() << horizontal_line;
   }
   
-  if (shimArgNoop) {
+  if (options.noop) {
     LOG() << "Shim Exiting: NoOp";
     LOG() << horizontal_line;
     return exitCode;
   }
   
-  auto [processHandle, threadHandle] =
-    MakeProcess(move(appPath), move(appArgs), working_dir);
+  // Exec'ing replaces the shim, so whatever it writes on exit is written now
+  if (LAUNCH_REPLACES_SHIM && !plan.wait) {
+    if (options.log) {
+      LOG() << "Shim Exiting: exec";
+      LOG() << horizontal_line;
+    }
+    traceReport.report();
+    statsReport.report(true);
+  }
   
-  exitCode = processHandle ? 0 : 1;
+  bool profile = options.profile || !profileFile.empty();
 
-  // Wait for app to finish when
-  if (processHandle && shimArgWait) {
-    // A job object allows groups of processes to be managed as a unit.
-    // Operations performed on a job object affect all processes associated with
-    // the job object. Specifically here we attach to child processes to make
-    // sure they terminate when the parent terminates as well.   
-    unique_handle jobHandle(CreateJobObject(nullptr, nullptr));
-    JOBOBJECT_EXTENDED_LIMIT_INFORMATION jobInfo = {};
-
-    jobInfo.BasicLimitInformation.LimitFlags = 
-      JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE |
-      JOB_OBJECT_LIMIT_SILENT_BREAKAWAY_OK;
-    
-    SetInformationJobObject(
-      jobHandle.get(),
-      JobObjectExtendedLimitInformation,
-      &jobInfo,
-      sizeof(jobInfo));
-    
-    AssignProcessToJobObject(jobHandle.get(), processHandle.get());
-    
-    // Wait till end of process
-    WaitForSingleObject(processHandle.get(), INFINITE);
+  auto launchTime = chrono::steady_clock::now();
+  ChildProcess child;
+  bool launched = LaunchProcess(plan, child);
+  
+  exitCode = launched ? 0 : 1;
+
+  // Not waiting, the application may read its response file after the shim
+  // has gone (left in the temporary directory)
+  if (launched && !plan.wait)
+    responseFile.keep();
 
-    // Get the exit code
-    GetExitCodeProcess(processHandle.get(), &exitCode);
+  // Wait for app to finish when
+  if (launched && plan.wait) {
+    // Nothing but the child is needed from here on, so give back what the
+    // shim holds before what may be a long wait: the plan with its
+    // environment and scheduling policy, the configuration, the paths and
+    // settings read from the environment, and the log's buffer (the relay's
+    // buffers being in use, and only committed as they are written)
+    Release(plan);
+    Release(config);
+    Release(options.relay_host);
+    Release(thisExecPath);
+    Release(shimDir);
+    Release(currDir);
+    Release(traceEnv);
+    Release(statsEnv);
+    Release(logRotate);
+    LOGSTREAM.flush();
+    TrimMemory();
+    TRACE("release");
+
+    ProcessAccounting accounting;
+    exitCode = WaitProcess(child, profile ? &accounting : nullptr);
+
+    // Report the resources used by the whole process tree
+    if (profile) {
+      accounting.wall_us    = chrono::duration_cast<chrono::microseconds>(
+          chrono::steady_clock::now() - launchTime).count();
+
+      string report = FormatAccounting(NarrowString(shimExe), exitCode,
+                                       accounting);
+      if (options.profile)
+        LOG() << report;
+      
+      if (!profileFile.empty()) {
+        LogSink sidecar;
+        sidecar.setFile(profileFile);
+        sidecar.write(report + "\n");
+      }
+    }
   }
+  else if (launched && profile)
+    LOG(2) << "Profiling requires the shim to wait for the process";
 
-  if (shimArgLog) {
+  if (options.log) {
     LOG() << "Shim Exiting: " << exitCode;
     LOG() << horizontal_line;
   }
@@ -402,14 +463,27 @@ int ShimMain() {
 }
 
 
+#ifdef _WIN32
 // Console Application Entry Point
 int wmain(int argc, wchar_t* argv[]) {
-  return ShimMain();
+  return ShimMain(GetCommandLineW());
 }
 
 // GUI Application Entry Point
 int APIENTRY wWinMain(
     HINSTANCE hInst, HINSTANCE hInstPrev,
     PWSTR pCmdLine, int nCmdShow) {
-  return ShimMain();
+  return ShimMain(GetCommandLineW());
+}
+
+#else
+// POSIX Entry Point, rebuilding a command line to parse as on Windows
+int main(int argc, char* argv[]) {
+  vector<wstring> args;
+  for (int i = 0; i < argc; i++)
+    args.push_back(WidenString(argv[i]));
+  wstring command_line = JoinArguments(args);
+  Release(args);
+  return ShimMain(move(command_line));
 }
+#endif
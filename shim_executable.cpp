@@ -26,16 +26,352 @@
 #include <log.h>
 #include <resource_functions.h>
 #include <get_argument.h>
+#include <environment.h>
+#include <schedule.h>
+#include <stats_ledger.h>
+#include <metrics.h>
+#include <atomic_file.h>
+#include <manifest.h>
+#include <watch.h>
+#include <response_file.h>
 #include <utility_functions.h>
 
+#ifdef _WIN32
 #pragma comment(lib, "SHELL32.LIB")
+#else
+#include <unistd.h>
+#include <elf_config.h>
+#endif
 
 
 // ----------------- Unpack the Shim from this Application ----------------- // 
+#ifdef _WIN32
 BOOL UnpackShim(const filesystem::path& path, wstring shim_type) {
   return GetResourceFile("SHIM_" + NarrowString(shim_type), path);
 }
 
+#else
+// The ELF shim template (bin/shim), linked in by the GNUmakefile. There is a
+// single template as GUI and CONSOLE shims only differ by their SHIM_TYPE.
+#ifndef SHIM_TEMPLATE
+#define SHIM_TEMPLATE "bin/shim"
+#endif
+
+asm(".section .rodata\n"
+    ".balign 16\n"
+    "shim_template_start:\n"
+    ".incbin \"" SHIM_TEMPLATE "\"\n"
+    "shim_template_end:\n"
+    ".previous\n");
+extern "C" const char shim_template_start[], shim_template_end[];
+
+// SHIM_TYPE is for Windows' two templates, this one serving both. The shim
+// is only created here, executable and empty, the template being copied into
+// it along with its configuration once that is known (see ShimTemplate).
+bool UnpackShim(const filesystem::path& path,
+                [[maybe_unused]] wstring shim_type) {
+  ofstream file(path, ios::out | ios::binary | ios::trunc);
+  file.close();
+  if (!file)
+    return false;
+
+  error_code ec;
+  filesystem::permissions(
+      path,
+      filesystem::perms::owner_all |
+      filesystem::perms::group_read | filesystem::perms::group_exec |
+      filesystem::perms::others_read | filesystem::perms::others_exec,
+      ec);
+  return !ec;
+}
+
+// The template, read where it is linked in
+MemoryStream& ShimTemplate() {
+  static MemoryStream image(shim_template_start,
+                            shim_template_end - shim_template_start);
+  return image;
+}
+#endif
+
+
+// ------------------------- Summarize Statistics -------------------------- // 
+int ShowStats(const filesystem::path& dir) {
+  StatsLedger ledger;
+  if (!ledger.open(dir / STATS_FILE_NAME, false)) {
+    LOG(1) << "No stats ledger in " << dir;
+    return 1;
+  }
+
+  vector<StatsRecord> records = ledger.records();
+  cout << FormatStatsTable(records);
+  if (records.empty())
+    cout << "(no shim has been run with SHIM_STATS set)" << endl;
+  return 0;
+}
+
+
+// --------------------------- Verify Manifest ----------------------------- // 
+int VerifyShims(const filesystem::path& manifest, const filesystem::path& dir) {
+  ifstream file(manifest, ios::binary);
+  if (!file) {
+    LOG(1) << "Could not read the manifest " << manifest;
+    return 1;
+  }
+  vector<ManifestEntry> entries = ParseManifest(
+      string(istreambuf_iterator<char>(file), istreambuf_iterator<char>()));
+
+  vector<const char*> problems = VerifyManifest(entries, dir);
+  size_t failed = 0;
+  for (size_t i = 0; i < entries.size(); i++)
+    if (problems[i]) {
+      failed++;
+      cout << entries[i].shim << ": " << problems[i] << endl;
+    }
+  cout << entries.size() - failed << " of " << entries.size()
+       << " shim(s) match " << manifest.filename() << endl;
+  return failed ? 1 : 0;
+}
+
+
+// -------------------------------- Options -------------------------------- // 
+// What a shim is made with, as parsed from the command line
+struct ShimExecOptions {
+  wstring           exec_name;          // of this executable, upper case
+  filesystem::path  exec_dir;
+  filesystem::path  curr_dir;
+  bool              is_shimgen =    false;
+  wstring           input;
+  wstring           output;
+  wstring           icon;
+  wstring           command_args;
+  wstring           shim_type;
+  vector<wstring>   env;
+  SchedPolicy       sched;
+  IconPolicy        icon_policy;
+  bool              sync =          false;
+  bool              response_file = false;
+  bool              debug =         false;
+  filesystem::path  metrics_file;       // empty unless --metrics is given
+  filesystem::path  manifest_path;      // empty unless --manifest is given
+};
+
+int CreateShim(ShimExecOptions options);
+
+
+// ------------------------------ Watch Mode ------------------------------- // 
+
+// The target a shim was made for, FALSE if PATH is not a shim
+bool ReadShimTarget(const filesystem::path& path, filesystem::path& target) {
+  wstring value;
+#ifdef _WIN32
+  ifstream           file(path, ios::binary);
+  vector<PeResource> resources;
+  if (!ReadPeResources(file, resources))
+    return false;
+  for (auto& r : resources) {
+    string data;
+    if (r.type != PE_RT_RCDATA || r.name != L"SHIM_PATH" ||
+        !ReadPeResource(file, r, data))
+      continue;
+    value.resize(data.size() / sizeof(wchar_t));
+    memcpy(&value[0], data.data(), value.size() * sizeof(wchar_t));
+    break;
+  }
+#else
+  string text;
+  if (!ReadElfConfig(path, text))
+    return false;
+  value = ParseResourceText(text)["path"];
+#endif
+  target = value;
+  return !value.empty();
+}
+
+// An executable to shim, on Windows an .exe
+bool IsShimTarget(const filesystem::path& path) {
+  error_code ec;
+  if (!filesystem::is_regular_file(path, ec))
+    return false;
+#ifdef _WIN32
+  wstring extension = path.extension().wstring();
+  UpperCase(extension);
+  return extension == L".EXE";
+#else
+  return access(path.c_str(), X_OK) == 0;
+#endif
+}
+
+bool IsUnder(const filesystem::path& path, const filesystem::path& dir) {
+  filesystem::path relative = path.lexically_relative(dir);
+  return !relative.empty() && *relative.begin() != ".." &&
+    relative != ".";
+}
+
+
+// Keeps a shim in OUTPUT of every executable under ROOT, made as the
+// generator makes one (with OPTIONS, but for its paths) and removed once the
+// executable is gone.
+// Shims are named after their executable, and a file in OUTPUT that is not a
+// shim of it is never replaced.
+class ShimSync {
+public:
+  ShimSync(const filesystem::path& root, const filesystem::path& output,
+           const ShimExecOptions& options)
+    : root(root), output(output), options(options) {}
+
+  // The shims already in OUTPUT of executables under ROOT
+  void index() {
+    error_code ec;
+    filesystem::path target;
+    for (filesystem::directory_iterator it(output, ec), end;
+         !ec && it != end; it.increment(ec))
+      if (it->is_regular_file(ec) && ReadShimTarget(it->path(), target) &&
+          IsUnder(target, root))
+        shims[target] = it->path();
+  }
+
+  // Bring the shims of PATH, or of everything under it, up to date
+  void sync(const filesystem::path& path) {
+    if (path == output || IsUnder(path, output))
+      return;
+
+    error_code ec;
+    if (filesystem::is_directory(path, ec)) {
+      for (filesystem::recursive_directory_iterator it(
+               path, filesystem::directory_options::skip_permission_denied,
+               ec), end; !ec && it != end; it.increment(ec))
+        if (it->path() == output)
+          it.disable_recursion_pending();
+        else if (IsShimTarget(it->path()))
+          update(it->path());
+    }
+    else if (IsShimTarget(path))
+      update(path);
+
+    // Those gone, or no longer executable
+    vector<filesystem::path> gone;
+    for (auto& [target, shim] : shims)
+      if ((target == path || IsUnder(target, path)) && !IsShimTarget(target))
+        gone.push_back(target);
+    for (auto& target : gone)
+      remove(target);
+  }
+
+private:
+  filesystem::path  root;
+  filesystem::path  output;
+  ShimExecOptions   options;
+  map<filesystem::path, filesystem::path> shims;    // by target
+
+  void update(const filesystem::path& target) {
+    filesystem::path shim = output / target.filename();
+    filesystem::path owner;
+    error_code       ec;
+    if (filesystem::exists(shim, ec)) {
+      if (!ReadShimTarget(shim, owner) || owner != target) {
+        LOG(2) << shim << " is not a shim of " << target << ", left as is";
+        return;
+      }
+      auto made = filesystem::last_write_time(shim, ec);
+      if (!ec && made >= filesystem::last_write_time(target, ec) && !ec) {
+        shims[target] = shim;
+        return;
+      }
+    }
+
+    ShimExecOptions shim_options = options;
+    shim_options.input  = target.wstring();
+    shim_options.output = shim.wstring();
+    CreateShim(shim_options);
+    if (ReadShimTarget(shim, owner) && owner == target)
+      shims[target] = shim;
+  }
+
+  void remove(const filesystem::path& target) {
+    filesystem::path shim = shims[target];
+    filesystem::path owner;
+    error_code       ec;
+    shims.erase(target);
+    if (!ReadShimTarget(shim, owner) || owner != target)
+      return;
+    if (filesystem::remove(shim, ec))
+      LOG() << "Removed " << shim << ", as " << target << " is gone";
+    else
+      LOG(1) << "Could not remove " << shim;
+  }
+};
+
+
+/**@brief  Keep the shims of OUTPUT in step with the executables under ROOT
+ *         until stopped (see WATCH.H)
+ *
+ * @param  OPTIONS: for every shim made (e.g. --gui or --metrics FILE), its
+ *                  INPUT and OUTPUT aside
+ *
+ * @return only if ROOT can no longer be watched
+ */
+int WatchShims(const filesystem::path& root, const filesystem::path& output,
+               const ShimExecOptions& options) {
+  if (!filesystem::is_directory(root) || !filesystem::is_directory(output)) {
+    LOG(1) << "--watch needs an existing DIR and OUTPUT directory";
+    return 1;
+  }
+
+  // Watched first, so nothing changing meanwhile is missed
+  DirectoryWatcher watcher;
+  if (!watcher.open(root)) {
+    LOG(1) << "Could not watch " << root;
+    return 1;
+  }
+  ShimSync shims(root, output, options);
+  shims.index();
+  shims.sync(root);
+  LOG() << "Watching " << root << " for changes to the shims in " << output;
+
+  ChangeCoalescer          changes;
+  vector<filesystem::path> changed;
+  bool                     all;
+  for (;;) {
+    chrono::milliseconds timeout(-1);
+    if (changes.pending())
+      timeout = max(chrono::milliseconds(0),
+                    chrono::ceil<chrono::milliseconds>(
+                        changes.due() - chrono::steady_clock::now()));
+    if (!watcher.wait(timeout, changes)) {
+      LOG(1) << "Stopped watching " << root;
+      return 1;
+    }
+
+    if (!changes.take(chrono::steady_clock::now(), changed, all))
+      continue;
+    if (all)
+      shims.sync(root);
+    for (auto& path : changed)
+      shims.sync(path);
+  }
+}
+
+
+// ---------------------------- Report Metrics ----------------------------- // 
+// Adds the run to --metrics FILE however CreateShim returns
+struct MetricsReport {
+  filesystem::path  file;               // empty unless --metrics is given
+  GeneratorMetrics  metrics;
+  const char*       result =        nullptr;    // created or updated
+  const char*       error =         nullptr;    // cause of skipping
+
+  ~MetricsReport() {
+    if (file.empty() || (!result && !error))
+      return;
+
+    metrics.addResult(error ? "skipped" : result);
+    if (error)
+      metrics.addError(error);
+    if (!metrics.merge(file))
+      LOG(2) << "Could not write metrics to " << file;
+  }
+};
+
 
 // ----------------------------- Help Message ------------------------------ // 
 void ShowHelp(string exec_name, bool is_shimgen) {
@@ -197,11 +533,61 @@ will be assumed to be OUTPUT.
   help_text = R"V0G0N(
     --command ARGS      Additional arguments the shim should pass to the
                             original executable automatically. Should be quoted
-                            for multiple arguments.
-
-    --iconpath ICON     [UNIMPLEMENTED] Path to a file to use for the shim's
-                            icon. By default, the executable's icon resources
-                            are used.
+                            for multiple arguments. As @FILE they are read
+                            from FILE instead (UTF-8, its lines joined by
+                            spaces), for those too long for a command line;
+                            @@ starts them with a literal @.
+
+    --response-file     The executable reads its arguments from @FILE (as
+                            compilers and linkers do). The shim then passes
+                            arguments past 32,767 characters, the most a
+                            Windows command line holds, in a temporary file
+                            as @FILE: those it was called with, or all of
+                            them if the --command ones alone are too long.
+
+    --iconpath ICON     An icon to use for the shim instead of the
+                            executable's: an .ico file, or an executable or
+                            DLL and the index of its icon as PATH,INDEX (the
+                            first if not given, or its ID if negative). This
+                            is expanded as PATH is.
+
+    --icon-sizes PX,... Copies only the icon images of these sizes, e.g.
+                            16,32,48,256 (256 for 256 px or more). A group
+                            without any keeps its largest image.
+
+    --icon-depths BITS,...
+                        Copies only the icon images of these bit depths,
+                            e.g. 32, as --icon-sizes.
+
+    --icon-limit SIZE   Drops the largest icon images, e.g. 256 px PNGs,
+                            until the icons take at most SIZE (e.g. 64K),
+                            though every group keeps one. Identical images
+                            are always copied once, however many groups or
+                            languages have them.
+
+    --env NAME=VALUE    Sets an environment variable for the application,
+                            or removes it if VALUE is empty. Quote VALUE if
+                            it has spaces. Can be given more than once.
+
+    --env-prepend NAME=VALUE
+    --env-append NAME=VALUE
+                        Adds VALUE to the front or end of a list variable
+                            such as PATH, separated as PATH is on the
+                            platform. Applied after any --env of the same
+                            NAME, in the order given.
+
+    --affinity CPUS     Runs the application only on the given CPUs, a list
+                            such as 0-3,6.
+
+    --priority CLASS    Runs the application at the priority class idle,
+                            below, normal, above or high.
+
+    --memory-limit SIZE Caps the memory the application may commit, e.g. 512M
+                            or 2G. On Windows the cap covers the whole process
+                            tree, elsewhere each process.
+
+    --cpu-rate PERCENT  Caps the application's process tree to PERCENT of the
+                            machine's CPU time (Windows only).
 
     --gui               Explicitly sets shim to be created using the GUI or
     --console               console subsystem. GUI shims exit as soon as the
@@ -211,6 +597,48 @@ will be assumed to be OUTPUT.
                             executable, thus these options likely would be need
                             only for special cases.
 
+    --stats DIR         Summarizes the stats ledger shims run with SHIM_STATS
+                            keep in DIR (see the shim's help): calls, failures,
+                            total and mean wall time, its 50th, 90th and 99th
+                            percentiles (to within a factor of two), and when
+                            each was last used. Nothing else is done.
+
+    --metrics FILE      Adds this run to FILE in the OpenMetrics text format
+                            (e.g. for a node exporter's textfile collector):
+                            shims created, updated and skipped, bytes read and
+                            written, errors by cause, and a histogram of the
+                            time spent in each phase. Runs at the same time
+                            are merged safely.
+
+    --manifest FILE     Adds the shim to FILE, a line each of its SHA-256,
+                            size, path and target (tab separated), replacing
+                            any line it had. The digest is taken as the shim
+                            is written. Runs at the same time are merged
+                            safely.
+
+    --verify MANIFEST [DIR]
+                        Checks the shims in MANIFEST (or those of the same
+                            names in DIR) still match it, hashing several at
+                            once, and lists those that do not. Nothing else is
+                            done.
+
+    --watch DIR         Keeps a shim in OUTPUT (which must be given, e.g.
+                            --output BIN) of every executable under DIR until
+                            stopped. Shims are made as they would be one at a
+                            time, with the other options given, once changes
+                            settle (no change for half a second, or five
+                            seconds at most), and removed once their
+                            executable is gone. A file in OUTPUT that is not
+                            a shim of the executable of its name is left
+                            alone.
+
+    --fsync             Flushes the shim to disk before it replaces OUTPUT,
+                            and the rename after, so it survives a crash of
+                            the system. The flushes of runs at the same time
+                            in the same directory are shared. Either way,
+                            OUTPUT is only replaced once the new shim is
+                            complete.
+
     --debug             Print additional information when creating the shim to
                             the console.
 )V0G0N";
@@ -223,33 +651,24 @@ will be assumed to be OUTPUT.
 // ------------------------------------------------------------------------- //
 // MAIN METHOD                                                               // 
 // ------------------------------------------------------------------------- //
-int wmain(int argc, wchar_t* argv[], wchar_t* envp[]) {
-  int exitcode              = 1;
-
+int ShimExecMain(wstring calling_cmd) {
   // ----------------------------------------------------------------------- //
   // Get Command Line Arguments                                              // 
   // ----------------------------------------------------------------------- //
+  ShimExecOptions options;
   filesystem::path thisExecPath  = GetExecPath();
-  wstring exec_name         = thisExecPath.stem().c_str();
-  UpperCase(exec_name);
-  filesystem::path exec_dir = thisExecPath.parent_path();
-  filesystem::path curr_dir = filesystem::current_path();
+  options.exec_name         = thisExecPath.stem().wstring();
+  UpperCase(options.exec_name);
+  options.exec_dir          = thisExecPath.parent_path();
+  options.curr_dir          = filesystem::current_path();
 
   // The original SHIMGEN.EXE worked slightly different, so by simply having the
   // executable named as such, we'll handle the magic for the user
-  bool is_shimgen           = exec_name.compare(L"SHIMGEN") == 0;
+  options.is_shimgen        = options.exec_name.compare(L"SHIMGEN") == 0;
 
-  wstring calling_cmd       = GetCommandLineW();
   vector<wstring> arg_list  = ParseArguments(calling_cmd);
   GetArgument(arg_list, 0, calling_cmd);
 
-  wstring output            = L"";
-  wstring input             = L"";
-  wstring icon              = L"";
-  wstring command_args      = L"";
-  wstring shim_type         = L"";
-  bool debug                = false;
-
   
   // -------------------------- //
   // Standard SHIMGEN Arguments //
@@ -257,48 +676,165 @@ int wmain(int argc, wchar_t* argv[], wchar_t* envp[]) {
   // Help
   //   -?, --help, -h
   if(GetArgument(arg_list, L"-(\\?|h|-help)"))
-    ShowHelp(NarrowString(exec_name), is_shimgen);
+    ShowHelp(NarrowString(options.exec_name), options.is_shimgen);
+
+  // Summarize a stats ledger, and nothing else
+  //       --stats=DIR
+  wstring stats_dir;
+  if(GetArgument(arg_list, L"--stats", stats_dir)) {
+    TrimQuotes(stats_dir);
+    return ShowStats(stats_dir);
+  }
+
+  // Check shims against a manifest, and nothing else
+  //       --verify=MANIFEST [DIR]
+  wstring verify_file, verify_dir;
+  if(GetArgument(arg_list, L"--verify", verify_file)) {
+    ReparseArguments(arg_list);
+    GetArgument(arg_list, 0, verify_dir);
+    TrimQuotes(verify_file);
+    TrimQuotes(verify_dir);
+    return VerifyShims(verify_file, verify_dir);
+  }
+
+  // Keep the shims of OUTPUT in step with the executables under DIR, the
+  // other options being those every shim is made with (see below)
+  //       --watch=DIR --output=OUTPUT
+  wstring watch_dir;
+  bool watch = GetArgument(arg_list, L"--watch", watch_dir);
+
+  // Metrics of each run, added to those in the file
+  //       --metrics=FILE
+  wstring metrics_file;
+  if(GetArgument(arg_list, L"--metrics", metrics_file)) {
+    TrimQuotes(metrics_file);
+    options.metrics_file = filesystem::absolute(metrics_file);
+  }
+
+  // Manifest of the shims created, added to
+  //       --manifest=FILE
+  wstring manifest_file;
+  if(GetArgument(arg_list, L"--manifest", manifest_file)) {
+    TrimQuotes(manifest_file);
+    options.manifest_path = filesystem::absolute(manifest_file);
+  }
 
   // Get Input Path
   //   -p, --path=VALUE
-  GetArgument(arg_list, L"-(p|-path)", input);
+  if (!watch)
+    GetArgument(arg_list, L"-(p|-path)", options.input);
   
   // Get Output Path  
   //   -o, --output=VALUE
-  GetArgument(arg_list, L"-(o|-output)", output);
+  GetArgument(arg_list, L"-(o|-output)", options.output);
   
   // Get Additional Arguments for Application             
   //   -c, --command=VALUE
-  GetArgument(arg_list, L"-(c|-command)", command_args);
+  GetArgument(arg_list, L"-(c|-command)", options.command_args);
 
   // Get Icon Path             
   //   -i, --iconpath=VALUE
-  GetArgument(arg_list, L"-(i|-iconpath)", icon);
+  GetArgument(arg_list, L"-(i|-iconpath)", options.icon);
   
+  // Environment Overrides
+  //       --env=NAME=VALUE, --env-prepend=NAME=VALUE, --env-append=NAME=VALUE
+  // sets first, so the others always build on them
+  for (auto [flag, op] : {pair(L"--env", ENV_SET),
+                          pair(L"--env-prepend", ENV_PREPEND),
+                          pair(L"--env-append", ENV_APPEND)}) {
+    wstring setting;
+    while(GetSettingArgument(arg_list, flag, setting)) {
+      TrimQuotes(setting);
+      size_t eq = setting.find(L'=');
+      if (eq != wstring::npos && eq + 1 < setting.size()) {
+        wstring value = setting.substr(eq + 1);
+        TrimQuotes(value);
+        setting = setting.substr(0, eq + 1) + UnquoteString(value);
+      }
+
+      wstring line = FormatEnvOverride(op, setting);
+      if (line.empty())
+        LOG(2) << "Ignoring " << flag << " without NAME=VALUE: " << setting;
+      else
+        options.env.push_back(line);
+    }
+  }
+
+  // Scheduling Policy
+  //       --affinity=CPUS, --priority=CLASS, --memory-limit=SIZE,
+  //       --cpu-rate=PERCENT
+  for (auto [flag, key] : {pair(L"--affinity", L"affinity"),
+                           pair(L"--priority", L"priority"),
+                           pair(L"--memory-limit", L"memory"),
+                           pair(L"--cpu-rate", L"cpu")}) {
+    wstring setting;
+    if(GetArgument(arg_list, flag, setting)) {
+      TrimQuotes(setting);
+      if (!SetSchedSetting(options.sched, key, setting))
+        LOG(2) << "Ignoring invalid " << flag << ": " << setting;
+    }
+  }
+#ifndef _WIN32
+  if (options.sched.cpu_rate)
+    LOG(2) << "--cpu-rate is only applied by Windows shims";
+#endif
+
+  // Icon Policy
+  //       --icon-sizes=PX,..., --icon-depths=BITS,..., --icon-limit=SIZE
+  for (auto [flag, list] : {pair(L"--icon-sizes", &options.icon_policy.sizes),
+                            pair(L"--icon-depths", &options.icon_policy.depths)}) {
+    wstring setting;
+    if(GetArgument(arg_list, flag, setting)) {
+      TrimQuotes(setting);
+      if (!ParseIconList(setting, *list))
+        LOG(2) << "Ignoring invalid " << flag << ": " << setting;
+    }
+  }
+  wstring icon_limit;
+  if(GetArgument(arg_list, L"--icon-limit", icon_limit)) {
+    TrimQuotes(icon_limit);
+    options.icon_policy.max_bytes = ParseSize(icon_limit);
+    if (!options.icon_policy.max_bytes)
+      LOG(2) << "Ignoring invalid --icon-limit: " << icon_limit;
+  }
+#ifndef _WIN32
+  if (!options.icon_policy.sizes.empty() || !options.icon_policy.depths.empty() ||
+      options.icon_policy.max_bytes)
+    LOG(2) << "Icon options only apply to Windows shims";
+#endif
+
   // Force GUI
   //       --gui
   if(GetArgument(arg_list, L"--gui"))
-    shim_type = L"GUI";
+    options.shim_type = L"GUI";
   
+  // Flush to Disk
+  //       --fsync
+  options.sync = GetArgument(arg_list, L"--fsync");
+
+  // Target Reads @FILE
+  //       --response-file
+  options.response_file = GetArgument(arg_list, L"--response-file");
+
   // Debug Info
   //       --debug
-  debug = GetArgument(arg_list, L"--debug");
-  if (!debug) LOGCFG.level = 1;
+  options.debug = GetArgument(arg_list, L"--debug");
+  if (!options.debug) LOGCFG.level = 1;
   else LOGCFG.level = 3;      // ignore level 4+
 
   
   // ------------------------------------------ //
   // Supplemental Arguments and Passing Methods //
   // ------------------------------------------ //
-  if(!is_shimgen) {
+  if(!options.is_shimgen) {
     // Force Console 
     //       --console
     // since GUI and CONSOLE shims are significantly different than those
     // created by SHIMGEN, this allows forcing GUI apps to use the CONSOLE shim
     // if needed 
     if(GetArgument(arg_list, L"--console")) {
-      if(shim_type.empty())
-        shim_type = L"CONSOLE";
+      if(options.shim_type.empty())
+        options.shim_type = L"CONSOLE";
       else {
         LOG(2) << "CONSOLE and GUI flags cannot be used together,";
         LOG(-2) << "assuming GUI was intended";
@@ -307,76 +843,107 @@ int wmain(int argc, wchar_t* argv[], wchar_t* envp[]) {
 
     // Additional Input Path Methods
     //   --input=VALUE
-    if(input.empty())
-      GetArgument(arg_list, L"--input", input);
+    if(options.input.empty() && !watch)
+      GetArgument(arg_list, L"--input", options.input);
     //   ... or if all else fails, use the first argument
-    if(input.empty()) {
+    if(options.input.empty() && !watch) {
       ReparseArguments(arg_list);
-      GetArgument(arg_list, 0, input);
+      GetArgument(arg_list, 0, options.input);
     }
   
     // Additital Output Path Method  
     // technically we have parsed all the valid arguments, so we'll assume if
     // there is one left, it is the output path 
-    if(output.empty()) {
+    if(options.output.empty()) {
       ReparseArguments(arg_list);
-      GetArgument(arg_list, 0, output);
+      GetArgument(arg_list, 0, options.output);
     }
   }
 
-  if (!CollapseArguments(arg_list).empty()) {
+  // Whitespace alone is not an argument
+  ReparseArguments(arg_list);
+  if (!arg_list.empty()) {
     LOG(2) << "Additional arguments ignored: ";
     LOG(-2) << CollapseArguments(arg_list);
   }
   
-  TrimQuotes(input);
-  TrimQuotes(output);
-  TrimQuotes(icon);
-  TrimQuotes(command_args);
-  command_args = UnquoteString(command_args);
+  TrimQuotes(options.input);
+  TrimQuotes(options.output);
+  TrimQuotes(options.icon);
+  TrimQuotes(options.command_args);
+  options.command_args = UnquoteString(options.command_args);
 
   // Debug Info
-  LOG(4) << "exec_name:       " << exec_name;
-  LOG(4) << "exec_dir:        " << exec_dir;
-  LOG(4) << "curr_dir:        " << curr_dir;
-  LOG(4) << "is_shimgen:      " << is_shimgen;
+  LOG(4) << "exec_name:       " << options.exec_name;
+  LOG(4) << "exec_dir:        " << options.exec_dir;
+  LOG(4) << "curr_dir:        " << options.curr_dir;
+  LOG(4) << "is_shimgen:      " << options.is_shimgen;
+  for (auto& line : options.env)
+    LOG(4) << "env:             " << line;
+  LOG(4) << "sched:           " << FormatSchedPolicy(options.sched);
    
-  LOG(4) << "output:          " << output;
-  LOG(4) << "input:           " << input;
-  LOG(4) << "icon:            " << icon;
-  LOG(4) << "command_args:    " << command_args;
-  LOG(4) << "shim_type:       " << shim_type;
-  LOG(4) << "debug:           " << debug;
+  LOG(4) << "output:          " << options.output;
+  LOG(4) << "input:           " << options.input;
+  LOG(4) << "icon:            " << options.icon;
+  LOG(4) << "command_args:    " << options.command_args;
+  LOG(4) << "shim_type:       " << options.shim_type;
+  LOG(4) << "sync:            " << options.sync;
+  LOG(4) << "response_file:   " << options.response_file;
+  LOG(4) << "debug:           " << options.debug;
+
+  if (watch) {
+    TrimQuotes(watch_dir);
+    return WatchShims(
+        filesystem::weakly_canonical(options.curr_dir / watch_dir),
+        filesystem::weakly_canonical(options.curr_dir / options.output),
+        options);
+  }
+  return CreateShim(options);
+}
+
+
+/**@brief  Make the shim OPTIONS describe
+ *
+ * @return exit code of the generator
+ */
+int CreateShim(ShimExecOptions options) {
+  int exitcode              = 1;
+
+  // Metrics of this run, added to those in the file
+  MetricsReport report;
+  report.file = options.metrics_file;
 
 
   // ----------------------------------------------------------------------- //
   // Validate / Transform Arguments                                          // 
   // ----------------------------------------------------------------------- //
-  filesystem::path input_path =     input;
-  filesystem::path output_path =    output;
+  filesystem::path input_path =     options.input;
+  filesystem::path output_path =    options.output;
 
   // Check if INPUT is  EMPTY
-  if (input.empty()) {
+  if (options.input.empty()) {
     LOG(1) << "SOURCE executable must be specified.";
+    report.error = "no_source";
     return exitcode;
   }
 
   // ---------- Expand Paths ---------- // 
   // NOTE: SHIMGEN requires OUTPUT to be explicitly given and possibly relative
   // to this EXECUTABLE. INPUT then can be relative to the OUTPUT. 
-  if(is_shimgen) {
+  if(options.is_shimgen) {
     // Check if OUTPUT is EMPTY
-    if (output.empty()) {
+    if (options.output.empty()) {
       LOG(1) << "OUTPUT path must be specified.";
+      report.error = "no_output";
       return exitcode;
     }
 
     // Expand OUTPUT from EXEC_DIR if necessary 
     if (output_path.is_relative()) {
       LOG(3) << "OUTPUT path is relative, expanding from "
-             << exec_name << " path";
-      LOG(-4) << exec_dir;
-      output_path = exec_dir / output_path;
+             << options.exec_name << " path";
+      LOG(-4) << options.exec_dir;
+      output_path = options.exec_dir / output_path;
       output_path = filesystem::weakly_canonical(output_path);
     }
     
@@ -394,13 +961,13 @@ int wmain(int argc, wchar_t* argv[], wchar_t* envp[]) {
     // Expand INPUT if necessary 
     if (input_path.is_relative()) {
       LOG(3) << "SOURCE path is relative, expanding from CURRENT path";
-      LOG(-4)  << curr_dir;
-      input_path = filesystem::weakly_canonical(curr_dir / input_path);
+      LOG(-4)  << options.curr_dir;
+      input_path = filesystem::weakly_canonical(options.curr_dir / input_path);
     }
 
     // Check if OUTPUT is empty
-    if (output.empty()) {
-      output_path = curr_dir;
+    if (options.output.empty()) {
+      output_path = options.curr_dir;
       LOG(2) << "OUTPUT path was not specified, using CURRENT path";
       LOG(-4) << output_path;
     }
@@ -408,8 +975,8 @@ int wmain(int argc, wchar_t* argv[], wchar_t* envp[]) {
     // Expand OUTPUT if necessary
     if (output_path.is_relative()) {
       LOG(3) << "OUTPUT path is relative, expanding from CURRENT path";
-      LOG(-4) << curr_dir;
-      output_path = filesystem::weakly_canonical(curr_dir / output_path);
+      LOG(-4) << options.curr_dir;
+      output_path = filesystem::weakly_canonical(options.curr_dir / output_path);
     }
   }
 
@@ -419,20 +986,29 @@ int wmain(int argc, wchar_t* argv[], wchar_t* envp[]) {
   // Check if EXISTS
   if (!filesystem::exists(input_path)) {
     LOG(1) << "SOURCE path, " << input_path << ", does not exist";
+    report.error = "source_missing";
     return exitcode;      
   }
   
   // Check if its a REGULAR FILE
   if (!filesystem::is_regular_file(input_path)) {
     LOG(1) << "SOURCE, " << input_path.filename() << ", must be a regular file";
+    report.error = "source_not_file";
     return exitcode;
   }
 
   // Check if EXECUTABLE
+#ifdef _WIN32
   DWORD execType =
     SHGetFileInfoW(input_path.c_str(), NULL, NULL, NULL, SHGFI_EXETYPE);
+  bool is_gui_app = HIWORD(execType) != 0;
   if (execType == 0) {
+#else
+  bool is_gui_app = false;
+  if (access(input_path.c_str(), X_OK) != 0) {
+#endif
     LOG(1) << "SOURCE, " << input_path.filename() << ", must be an executable";
+    report.error = "not_executable";
     return exitcode;
   }
 
@@ -441,12 +1017,19 @@ int wmain(int argc, wchar_t* argv[], wchar_t* envp[]) {
   LOG(-3) << input_path;
 
   LOG(3)  << "APPLICATION TYPE: ";
-  if (HIWORD(execType) != 0)
+#ifdef _WIN32
+  if (is_gui_app)
     LOG(-3) << "Windows GUI application";
   else if (LOWORD(execType) == 0x5A4D)
     LOG(-3) << "MS-DOS application";
   else
     LOG(-3) << "Windows Console application (or .bat)";    
+#else
+  if (IsElfFile(input_path))
+    LOG(-3) << "ELF executable";
+  else
+    LOG(-3) << "Executable script";
+#endif
 
 
   
@@ -463,6 +1046,7 @@ int wmain(int argc, wchar_t* argv[], wchar_t* envp[]) {
   if (!filesystem::is_directory(output_path.parent_path())) {
     LOG(1) << "OUTPUT directory, " << output_path.parent_path()
            << ", does not exist";
+    report.error = "output_dir_missing";
     return exitcode;
   }
 
@@ -473,6 +1057,7 @@ int wmain(int argc, wchar_t* argv[], wchar_t* envp[]) {
     if (filesystem::equivalent(output_path, input_path)) {
       LOG(1) << "Cannot overwrite SOURCE.";
       LOG(-1) << "Choose a different filename or directory";
+      report.error = "overwrite_source";
       return exitcode;
     }
 
@@ -480,6 +1065,7 @@ int wmain(int argc, wchar_t* argv[], wchar_t* envp[]) {
     if ((!filesystem::is_regular_file(output_path))) {
       LOG(1) << "OUTPUT already exists but is not a regular file.";
       LOG(-1) << "Choose a different filename or directory";
+      report.error = "output_not_file";
       return exitcode;
     }
 
@@ -492,27 +1078,68 @@ int wmain(int argc, wchar_t* argv[], wchar_t* envp[]) {
   LOG(-3) << output_path;
 
   // Set the Shim Type
-  if (shim_type.empty()) {
-    if (HIWORD(execType) != 0)
-      shim_type = L"GUI";
+  if (options.shim_type.empty()) {
+    if (is_gui_app)
+      options.shim_type = L"GUI";
     else
-      shim_type = L"CONSOLE";
+      options.shim_type = L"CONSOLE";
     LOG(3)  << "SHIM TYPE: ";
-    LOG(-3) << shim_type << " (automatically selected)";
+    LOG(-3) << options.shim_type << " (automatically selected)";
   }
   else {
     LOG(3)  << "SHIM TYPE: ";
-    LOG(-3) << shim_type << " (manually selected)";
+    LOG(-3) << options.shim_type << " (manually selected)";
   }
   
   // ---------- Icon Path ---------- // 
-  if (!icon.empty())
-    LOG(2) << "Specifying alternative icon not implemented, ignoring";
+  // An .ico file or an executable, optionally with the index of its icon
+  // (PATH,INDEX), expanded as SOURCE is
+  vector<IconResource> icons;
+  if (!options.icon.empty()) {
+    wstring          icon_file;
+    int              icon_index = ParseIconLocation(options.icon, icon_file);
+    filesystem::path icon_path  = icon_file;
+    if (icon_path.is_relative())
+      icon_path = filesystem::weakly_canonical(
+        (options.is_shimgen ? output_path.parent_path() : options.curr_dir) / icon_path);
+
+    if (!ReadIconResources(icon_path, icon_index, icons)) {
+      LOG(1) << "Could not read an icon from " << icon_path;
+      report.error = "icon_unreadable";
+      return exitcode;
+    }
+    for (auto& resource : icons)
+      report.metrics.add("read_bytes_total", resource.data.size());
+
+    LOG(3)  << "ICON: ";
+    LOG(-3) << icon_path << ", icon " << icon_index << " ("
+            << icons.size() - 1 << " images)";
+#ifndef _WIN32
+    LOG(2) << "Icons are only embedded in Windows shims";
+#endif
+  }
 
 
   // ---------- Additional Application Commands ---------- // 
-  if (!command_args.empty()) {
-    LOG(3) << "SHIM ARGUMENTS: " << command_args;
+  // @FILE holds them, for those too long for a command line (and @@ is a
+  // literal @)
+  if (options.command_args.rfind(L"@@", 0) == 0)
+    options.command_args.erase(0, 1);
+  else if (options.command_args.rfind(L"@", 0) == 0) {
+    wstring args_file = options.command_args.substr(1);
+    TrimQuotes(args_file);
+    filesystem::path args_path = args_file;
+    if (args_path.is_relative())
+      args_path = options.curr_dir / args_path;
+    if (!ReadResponseFile(args_path, options.command_args)) {
+      LOG(1) << "Could not read the arguments in " << args_path;
+      report.error = "args_unreadable";
+      return exitcode;
+    }
+  }
+
+  if (!options.command_args.empty()) {
+    LOG(3) << "SHIM ARGUMENTS: " << options.command_args;
   }
 
 
@@ -522,27 +1149,141 @@ int wmain(int argc, wchar_t* argv[], wchar_t* envp[]) {
   // ----------------------------------------------------------------------- //
 
   // ---------- Unpack / Create Shim ---------- // 
-  if (!UnpackShim(output_path, shim_type)) {
-    LOG(1) << "Could not unpack shim";
-    return exitcode;
+  // Built in a temporary file next to OUTPUT, which only replaces it once
+  // complete
+  bool existed = filesystem::exists(output_path);
+  AtomicFile output_file;
+  filesystem::path shim_path = output_file.begin(output_path);
+  error_code ec;
+  {
+    auto phase = report.metrics.phase("unpack");
+    if (!UnpackShim(shim_path, options.shim_type)) {
+      LOG(1) << "Could not unpack shim";
+      report.error = "unpack_failed";
+      return exitcode;
+    }
   }
+#ifdef _WIN32
+  report.metrics.add("read_bytes_total",
+                     filesystem::file_size(shim_path, ec));
+#else
+  report.metrics.add("read_bytes_total",
+                     shim_template_end - shim_template_start);
+#endif
   
+#ifdef _WIN32
+  LOG(3) << "Created shim, " << output_path.filename()
+         << ", from SHIM_" << options.shim_type << ".EXE";
+#else
   LOG(3) << "Created shim, " << output_path.filename()
-         << ", from SHIM_" << shim_type << ".EXE";
+         << ", from the ELF template";
+#endif
 
 
   // ---------- Copy and Add Resources ---------- // 
-  CopyResources(output_path, input_path);    
+#ifdef _WIN32
+  {
+    auto phase = report.metrics.phase("copy_resources");
+    CopyResources(shim_path, input_path, options.icon_policy, icons);
+  }
+  report.metrics.add("read_bytes_total",
+                     filesystem::file_size(input_path, ec));
+#endif
+
+  // Add Shim Arguments, all written at once
+  ResourceUpdate update;
+  bool embedded;
+  {
+    auto phase = report.metrics.phase("embed_config");
+#ifdef _WIN32
+    embedded = update.begin(shim_path) &&
+#else
+    // Written out whole at COMMIT, with the configuration
+    embedded = update.begin(ShimTemplate(),
+                            [&](const char* data, size_t size) {
+                              return output_file.write(data, size);
+                            }) &&
+#endif
+      update.add("SHIM_PATH", input_path.wstring()) &&
+      update.add("SHIM_TYPE", options.shim_type);
+    if (embedded && !options.command_args.empty()) 
+      embedded = update.add("SHIM_ARGS", options.command_args);
+    if (embedded && !options.env.empty()) {
+      wstring lines;
+      for (auto& line : options.env)
+        lines += (lines.empty() ? L"" : L"\n") + line;
+      embedded = update.add("SHIM_ENV", lines);
+    }
+    if (embedded && !options.sched.empty())
+      embedded = update.add("SHIM_SCHED", FormatSchedPolicy(options.sched));
+    if (embedded && options.response_file)
+      embedded = update.add("SHIM_RESPONSE", L"1");
+  }
+  ManifestEntry entry;
+  {
+    auto phase = report.metrics.phase("write");
+    embedded = embedded && update.commit();
+
+    // The digest for the manifest, of the shim as written. EndUpdateResource
+    // writes it with no way to see the bytes, so on Windows it is read back
+    // once, still in the cache.
+#ifdef _WIN32
+    if (embedded && !options.manifest_path.empty())
+      HashFile(shim_path, entry.sha256, entry.size);
+#endif
+  }
+  if (!embedded) {
+    LOG(1) << "Could not embed the configuration in " << output_path;
+    report.error = "embed_failed";
+    return exitcode;
+  }
 
-  // Add Shim Arguments
-  AddResourceData(output_path, "SHIM_PATH", input_path);
-  AddResourceData(output_path, "SHIM_TYPE", shim_type);  
-  if (!command_args.empty()) 
-    AddResourceData(output_path, "SHIM_ARGS", command_args);
+  // Replace OUTPUT
+  bool committed;
+  {
+    auto phase = report.metrics.phase("commit");
+    committed = output_file.commit(options.sync);
+  }
+  if (!committed) {
+    LOG(1) << "Could not replace " << output_path;
+    report.error = "commit_failed";
+    return exitcode;
+  }
 
 
   // -------------------------------- Done --------------------------------- // 
-  LOG() << exec_name << " has successfully created " << output_path;
+#ifndef _WIN32
+  // Hashed as it was written
+  entry.sha256 = output_file.digest();
+  entry.size   = output_file.size();
+#endif
+  entry.shim   = output_path.u8string();
+  entry.target = input_path.u8string();
+  if (!options.manifest_path.empty() &&
+      (entry.sha256.empty() || !AddToManifest(options.manifest_path, entry)))
+    LOG(2) << "Could not add the shim to the manifest " << options.manifest_path;
+  else if (!options.manifest_path.empty())
+    LOG(3) << "SHA-256 " << entry.sha256;
+
+  report.result = existed ? "updated" : "created";
+  report.metrics.add("written_bytes_total",
+                     filesystem::file_size(output_path, ec));
+  LOG() << options.exec_name << " has successfully created " << output_path;
   return exitcode;
 }
+
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t* argv[], wchar_t* envp[]) {
+  return ShimExecMain(GetCommandLineW());
+}
+
+#else
+int main(int argc, char* argv[]) {
+  vector<wstring> args;
+  for (int i = 0; i < argc; i++)
+    args.push_back(WidenString(argv[i]));
+  return ShimExecMain(JoinArguments(args));
+}
+#endif
  
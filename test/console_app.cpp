@@ -1,28 +1,59 @@
-#include <windows.h>
 #include <string>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
 #pragma comment(lib, "SHELL32.LIB")
+#endif
 
 using namespace std;
 using namespace filesystem;
 
+#ifdef _WIN32
 path GetExecPath() {
   CHAR cExePath[MAX_PATH];  
   GetModuleFileName(NULL, cExePath, MAX_PATH);
   return path(cExePath);
 }
 
-int main() {
+string GetCommandLineString(int argc, char* argv[]) {
+  return GetCommandLineA();
+}
+
+#else
+path GetExecPath() {
+  return read_symlink("/proc/self/exe");
+}
+
+string GetCommandLineString(int argc, char* argv[]) {
+  string cmd;
+  for (int i = 0; i < argc; i++)
+    cmd += (i ? " " : "") + string(argv[i]);
+  return cmd;
+}
+#endif
+
+int main(int argc, char* argv[]) {
+  // For the launch benchmark: when it started (steady clock, ns) and nothing
+  // else
+  if (argc > 1 && strcmp(argv[1], "--timestamp") == 0) {
+    cout << chrono::steady_clock::now().time_since_epoch().count() << endl;
+    return 0;
+  }
+
   string exec_name      = GetExecPath().stem().string();
   string exec_dir       = GetExecPath().parent_path().string();
 
   cout << "EXE NAME:  '" << exec_name << "'\n";
   cout << "EXE DIR:   '" << exec_dir << "'\n";
   cout << "CUR DIR:   '" << current_path().string() << "'\n\n";
-  cout << "CMD LINE:  '" << GetCommandLineA() << "'\n";
+  cout << "CMD LINE:  '" << GetCommandLineString(argc, argv) << "'\n";
 
+#ifdef _WIN32
   system("pause");
+#endif
   return 0;
 }
-